@@ -8,6 +8,7 @@ namespace Physics {
 	class Object;
 	class Scene;
 	class GizmosRenderer;
+	class ImGuiProfileSink;
 }
 
 class Camera;
@@ -30,6 +31,7 @@ protected:
 	
 	Physics::Scene* m_PhysicsScene;
 	Physics::GizmosRenderer* m_GizmosRenderer;
+	Physics::ImGuiProfileSink* m_ProfileSink;
 
 	void DrawGrid();
 
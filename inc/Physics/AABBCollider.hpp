@@ -11,13 +11,10 @@ namespace Physics {
 		virtual ~AABBCollider();
 
 		//GETTERS
-		inline const glm::vec3& GetCentre() const { return m_Centre; }
+		glm::vec3 GetCentre() const;
 		inline const glm::vec3& GetExtents() const { return m_Extents; }
 
-		virtual void Transform(Object* obj);
-
 	protected:
-		glm::vec3 m_Centre;
 		glm::vec3 m_Extents;
 
 	};
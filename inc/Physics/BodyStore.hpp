@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Collider.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	//One contiguous float array per axis so batches of bodies can be processed a component at a time
+	struct Vec3Array {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		inline glm::vec3 Get(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+		inline void Set(size_t i, const glm::vec3& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+		inline size_t Size() const { return x.size(); }
+
+		void PushBack(const glm::vec3& v);
+		void SwapRemove(size_t i);
+		void Reserve(size_t count);
+		size_t GetCapacityBytes() const;
+	};
+
+	class Object;
+	class SphereCollider;
+	class AABBCollider;
+
+	//Structure of arrays storage for every body attached to a scene. Body i lives at index i of every array,
+	//removal swaps the last body into the hole so the arrays stay dense
+	struct BodyStore {
+
+		enum BodyFlags : uint8_t {
+			BODY_RIGID = 1 << 0,
+			//Part of a resting island. Skipped by integration and solving until something wakes it
+			BODY_SLEEPING = 1 << 1,
+			//Swept for time of impact when it moves far in one step, so it can't pass through thin colliders
+			BODY_CONTINUOUS = 1 << 2
+		};
+
+		//Colliders grouped by type. Each entry records the body it belongs to
+		struct SphereGroup {
+			std::vector<float> radius;
+			std::vector<uint32_t> body;
+		};
+
+		struct AABBGroup {
+			Vec3Array extents;
+			std::vector<uint32_t> body;
+		};
+
+		//Motion state
+		Vec3Array position;
+		Vec3Array velocity;
+		Vec3Array acceleration;
+		Vec3Array maxVelocity;
+		//Position at the start of the last fixed step, for interpolating between steps when rendering
+		Vec3Array previousPosition;
+
+		//Material
+		std::vector<float> mass;
+		std::vector<float> invMass;
+		std::vector<float> friction;
+		std::vector<float> bounciness;
+		std::vector<uint8_t> flags;
+
+		//World space bounds of each body's collider, refreshed by UpdateBounds
+		Vec3Array boundsMin;
+		Vec3Array boundsMax;
+
+		//Contacts each body was part of in the last step, filled by the narrowphase. Held while the body sleeps
+		std::vector<uint32_t> contactCount;
+
+		//Seconds each body has stayed below the sleep velocity, and the island it fell asleep with
+		std::vector<float> sleepTime;
+		std::vector<uint32_t> sleepIsland;
+
+		//Collider lookup, colliderIndex points into the group matching colliderType
+		std::vector<Collider::ColliderType> colliderType;
+		std::vector<uint32_t> colliderIndex;
+
+		SphereGroup spheres;
+		AABBGroup boxes;
+
+		//Handle back to the owning object
+		std::vector<Object*> objects;
+
+		inline size_t Size() const { return objects.size(); }
+
+		//Copies the object's state into the arrays and binds the object to its new index
+		uint32_t Add(Object* obj);
+		//Copies the body's state back into its object, unbinds it and swaps the last body into its place
+		void Remove(uint32_t index);
+		void Reserve(size_t count);
+
+		//Regroups a body's collider after Object::SetCollider
+		void SetCollider(uint32_t index, Collider* coll);
+
+		//Recomputes bounds from positions, one collider group at a time. Bodies without a collider get a point
+		void UpdateBounds();
+		void UpdateBounds(uint32_t index);
+
+		inline bool IsSleeping(uint32_t index) const { return (flags[index] & BODY_SLEEPING) != 0; }
+		//Clears the sleeping flag and restarts the body's sleep timer. Awake bodies keep their timer
+		inline void Wake(uint32_t index) {
+			if((flags[index] & BODY_SLEEPING) == 0)	return;
+			flags[index] &= ~BODY_SLEEPING;
+			sleepTime[index] = 0.0f;
+		}
+
+		//A sleeping body paired with another sleeping or rigid body. Nothing between them can change
+		inline bool IsRestingPair(uint32_t a, uint32_t b) const {
+			const uint8_t resting = BODY_RIGID | BODY_SLEEPING;
+			return ((flags[a] | flags[b]) & BODY_SLEEPING) && (flags[a] & resting) && (flags[b] & resting);
+		}
+
+		//Whether two bodies' bounds overlap, touching counts as overlapping
+		inline bool BoundsOverlap(uint32_t a, uint32_t b) const {
+			return boundsMin.x[a] <= boundsMax.x[b] && boundsMax.x[a] >= boundsMin.x[b] &&
+				   boundsMin.y[a] <= boundsMax.y[b] && boundsMax.y[a] >= boundsMin.y[b] &&
+				   boundsMin.z[a] <= boundsMax.z[b] && boundsMax.z[a] >= boundsMin.z[b];
+		}
+
+		//Bytes of array storage used per body, excluding collider groups and the objects themselves
+		static size_t GetBytesPerBody();
+		//Total bytes currently reserved by all arrays
+		size_t GetMemoryUsage() const;
+
+	protected:
+
+		void AddToGroup(uint32_t index, Collider* coll);
+		void RemoveFromGroup(uint32_t index);
+
+	};
+
+}
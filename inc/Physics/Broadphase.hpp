@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physics {
+
+	struct BodyStore;
+	class JobSystem;
+	class ScratchArena;
+
+	//Two body indices whose bounds may overlap
+	struct BodyPair {
+		uint32_t a;
+		uint32_t b;
+	};
+
+	enum class BroadphaseType {
+		DYNAMIC_TREE,
+		SWEEP_AND_PRUNE,
+		SPATIAL_HASH,
+		OCTREE
+	};
+
+	//Finds candidate pairs for the narrowphase. Bodies are identified by their index in the scene's BodyStore
+	class Broadphase {
+	public:
+		Broadphase() : m_Jobs(nullptr), m_Scratch(nullptr) {}
+		virtual ~Broadphase() {}
+
+		//Called after the body has been added to the store
+		virtual void Insert(const BodyStore& bodies, uint32_t index) = 0;
+		//Called before the body is removed from the store. The store then moves its last body into index
+		virtual void Remove(const BodyStore& bodies, uint32_t index) = 0;
+
+		//Throws away the current structure and builds it over every body in the store at once. Used after bodies are
+		//attached or removed in bulk, in place of an Insert or Remove for each
+		virtual void Build(const BodyStore& bodies) = 0;
+
+		//Brings the structure up to date with the store's bounds and fills pairs with every candidate pair
+		virtual void Update(const BodyStore& bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs) = 0;
+
+		//Threads the broadphase may split its work across, nullptr runs everything on the calling thread
+		inline void SetJobSystem(JobSystem* jobs) { m_Jobs = jobs; }
+		//Per-step memory for temporaries during Update, nullptr falls back to the heap
+		inline void SetScratch(ScratchArena* scratch) { m_Scratch = scratch; }
+
+	protected:
+
+		JobSystem* m_Jobs;
+		ScratchArena* m_Scratch;
+
+	};
+
+}
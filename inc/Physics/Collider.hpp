@@ -5,6 +5,7 @@
 namespace Physics {
 
 	class Object;
+	class BlockPool;
 	class SphereCollider;
 	class AABBCollider;
 	class Collider {
@@ -13,16 +14,23 @@ namespace Physics {
 		enum class ColliderType {
 			NONE,
 			SPHERE,
-			AABB
+			AABB,
+			COUNT
 		};
 
 		Collider(ColliderType type);
 		virtual ~Collider();
+
+		//Destroys a collider however it was made, handing it back to the pool it came from or deleting it
+		static void Destroy(Collider* coll);
 		
 		inline const ColliderType GetType() const { return m_Type; }
 
-		virtual void Transform(Object* obj) {  }
+		//The object this collider is attached to, its position drives the collider's position
+		inline Object* GetOwner() const { return m_Owner; }
+		inline void SetOwner(Object* owner) { m_Owner = owner; }
 
+		//Tests a single pair. The scene batches its pairs through CollisionDispatcher instead
 		bool Intersects(Collider* other, IntersectData* intersection);
 
 		//TODO: Move this into some sort of collision class
@@ -33,8 +41,15 @@ namespace Physics {
 
 	protected:
 
+		friend class Scene;
+
 		ColliderType m_Type;
 
+		Object* m_Owner;
+
+		//Pool the collider was allocated from, nullptr if it was made with new
+		BlockPool* m_Pool;
+
 	};
 
 }
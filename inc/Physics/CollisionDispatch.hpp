@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Collider.hpp"
+#include "Intersect.hpp"
+#include "Broadphase.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	struct BodyStore;
+
+	//A pair of bodies found touching. The collision vector points from a towards b
+	struct Contact {
+		uint32_t a;
+		uint32_t b;
+		IntersectData intersection;
+	};
+
+	//Tests count pairs that all have the same collider types, appending a contact for each pair that intersects.
+	//Pairs are ordered so body a has the first type the kernel was registered for and body b the second
+	typedef void(*CollisionKernel)(const BodyStore& bodies, const BodyPair* pairs, uint32_t count, std::vector<Contact>& contacts);
+
+	//Table of collision kernels indexed by the collider types of a pair. Candidate pairs are bucketed by type pair
+	//and each bucket is handed to its kernel in one call, so there is no per-pair branching or virtual call
+	class CollisionDispatcher {
+	public:
+		static const uint32_t TYPE_COUNT = (uint32_t)Collider::ColliderType::COUNT;
+
+		//Starts with the built in sphere and AABB kernels registered
+		CollisionDispatcher();
+		~CollisionDispatcher();
+
+		//Sets the kernel for pairs of typeA and typeB, replacing any earlier one. Pairs arriving as typeB, typeA are
+		//swapped before reaching it, so one registration covers both orders unless the reverse has its own kernel
+		void Register(Collider::ColliderType typeA, Collider::ColliderType typeB, CollisionKernel kernel);
+		//Pairs of these types are skipped until a kernel is registered again
+		void Unregister(Collider::ColliderType typeA, Collider::ColliderType typeB);
+
+		inline CollisionKernel GetKernel(Collider::ColliderType typeA, Collider::ColliderType typeB) const {
+			return m_Kernels[(uint32_t)typeA][(uint32_t)typeB];
+		}
+
+		//Groups pairs by kernel, swapping each pair into the order its kernel expects. Pairs with no kernel are
+		//dropped, as are pairs of a sleeping body and another sleeping or rigid body. Bucketing is stable, so
+		//within a bucket pairs keep the order they came in
+		void Sort(const BodyStore& bodies, const std::vector<BodyPair>& pairs);
+
+		//Runs the kernels over sorted pairs [begin, end), splitting the range where buckets change
+		void Run(const BodyStore& bodies, uint32_t begin, uint32_t end, std::vector<Contact>& contacts) const;
+
+		//Pairs kept by the last Sort
+		inline uint32_t GetSortedCount() const { return (uint32_t)m_Sorted.size(); }
+
+	protected:
+
+		//Where a pair of types goes: the bucket and whether the pair is swapped on the way in
+		struct Route {
+			uint32_t bucket;
+			bool swap;
+		};
+
+		void BuildRoutes();
+
+		CollisionKernel m_Kernels[TYPE_COUNT][TYPE_COUNT];
+		//Bucket TYPE_COUNT * TYPE_COUNT is for pairs that have no kernel
+		Route m_Routes[TYPE_COUNT][TYPE_COUNT];
+
+		//Sorted pairs, with m_BucketStart holding the first sorted pair of each bucket plus the end
+		std::vector<BodyPair> m_Sorted;
+		std::vector<uint32_t> m_BucketStart;
+		//Bucket of every incoming pair, reused between the count and scatter passes
+		std::vector<uint8_t> m_PairBucket;
+
+	};
+
+	//Built in kernels, registered by the dispatcher's constructor
+	void SphereSphereKernel(const BodyStore& bodies, const BodyPair* pairs, uint32_t count, std::vector<Contact>& contacts);
+	void SphereAABBKernel(const BodyStore& bodies, const BodyPair* pairs, uint32_t count, std::vector<Contact>& contacts);
+	void AABBAABBKernel(const BodyStore& bodies, const BodyPair* pairs, uint32_t count, std::vector<Contact>& contacts);
+
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "SlotMap.hpp"
+#include "CollisionDispatch.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	struct BodyStore;
+	class CollisionEvents;
+
+	//A pair of objects starting, staying in or ending contact over a fixed step
+	struct CollisionEvent {
+		//a has the lower slot, so a pair always comes out the same way round. For an end event either may have been
+		//removed since, check with Scene::FindObject before using them
+		Handle a;
+		Handle b;
+		//Unit normal from a towards b, from the last substep the pair touched in
+		glm::vec3 normal;
+		//Impulse the solver applied along the normal over the step. End events carry the pair's last step
+		float impulse;
+	};
+
+	//Handed each fixed step's events once the step has finished
+	class CollisionListener {
+	public:
+		virtual ~CollisionListener() {}
+
+		virtual void OnCollisionEvents(const CollisionEvents& events) = 0;
+
+	};
+
+	//Diffs each fixed step's contacts against the step before's, by object handle, into begin, stay and end events.
+	//Contacts from every substep count, so a pair touching in any of them is in contact for the step. Pairs that
+	//stop being tested because both bodies went to sleep are kept quietly, so sleeping piles don't end their contacts
+	//and begin them again on waking.
+	//Events are kept in arrays reused from step to step and sorted by pair, so once they've grown to fit nothing is
+	//allocated. They last until the next fixed step; after a Step that ran several, only the last one's are left to
+	//read, so use a listener to see every one. Off until enabled, then costs a copy of every contact per substep and
+	//a sort per step
+	class CollisionEvents {
+	public:
+		CollisionEvents();
+		~CollisionEvents();
+
+		//Adds a substep's contacts, with the impulse the solver applied to each
+		void AddContacts(const SlotMap& slots, const std::vector<Contact>& contacts, const std::vector<float>& impulses);
+		//Works out the step's events and hands them to the listeners
+		void EndStep(const SlotMap& slots, const BodyStore& bodies);
+		//Forgets every pair and event, so the next step begins every contact again
+		void Clear();
+
+		//Listeners are called in the order they were added. They must outlive the scene or be removed first
+		void AddListener(CollisionListener* listener);
+		void RemoveListener(CollisionListener* listener);
+
+		//Getters
+		inline bool IsEnabled() const { return m_Enabled; }
+		inline const std::vector<CollisionEvent>& GetBegins() const { return m_Begins; }
+		inline const std::vector<CollisionEvent>& GetStays() const { return m_Stays; }
+		inline const std::vector<CollisionEvent>& GetEnds() const { return m_Ends; }
+
+		//Setters
+		//Turning events off clears them, and turning them back on begins every contact again
+		void SetEnabled(bool enabled);
+
+	protected:
+
+		//A contact as it was collected, or a pair in contact over a step
+		struct Record {
+			//Slot and generation of each handle packed together, a's slot the lower
+			uint64_t keyA;
+			uint64_t keyB;
+			//Order the contact was collected in, so later substeps win ties after sorting
+			uint32_t order;
+			glm::vec3 normal;
+			float impulse;
+		};
+
+		static inline bool SamePair(const Record& x, const Record& y) { return x.keyA == y.keyA && x.keyB == y.keyB; }
+		static inline bool PairLess(const Record& x, const Record& y) {
+			return (x.keyA != y.keyA) ? x.keyA < y.keyA : x.keyB < y.keyB;
+		}
+		static inline bool CollectedLess(const Record& x, const Record& y) {
+			return SamePair(x, y) ? x.order < y.order : PairLess(x, y);
+		}
+
+		static CollisionEvent MakeEvent(const Record& record);
+
+		bool m_Enabled;
+
+		//Contacts collected this step, then the step's pairs once sorted and merged
+		std::vector<Record> m_Current;
+		//Pairs in contact last step, sorted
+		std::vector<Record> m_Previous;
+		//The step's pairs, built from both, becoming m_Previous
+		std::vector<Record> m_Next;
+
+		std::vector<CollisionEvent> m_Begins;
+		std::vector<CollisionEvent> m_Stays;
+		std::vector<CollisionEvent> m_Ends;
+
+		std::vector<CollisionListener*> m_Listeners;
+
+	};
+
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "SlotMap.hpp"
+
 namespace Physics {
 
 	class Object;
+	class Scene;
 	class Constraint {
 	public:
 
@@ -19,8 +22,17 @@ namespace Physics {
 		inline const void GetConnections(Object** objA, Object** objB) const { *objA = m_ObjA; *objB = m_ObjB; }
 		inline ConstraintType GetType() { return m_Type; }
 
+		//Scene the constraint is attached to, nullptr if none, and its handle there
+		inline Scene* GetScene() const { return m_Scene; }
+		inline Handle GetHandle() const { return m_Handle; }
+
 	protected:
 
+		friend class Scene;
+
+		Scene* m_Scene;
+		Handle m_Handle;
+
 		Object* m_ObjA;
 		Object* m_ObjB;
 
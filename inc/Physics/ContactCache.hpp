@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Intersect.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	//Contacts that carry over from one step to the next, keyed by body pair. Each entry keeps the impulse the solver
+	//built up on it, so next step's solve can start from there instead of from zero, and the geometry it was
+	//generated from, so a pair that has barely moved can reuse it instead of running the narrowphase again.
+	//Stored in an open addressing table on packed body indices with linear probing. Keys sit in their own array
+	//so probing doesn't drag the rest of each entry through the cache. Each body keeps a list of the bodies it has
+	//entries with, so removing one only visits its own entries
+	class ContactCache {
+	public:
+
+		struct Entry {
+			//Bodies in the order the contact was generated, the collision vector points from a to b
+			uint32_t a;
+			uint32_t b;
+			//Position of b relative to a when the contact was generated
+			glm::vec3 relPosition;
+			IntersectData intersection;
+			//Impulse the solver applied along the normal, summed over its iterations
+			float normalImpulse;
+			//Step the pair was last in contact
+			uint32_t step;
+		};
+
+		static const size_t NOT_FOUND = ~(size_t)0;
+
+		ContactCache();
+		~ContactCache();
+
+		//Starts a new step. Entries not touched since the last step are stale and get cleared out in batches
+		void BeginStep();
+		void EndStep();
+
+		//Slot holding a pair in either order, NOT_FOUND if the pair isn't cached
+		size_t Find(uint32_t a, uint32_t b) const;
+		//Starts loading the pair's home slot, so a Find or Touch a few pairs later doesn't wait on memory
+		void Prefetch(uint32_t a, uint32_t b) const;
+		inline const Entry& GetEntry(size_t slot) const { return m_Entries[slot]; }
+
+		//Whether the pair in slot was in contact last step and b has moved less than the reuse tolerance relative to a
+		//since the contact was generated
+		bool CanReuse(size_t slot, const glm::vec3& relPosition) const;
+
+		//Makes room for count more entries without the table growing
+		void Reserve(size_t count);
+
+		//Records that a pair is in contact this step and returns its slot. The impulse is kept if the pair was in
+		//contact last step and reset otherwise. The geometry is only replaced when the narrowphase regenerated the
+		//contact, so a reused one keeps measuring drift from where it was generated. Slots stay put until the next
+		//EndStep or RemoveBody, or until a Touch has to grow the table, which Reserve avoids
+		size_t Touch(uint32_t a, uint32_t b, const glm::vec3& relPosition, const IntersectData& intersection, bool regenerated);
+		inline void SetImpulse(size_t slot, float normalImpulse) { m_Entries[slot].normalImpulse = normalImpulse; }
+
+		//Drops every entry containing index, then renames entries containing from to index. Costs the entries of the two
+		//bodies, not of the whole table
+		void RemoveBody(uint32_t index, uint32_t from);
+		void Clear();
+
+		//Entries in the table, stale ones included
+		inline size_t Size() const { return m_Count; }
+
+		//Relative movement under which a contact is reused rather than regenerated, 0 always regenerates
+		inline float GetReuseTolerance() const { return m_ReuseTolerance; }
+		inline void SetReuseTolerance(float tolerance) { m_ReuseTolerance = tolerance; }
+
+	protected:
+
+		static const uint64_t EMPTY = ~0ull;
+
+		size_t FindSlot(uint64_t key) const;
+		//Reinserts every entry from this step and the last into a table of capacity slots
+		void Rebuild(size_t capacity);
+		//Empties a slot, shifting back later entries in its probe run. Leaves the partner lists to the caller
+		void EraseSlot(size_t slot);
+		//Puts an entry whose pair isn't in the table yet into its slot
+		void InsertEntry(const Entry& entry);
+
+		void AddPartner(uint32_t body, uint32_t partner);
+		void DropPartner(uint32_t body, uint32_t partner);
+
+		//Packed pair from PairSet::MakeKey per slot, EMPTY for a free slot
+		std::vector<uint64_t> m_Keys;
+		std::vector<Entry> m_Entries;
+		size_t m_Count;
+		//Entries touched this step
+		size_t m_Live;
+
+		uint32_t m_Step;
+		float m_ReuseTolerance;
+
+		std::vector<Entry> m_Scratch;
+
+		//Other body of every entry, indexed by body. Unordered, a partner is swapped out with the list's last on erase
+		std::vector<std::vector<uint32_t>> m_Partners;
+
+	};
+
+}
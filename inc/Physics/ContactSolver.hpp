@@ -0,0 +1,106 @@
+#pragma once
+
+#include "CollisionDispatch.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	struct BodyStore;
+	class JobSystem;
+
+	enum class PenetrationRecovery {
+		//Feeds penetration back into the velocity solve as extra separating speed. Cheap, but the push out
+		//stays in the velocity and shows up as bouncing in deep piles
+		BAUMGARTE,
+		//Solves the push out on a separate velocity that moves positions and is then thrown away
+		SPLIT_IMPULSE
+	};
+
+	struct ContactSolverSettings {
+		float timeStep = 1.0f / 60.0f;
+		uint32_t velocityIterations = 8;
+		//Iterations of the split impulse solve, unused by Baumgarte recovery
+		uint32_t positionIterations = 3;
+		PenetrationRecovery recovery = PenetrationRecovery::SPLIT_IMPULSE;
+		//Fraction of the penetration removed each step
+		float baumgarte = 0.2f;
+		//Penetration left alone so touching contacts stay touching instead of jittering apart
+		float slop = 0.01f;
+		//Approach speed under which contacts don't bounce, so resting bodies settle
+		float restitutionThreshold = 1.0f;
+		//Scale on last step's impulse when a contact starts, 0 starts every contact from nothing
+		float warmStartFactor = 0.8f;
+		//Contacts per parallel batch within a colour
+		uint32_t batchSize = 256;
+	};
+
+	//Sequential impulse solver for the contacts of a step. Each contact's impulse along its normal is accumulated
+	//over the iterations and clamped so the sum never pulls the bodies together, rather than clamping each
+	//iteration's change, which lets later iterations take back what earlier ones overshot.
+	//Contacts are coloured so no two contacts of a colour share a dynamic body, then each colour is solved as
+	//parallel batches with no locking. Colours run one after another, so a body touched by several contacts
+	//still sees each one in turn, and the result doesn't depend on the thread count.
+	//Rigid and sleeping bodies have infinite mass here and are never written to
+	class ContactSolver {
+	public:
+		ContactSolver();
+		~ContactSolver();
+
+		//Solves contacts, updating body velocities and positions. impulses holds an impulse per contact: on the way
+		//in, last step's impulse to warm start from, and on the way out, the impulse the solve ended with
+		void Solve(BodyStore& bodies, const std::vector<Contact>& contacts, std::vector<float>& impulses,
+				   const ContactSolverSettings& settings, JobSystem* jobs);
+
+		//Colours the last solve needed, the overflow batch included
+		inline uint32_t GetColourCount() const { return (uint32_t)m_ColourStart.size() - 1; }
+
+	protected:
+
+		//A contact's constant data for the step, gathered once so iterations touch only this and the velocities
+		struct SolverContact {
+			uint32_t a;
+			uint32_t b;
+			glm::vec3 normal;
+			float invMassA;
+			float invMassB;
+			//1 / (invMassA + invMassB)
+			float normalMass;
+			//Separating speed the velocity solve aims for, from restitution and Baumgarte recovery
+			float velocityBias;
+			//Separating speed the split impulse solve aims for
+			float positionBias;
+			float impulse;
+			float positionImpulse;
+		};
+
+		//Colours the contacts and builds the sorted solver contacts from them
+		void Prepare(const BodyStore& bodies, const std::vector<Contact>& contacts, const std::vector<float>& impulses,
+					 const ContactSolverSettings& settings);
+
+		void WarmStart(BodyStore& bodies, uint32_t begin, uint32_t end);
+		void SolveVelocity(BodyStore& bodies, uint32_t begin, uint32_t end);
+		void SolvePosition(uint32_t begin, uint32_t end);
+
+		//Runs func over every colour in turn, each colour's contacts split into parallel batches
+		template<typename Func>
+		void ForEachColour(JobSystem* jobs, uint32_t batchSize, const Func& func);
+
+		//Contacts sorted by colour, with m_ColourStart holding the first of each colour plus the end.
+		//The last colour is the overflow, contacts that found no free colour, and is solved on one thread
+		std::vector<SolverContact> m_Contacts;
+		//Index into the incoming contacts of each sorted contact
+		std::vector<uint32_t> m_Order;
+		std::vector<uint32_t> m_ColourStart;
+		std::vector<uint32_t> m_ContactColour;
+		//Bit per colour already used by each body's contacts
+		std::vector<uint64_t> m_BodyColours;
+
+		//Split impulse velocity of each body, applied to positions at the end and never kept
+		std::vector<glm::vec3> m_PseudoVelocity;
+
+	};
+
+}
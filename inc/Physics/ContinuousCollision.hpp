@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Broadphase.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	struct BodyStore;
+
+	//Time along a sweep, 0 to 1, at which a sphere moving by motion from start first touches a sphere of otherRadius
+	//at otherCentre. Returns a value above 1 if it never does, and 0 if they already overlap at the start
+	float SweepSphereSphere(const glm::vec3& start, const glm::vec3& motion, float radius, const glm::vec3& otherCentre, float otherRadius);
+	//Time along a sweep at which a sphere first touches a box, found as a ray against the box grown by the radius.
+	//Corners are treated as square, so the hit can come slightly early near them
+	float SweepSphereAABB(const glm::vec3& start, const glm::vec3& motion, float radius, const glm::vec3& centre, const glm::vec3& extents);
+
+	//Continuous collision for bodies flagged BODY_CONTINUOUS. Each step, a flagged sphere that moved further than its
+	//radius has its bounds stretched over its whole path so the broadphase pairs it with everything it passed.
+	//Those pairs are swept and the body is moved back to its earliest time of impact, just far enough in for the
+	//narrowphase to see the contact. It loses the rest of its motion for that step instead of coming out the other
+	//side. Work after the initial flag scan is proportional to the fast bodies and their candidate pairs
+	class ContinuousCollision {
+	public:
+		ContinuousCollision();
+		~ContinuousCollision();
+
+		//Records where flagged bodies start. Call before integrating
+		void BeginStep(const BodyStore& bodies);
+		//Finds the fast bodies and stretches their bounds over their path. Call after bounds are updated and before
+		//the broadphase
+		void SweepBounds(BodyStore& bodies, std::vector<uint8_t>& movedMask);
+		//Moves every fast body back to its first time of impact among pairs. Call after the broadphase
+		void Resolve(BodyStore& bodies, const std::vector<BodyPair>& pairs);
+
+		//Getters
+		inline bool GetEnabled() const { return m_Enabled; }
+		inline float GetPenetration() const { return m_Penetration; }
+		//Flagged bodies that moved far enough to be swept last step
+		inline uint32_t GetFastBodyCount() const { return (uint32_t)m_FastBodies.size(); }
+		//Fast bodies that hit something and were moved back last step
+		inline uint32_t GetImpactCount() const { return m_Impacts; }
+
+		//Setters
+		inline void SetEnabled(bool enabled) { m_Enabled = enabled; }
+		//How far a body is left inside what it hit, so the contact is found. Keep it above the solver's slop
+		inline void SetPenetration(float penetration) { m_Penetration = penetration; }
+
+	protected:
+
+		struct Sweep {
+			uint32_t body;
+			glm::vec3 start;
+			glm::vec3 motion;
+			float radius;
+			//Earliest time of impact found so far, above 1 for none
+			float toi;
+		};
+
+		bool m_Enabled;
+		float m_Penetration;
+
+		//Flagged bodies and their start positions, then the ones that turned out fast
+		std::vector<uint32_t> m_Tracked;
+		std::vector<glm::vec3> m_TrackedStart;
+		std::vector<Sweep> m_FastBodies;
+		//Sweep index of every body, ~0 for bodies that aren't fast. Sized to the store, reset only where set
+		std::vector<uint32_t> m_SweepIndex;
+
+		uint32_t m_Impacts;
+
+	};
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_X86 1
+#else
+#define PHYSICS_X86 0
+#endif
+
+//GCC and Clang only emit instructions beyond the build's baseline inside functions that opt in, MSVC allows them anywhere
+#if PHYSICS_X86 && (defined(__GNUC__) || defined(__clang__))
+#define PHYSICS_TARGET_SSE2 __attribute__((target("sse2")))
+#define PHYSICS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PHYSICS_TARGET_SSE2
+#define PHYSICS_TARGET_AVX2
+#endif
+
+namespace Physics {
+
+	enum class SimdLevel {
+		SCALAR,
+		SSE,
+		AVX2
+	};
+
+	//Highest instruction set the CPU and OS support, detected once on first call
+	SimdLevel GetSupportedSimdLevel();
+
+	const char* GetSimdLevelName(SimdLevel level);
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Broadphase.hpp"
+#include "PairSet.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	//Bounding volume hierarchy over fat bounds. Each leaf holds its body's bounds grown by a margin, so a body only
+	//touches the tree once it leaves its fat bounds. Nodes live in one pool and refer to each other by index, the
+	//tree is kept balanced with rotations as leaves are inserted and removed
+	class DynamicAABBTree : public Broadphase {
+	public:
+		DynamicAABBTree();
+		virtual ~DynamicAABBTree();
+
+		virtual void Insert(const BodyStore& bodies, uint32_t index);
+		virtual void Remove(const BodyStore& bodies, uint32_t index);
+		//Builds the tree top down, splitting leaves at the median along the widest axis of their centres. Faster
+		//than inserting leaves one at a time and gives a better tree, since no insert order is involved
+		virtual void Build(const BodyStore& bodies);
+
+		//Moves leaves whose body left its fat bounds, queries the tree with only those leaves and keeps a persistent
+		//set of fat overlaps. Pairs whose actual bounds overlap are reported
+		virtual void Update(const BodyStore& bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs);
+
+		//Appends every body whose fat bounds overlap the box
+		void QueryOverlap(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& results) const;
+		//Closest body whose bounds the ray hits within maxDistance, or -1. direction does not need to be normalised,
+		//distance is measured in multiples of it
+		int32_t RayCast(const BodyStore& bodies, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& hitDistance) const;
+
+		inline size_t GetNodeCount() const { return m_Nodes.size() - m_FreeCount; }
+		int32_t GetHeight() const;
+
+		//How far leaf bounds are grown past the body's bounds
+		inline float GetMargin() const { return m_Margin; }
+		inline void SetMargin(float margin) { m_Margin = margin; }
+
+	protected:
+
+		static const int32_t NULL_NODE = -1;
+
+		struct Node {
+			float min[3];
+			float max[3];
+
+			//Parent while in the tree, next free node while in the free list
+			int32_t parent;
+			int32_t child1;
+			int32_t child2;
+			//Leaves are 0, free nodes -1
+			int32_t height;
+
+			uint32_t body;
+			//Whether the leaf still needs querying. Cleared when the node is freed, so entries in m_MovedLeaves without
+			//it are skipped
+			bool moved;
+
+			inline bool IsLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		int32_t AllocateNode();
+		void FreeNode(int32_t node);
+
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		//Builds a subtree over leaves and returns its root
+		int32_t BuildRange(int32_t* leaves, uint32_t count);
+		//Rotates the subtree at node if its children's heights differ by more than one. Returns the new subtree root
+		int32_t Balance(int32_t node);
+		//Walks from node to the root refitting bounds and heights, balancing on the way
+		void Refit(int32_t node);
+
+		//Sets a leaf's fat bounds from its body's bounds grown by the margin
+		void SetFatBounds(const BodyStore& bodies, int32_t leaf);
+
+		void MarkMoved(int32_t leaf);
+		//Adds a pair for every leaf whose fat bounds overlap this one's
+		void QueryPairs(int32_t leaf);
+
+		static inline float Area(const Node& node);
+
+		std::vector<Node> m_Nodes;
+		int32_t m_Root;
+		int32_t m_FreeList;
+		size_t m_FreeCount;
+
+		//Leaf node of each body, indexed by body
+		std::vector<int32_t> m_BodyLeaves;
+		//Leaves inserted or moved since the last update, along with any removed since. A node freed and reused as a
+		//moved leaf can be in twice
+		std::vector<int32_t> m_MovedLeaves;
+
+		PairSet m_Pairs;
+		std::vector<BodyPair> m_PairScratch;
+		//Traversal stack, mutable so the const queries can reuse it
+		mutable std::vector<int32_t> m_Stack;
+
+		float m_Margin;
+
+	};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	struct BodyStore;
+	class JobSystem;
+
+	struct IntegratorSettings {
+		glm::vec3 gravity = glm::vec3(0);
+		//Force applied to every body this step, scaled by each body's inverse mass
+		glm::vec3 globalForce = glm::vec3(0);
+		float timeStep = 1.0f / 60.0f;
+		//Bodies below this height are pushed back up and have their vertical velocity reflected
+		float groundHeight = 0.5f;
+		//A body counts as moved when any axis changes by more than this
+		float moveThreshold = 0.1f;
+		//Bodies per batch when integrating across threads. Rounded up to a multiple of 8 so batch boundaries never
+		//change which bodies take the SIMD path
+		uint32_t batchSize = 4096;
+	};
+
+	//Semi-implicit Euler over every dynamic body in a BodyStore at once. Applies gravity, the global force
+	//and friction damping, clamps to each body's max velocity, integrates and clears accumulated acceleration.
+	//Rigid and sleeping bodies are left untouched
+	class Integrator {
+	public:
+		Integrator();
+		virtual ~Integrator();
+
+		//Integrates all bodies and fills movedMask with 1 for every body that moved past the threshold. Bodies are
+		//independent, so batches are split across jobs when given
+		void Integrate(BodyStore& bodies, const IntegratorSettings& settings, std::vector<uint8_t>& movedMask, JobSystem* jobs = nullptr);
+
+		inline SimdLevel GetSimdLevel() const { return m_SimdLevel; }
+		//Forces a code path, clamped to what the CPU supports
+		void SetSimdLevel(SimdLevel level);
+
+	protected:
+
+		SimdLevel m_SimdLevel;
+
+	};
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Broadphase.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	struct BodyStore;
+
+	//Groups bodies into islands, sets of dynamic bodies joined by contacts or constraints, and puts whole islands
+	//to sleep once every body in them has been slow for long enough. Rigid bodies never join an island, so a pile
+	//resting on a wall doesn't get linked to everything else touching that wall.
+	//An island is woken as a whole when any of its bodies is woken or touched by an awake body
+	class IslandManager {
+	public:
+		IslandManager();
+		~IslandManager();
+
+		//Builds this step's islands from edges, each joining two bodies, and updates sleeping. Call after solving
+		void Update(BodyStore& bodies, const std::vector<BodyPair>& edges, float timeStep);
+
+		//Wakes every body in the store
+		void WakeAll(BodyStore& bodies);
+		//Wakes a body along with the rest of the island it fell asleep with
+		void WakeIsland(BodyStore& bodies, uint32_t body);
+		//Wakes the islands of every body in the list with one pass over the store
+		void WakeIslands(BodyStore& bodies, const uint32_t* bodyIndices, size_t count);
+
+		//Getters
+		inline bool GetSleepEnabled() const { return m_SleepEnabled; }
+		inline float GetSleepVelocity() const { return m_SleepVelocity; }
+		inline float GetSleepTime() const { return m_SleepTime; }
+		//Islands of awake bodies found by the last update
+		inline uint32_t GetAwakeIslandCount() const { return m_AwakeIslands; }
+		//Bodies asleep after the last update
+		inline uint32_t GetSleepingCount() const { return m_SleepingBodies; }
+
+		//Setters
+		//Disabling sleep wakes everything on the next update
+		inline void SetSleepEnabled(bool enabled) { m_SleepEnabled = enabled; }
+		//Speed a body has to stay below to count towards sleeping
+		inline void SetSleepVelocity(float velocity) { m_SleepVelocity = velocity; }
+		//Seconds every body in an island has to stay slow before the island sleeps
+		inline void SetSleepTime(float time) { m_SleepTime = time; }
+
+	protected:
+
+		uint32_t Find(uint32_t body);
+		void Union(uint32_t a, uint32_t b);
+
+		bool m_SleepEnabled;
+		float m_SleepVelocity;
+		float m_SleepTime;
+
+		//Union-find forest over body indices
+		std::vector<uint32_t> m_Parent;
+
+		//Per island root: shortest sleep time of its bodies, whether any body is awake and the id it sleeps with
+		std::vector<float> m_IslandSleepTime;
+		std::vector<uint8_t> m_IslandAwake;
+		std::vector<uint32_t> m_IslandId;
+
+		//Sleeping islands touched by an awake island this update
+		std::vector<uint32_t> m_WakeIslands;
+
+		//Ids handed to islands as they fall asleep, 0 is never used
+		uint32_t m_NextIslandId;
+
+		uint32_t m_AwakeIslands;
+		uint32_t m_SleepingBodies;
+
+	};
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace Physics {
+
+	//Tasks joined by dependencies, run with JobSystem::Run. A task starts once every task it depends on has finished,
+	//and tasks with no path between them may run at the same time on different threads. Build it once and run it as
+	//often as needed
+	class TaskGraph {
+	public:
+		typedef uint32_t TaskId;
+		//Called with the index of the thread running the task
+		typedef std::function<void(uint32_t thread)> TaskFunc;
+
+		TaskGraph();
+		~TaskGraph();
+
+		TaskId AddTask(const char* name, const TaskFunc& func);
+		//after won't start until before has finished. before has to have been added first, so the graph can't loop
+		void AddDependency(TaskId before, TaskId after);
+		void Clear();
+
+		inline size_t Size() const { return m_Tasks.size(); }
+		inline const char* GetName(TaskId task) const { return m_Tasks[task].name; }
+
+	protected:
+
+		friend class JobSystem;
+
+		struct Task {
+			const char* name;
+			TaskFunc func;
+			std::vector<TaskId> successors;
+			uint32_t dependencies;
+		};
+
+		//Resets the per-run counters
+		void Prepare();
+
+		std::vector<Task> m_Tasks;
+
+		//Dependencies each task is still waiting on, and tasks not yet finished, during a run
+		std::unique_ptr<std::atomic<uint32_t>[]> m_Waiting;
+		size_t m_WaitingSize;
+		std::atomic<uint32_t> m_Unfinished;
+
+	};
+
+	//Work stealing pool of worker threads. Every thread has its own queue of jobs, taking the newest from its own and
+	//stealing the oldest from the others when it runs dry. A thread waiting on a loop or graph keeps running jobs
+	//instead of blocking, so loops can be started from inside other loops and tasks. The calling thread is thread 0
+	//and works alongside the pool, so a system with no workers runs everything inline
+	class JobSystem {
+	public:
+		//Called with a range of the loop and the index of the thread running it, which is below GetThreadCount()
+		typedef std::function<void(uint32_t begin, uint32_t end, uint32_t thread)> RangeFunc;
+
+		//0 uses one thread per hardware thread, including the caller
+		explicit JobSystem(uint32_t threadCount = 0);
+		virtual ~JobSystem();
+
+		//Runs func over [0, count) in batches of batchSize and returns once every batch has finished.
+		//Each call of func covers exactly one batch, so begin / batchSize identifies it
+		void ParallelFor(uint32_t count, uint32_t batchSize, const RangeFunc& func);
+		//Runs every task in the graph and returns once they have all finished
+		void Run(TaskGraph& graph);
+
+		//Runs every batch on the calling thread, in order
+		static void RunInline(uint32_t count, uint32_t batchSize, const RangeFunc& func);
+		//Runs every task on the calling thread, in order of when they became ready and then of when they were added
+		static void RunInline(TaskGraph& graph);
+
+		//Threads that can run a batch, the caller included
+		inline uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size() + 1; }
+		inline bool GetSingleThreaded() const { return m_SingleThreaded; }
+
+		//Runs everything inline on the calling thread. Batches and tasks keep their boundaries, so anything that
+		//doesn't depend on which thread ran it comes out bit for bit the same as a threaded run, in a debuggable order
+		inline void SetSingleThreaded(bool singleThreaded) { m_SingleThreaded = singleThreaded; }
+
+	protected:
+
+		struct Job {
+			void(*run)(void* data, uint32_t index, uint32_t thread);
+			void* data;
+			uint32_t index;
+		};
+
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		static void RunLoopBatches(void* data, uint32_t index, uint32_t thread);
+		static void RunGraphTask(void* data, uint32_t index, uint32_t thread);
+
+		void Push(uint32_t thread, const Job& job);
+		//Newest job from the thread's own queue, or the oldest from another's
+		bool Pop(uint32_t thread, Job& job);
+		//Runs queued jobs until counter reaches zero
+		void HelpUntilZero(const std::atomic<uint32_t>& counter, uint32_t thread);
+		void WakeWorkers();
+
+		void WorkerLoop(uint32_t thread);
+		//Index of the calling thread, 0 for any thread that isn't one of the workers
+		uint32_t GetCurrentThread() const;
+
+		std::vector<std::thread> m_Workers;
+		std::unique_ptr<Queue[]> m_Queues;
+
+		//Serialises loops and graphs started from outside the pool, they all share thread 0's queue
+		std::recursive_mutex m_CallMutex;
+
+		//Workers sleep here while every queue is empty
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+		std::atomic<uint32_t> m_Queued;
+		std::atomic<bool> m_Quit;
+
+		bool m_SingleThreaded;
+
+	};
+
+	//ParallelFor on jobs, or every batch inline when there is no job system
+	inline void ParallelFor(JobSystem* jobs, uint32_t count, uint32_t batchSize, const JobSystem::RangeFunc& func) {
+		if(jobs != nullptr)
+			jobs->ParallelFor(count, batchSize, func);
+		else
+			JobSystem::RunInline(count, batchSize, func);
+	}
+
+}
@@ -1,59 +1,80 @@
 #pragma once
 
+#include "Broadphase.hpp"
+
 #include <vector>
-#include <glm/vec3.hpp>
+#include <cstdint>
 
 namespace Physics {
 
-	class Object;
-	class OctTree {
+	//Linear octree rebuilt from scratch every update. Bodies are keyed by the Morton code of their centre within
+	//the scene's bounds and radix sorted, which puts every octree cell's bodies in one contiguous run of the sorted
+	//order. Nodes are emitted from those runs into a flat array, so the tree holds no pointers and no state carries
+	//over between updates
+	class OctTree : public Broadphase {
 	public:
-
 		OctTree();
-		OctTree(const glm::vec3& regionMin, const glm::vec3& regionMax);
-		OctTree(const glm::vec3& regionMin, const glm::vec3& regionMax, const std::vector<Object*>& objects);
 		virtual ~OctTree();
 
-		void Update();
-		void Insert(Object* obj);
-
-	protected:
-
-		void BuildTree();
-		void UpdateTree();
-		void DoInsert(Object* obj);
-		void FindEnclosingCube();
-		bool Contains(Object* obj, const glm::vec3& minRegion, const glm::vec3& maxRegion);
-
-		OctTree* CreateNode(const glm::vec3& regionMin, const glm::vec3& regionMax, std::vector<Object*>& objs);
-		OctTree* CreateNode(const glm::vec3& regionMin, const glm::vec3& regionMax, Object* obj);
-
-		void DetectCollisions(std::vector<Object*>* parentObjs = nullptr);
-
-		OctTree* m_parent;
-		std::vector<OctTree*> m_children;
+		//The tree is rebuilt every update so there is nothing to do on insert or remove
+		virtual void Insert(const BodyStore& bodies, uint32_t index) {}
+		virtual void Remove(const BodyStore& bodies, uint32_t index) {}
+		virtual void Build(const BodyStore& bodies) {}
 
-		//Bitmask for tracking child nodes
-		unsigned char m_activeNodes = 0;
+		virtual void Update(const BodyStore& bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs);
 
-		const int MIN_SIZE = 1;
+		inline size_t GetNodeCount() const { return m_Nodes.size(); }
 
-		glm::vec3 m_regionMin;
-		glm::vec3 m_regionMax;
+		//Cells holding this many bodies or fewer are not split further
+		inline uint32_t GetLeafSize() const { return m_LeafSize; }
+		inline void SetLeafSize(uint32_t size) { m_LeafSize = (size > 0) ? size : 1; }
 
-		int m_maxLifespan = 8;
-		int m_curLife = -1;
-
-		static bool m_treeReady;
-		static bool m_treeBuilt;
-
-		std::vector<Object*> m_objects;
-
-		static std::vector<Object*> m_pendingInsertion;
+	protected:
 
-		bool m_hasChildren = false;
+		//10 bits per axis, so the tree is at most 10 levels deep
+		static const uint32_t MORTON_BITS = 10;
+
+		//A cell of the octree. Its bodies are entries [begin, end), its children are
+		//nodes [firstChild, firstChild + childCount). Leaves have no children
+		struct Node {
+			float min[3];
+			float max[3];
+			uint32_t begin;
+			uint32_t end;
+			uint32_t firstChild;
+			uint32_t childCount;
+		};
+
+		//A body's bounds, copied into sorted order so traversal reads contiguous memory
+		struct Entry {
+			float min[3];
+			float max[3];
+			uint32_t body;
+		};
+
+		void ComputeKeys(const BodyStore& bodies);
+		void SortKeys();
+		void GatherEntries(const BodyStore& bodies);
+		void EmitNodes();
+		void FitNodes();
+		void FindPairs(std::vector<BodyPair>& pairs);
+
+		//Spreads the low 10 bits of v so there are two zero bits between each
+		static inline uint32_t SpreadBits(uint32_t v);
+
+		uint32_t m_LeafSize;
+
+		//Morton code in the high 32 bits, body index in the low 32
+		std::vector<uint64_t> m_Keys;
+		std::vector<uint64_t> m_SortScratch;
+		std::vector<uint32_t> m_RadixOffsets;
+
+		std::vector<Entry> m_Entries;
+		std::vector<Node> m_Nodes;
+
+		//Pairs found by each batch of entries, joined in batch order so the result doesn't depend on scheduling
+		std::vector<std::vector<BodyPair>> m_BatchPairs;
 
 	};
-}
-
 
+}
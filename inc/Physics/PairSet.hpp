@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Broadphase.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	//Open addressing hash set of unordered body pairs. Pairs are packed into 64 bit keys with the lower index first,
+	//lookups use linear probing and erasing shifts later entries back so no tombstones build up. Each body also keeps
+	//a list of its partners, so removing a body only visits its own pairs
+	class PairSet {
+	public:
+		PairSet();
+		~PairSet();
+
+		bool Insert(uint32_t a, uint32_t b);
+		//Inserts many pairs at once, sizing the table and each body's partner list up front
+		void InsertPairs(const BodyPair* pairs, size_t count);
+		bool Erase(uint32_t a, uint32_t b);
+		bool Contains(uint32_t a, uint32_t b) const;
+		void Clear();
+
+		inline size_t Size() const { return m_Count; }
+
+		//Appends every pair in the set, in slot order
+		void GetPairs(std::vector<BodyPair>& pairs) const;
+
+		//Drops every pair containing index, then renames pairs containing from to index. Costs the pairs of the two
+		//bodies, not of the whole set
+		void RemoveBody(uint32_t index, uint32_t from);
+
+		static inline uint64_t MakeKey(uint32_t a, uint32_t b) {
+			return (a < b) ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+		}
+
+		static inline size_t HashKey(uint64_t key) {
+			//64 bit finaliser from MurmurHash3
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			key ^= key >> 33;
+			key *= 0xc4ceb9fe1a85ec53ull;
+			key ^= key >> 33;
+			return (size_t)key;
+		}
+
+	protected:
+
+		static const uint64_t EMPTY = ~0ull;
+
+		size_t FindSlot(uint64_t key) const;
+		//Doubles the table until it holds count entries under half load
+		void Grow(size_t count = 0);
+
+		//Table only, leaving the partner lists to the caller
+		bool InsertKey(uint64_t key);
+		bool EraseKey(uint64_t key);
+		void AddPartner(uint32_t body, uint32_t partner);
+		void DropPartner(uint32_t body, uint32_t partner);
+
+		std::vector<uint64_t> m_Slots;
+		size_t m_Count;
+
+		//Other body of every pair, indexed by body. Unordered, a partner is swapped out with the list's last on erase
+		std::vector<std::vector<uint32_t>> m_Partners;
+
+	};
+
+}
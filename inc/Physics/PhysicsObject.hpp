@@ -1,45 +1,79 @@
 #pragma once
 
+#include "BodyStore.hpp"
+#include "SlotMap.hpp"
+
 #include <glm/vec3.hpp>
 
 namespace Physics {
 
 	class Collider;
+	class Constraint;
+	class BlockPool;
+
+	//An Object is a view onto a body. Until it is attached to a scene it keeps its own state,
+	//once attached every getter and setter goes through the scene's BodyStore
 	class Object {
 	public:
 		Object();
 		virtual ~Object();
 
-		virtual bool FixedUpdate();
+		//Destroys an object however it was made, handing it back to the pool it came from or deleting it.
+		//Scene::RemoveObject already does this for attached objects
+		static void Destroy(Object* obj);
 
+		//Wakes the object if it is asleep, as do SetPosition and SetVelocity
 		void ApplyForce(const glm::vec3& a_Force);
 
 		//Getters
-		inline const glm::vec3& GetPosition() const { return m_Position; }
-		inline const glm::vec3& GetVelocity() const { return m_Velocity; }
-		inline const glm::vec3& GetMaxVelocity() const { return m_MaxVelocity; }
-		inline const glm::vec3& GetAcceleration() const { return m_Acceleration; }
-		inline const float GetMass() const { return m_Mass; }
-		inline const float GetFriction() const { return m_Friction; }
-		inline const float GetBounciness() const { return m_Bounciness; }
-		inline const bool GetRigid() const { return m_Rigid; }
+		inline glm::vec3 GetPosition() const { return (m_Store != nullptr) ? m_Store->position.Get(m_Index) : m_Position; }
+		inline glm::vec3 GetVelocity() const { return (m_Store != nullptr) ? m_Store->velocity.Get(m_Index) : m_Velocity; }
+		inline glm::vec3 GetMaxVelocity() const { return (m_Store != nullptr) ? m_Store->maxVelocity.Get(m_Index) : m_MaxVelocity; }
+		inline glm::vec3 GetAcceleration() const { return (m_Store != nullptr) ? m_Store->acceleration.Get(m_Index) : m_Acceleration; }
+		inline const float GetMass() const { return (m_Store != nullptr) ? m_Store->mass[m_Index] : m_Mass; }
+		inline const float GetFriction() const { return (m_Store != nullptr) ? m_Store->friction[m_Index] : m_Friction; }
+		inline const float GetBounciness() const { return (m_Store != nullptr) ? m_Store->bounciness[m_Index] : m_Bounciness; }
+		inline const bool GetRigid() const { return (m_Store != nullptr) ? (m_Store->flags[m_Index] & BodyStore::BODY_RIGID) != 0 : m_Rigid; }
+		inline const bool GetContinuous() const { return (m_Store != nullptr) ? (m_Store->flags[m_Index] & BodyStore::BODY_CONTINUOUS) != 0 : m_Continuous; }
+		inline const bool IsSleeping() const { return (m_Store != nullptr) ? m_Store->IsSleeping(m_Index) : false; }
 		Collider* GetCollider();
 
+		//Whether the object is attached to a scene, and its index in that scene's BodyStore
+		inline bool IsAttached() const { return m_Store != nullptr; }
+		inline uint32_t GetIndex() const { return m_Index; }
+		//Handle the scene gave the object on attach. Unlike the index it doesn't change as other objects come and go,
+		//and Scene::FindObject turns it into nullptr once the object is removed
+		inline Handle GetHandle() const { return m_Handle; }
+		//Constraints attached to a scene that connect this object
+		inline const std::vector<Constraint*>& GetConstraints() const { return m_Constraints; }
+
 		//Setters
 		void SetPosition(const glm::vec3& a_Pos);
-		inline void SetVelocity(const glm::vec3& a_Vel) { m_Velocity = a_Vel; }
-		inline void SetMaxVelocity(const glm::vec3& a_MaxVel) { m_MaxVelocity = a_MaxVel; }
-		inline void SetAcceleration(const glm::vec3& a_Acc) { m_Acceleration = a_Acc; }
-		inline void SetMass(float a_Mass) { m_Mass = a_Mass; }
-		inline void SetFriction(float a_Fric) { m_Friction = a_Fric; }
-		inline void SetBounciness(float a_Bounce) { m_Bounciness = a_Bounce; }
-		inline void SetRigid(bool a_Rigid) { m_Rigid = a_Rigid; }
+		void SetVelocity(const glm::vec3& a_Vel);
+		void SetMaxVelocity(const glm::vec3& a_MaxVel);
+		void SetAcceleration(const glm::vec3& a_Acc);
+		void SetMass(float a_Mass);
+		void SetFriction(float a_Fric);
+		void SetBounciness(float a_Bounce);
+		void SetRigid(bool a_Rigid);
+		//Opts the object into continuous collision detection. Only sphere colliders are swept
+		void SetContinuous(bool a_Continuous);
 		void SetCollider(Collider* coll);
 
 	protected:
 
-		void UpdateTransform();
+		friend struct BodyStore;
+		friend class Scene;
 
+		//Store this object is attached to, nullptr while detached
+		BodyStore* m_Store;
+		uint32_t m_Index;
+		Handle m_Handle;
+
+		//Kept by the scene so removing the object can remove its constraints without searching them all
+		std::vector<Constraint*> m_Constraints;
+
+		//Detached state, copied into the store on attach and back out on removal
 		glm::vec3 m_Position;
 		glm::vec3 m_Velocity;
 		glm::vec3 m_MaxVelocity;
@@ -51,9 +85,13 @@ namespace Physics {
 
 		Collider* m_Collider;
 
+		//Pool the object was allocated from, nullptr if it was made with new
+		BlockPool* m_Pool;
+
 		bool m_Rigid = false;
+		bool m_Continuous = false;
 
 	};
 
 
-}
\ No newline at end of file
+}
@@ -1,63 +1,260 @@
 #pragma once
 
 #include <vector>
-#include <map>
 #include "Intersect.hpp"
+#include "BodyStore.hpp"
+#include "Integrator.hpp"
+#include "Broadphase.hpp"
+#include "CollisionDispatch.hpp"
+#include "IslandManager.hpp"
+#include "ContactCache.hpp"
+#include "ContactSolver.hpp"
+#include "CollisionEvents.hpp"
+#include "SpringSolver.hpp"
+#include "ContinuousCollision.hpp"
+#include "Pool.hpp"
+#include "SlotMap.hpp"
+#include "JobSystem.hpp"
+#include "ProfileSink.hpp"
 
 namespace Physics {
 
 	class Object;
+	class Collider;
 	class Constraint;
+	class SceneListener;
 	class Scene {
 	public:
 
-		struct CollisionInfo {
-			Object* objA;
-			Object* objB;
-
-			IntersectData intersection;
-		};
-
 		Scene();
 		virtual ~Scene();
 
+		//Advances the simulation by dt seconds of real time, running as many fixed steps as fit in the time carried
+		//over plus dt. Leftover time is kept for the next call. Returns the fixed steps run
+		uint32_t Step(float dt);
+		//Runs one fixed step, split into substeps
 		void FixedUpdate();
 
-		inline void ApplyGlobalForce(const glm::vec3& force) { m_GlobalForce += force; }
+		//Wakes every sleeping body, since they would all feel it
+		void ApplyGlobalForce(const glm::vec3& force);
 
 		//Getters
 		inline const glm::vec3& GetGravity() const { return m_Gravity; }
-		inline const std::vector<Object*>& GetObjects() const { return m_Objects; }
+		inline float GetFixedTimeStep() const { return m_FixedTimeStep; }
+		inline uint32_t GetSubsteps() const { return m_Substeps; }
+		inline uint32_t GetMaxSubsteps() const { return m_MaxSubsteps; }
+		inline bool GetAdaptiveSubsteps() const { return m_AdaptiveSubsteps; }
+		inline float GetCourantNumber() const { return m_CourantNumber; }
+		inline uint32_t GetMaxStepsPerCall() const { return m_MaxStepsPerCall; }
+		//Substeps the last fixed step was split into
+		inline uint32_t GetLastSubstepCount() const { return m_LastSubstepCount; }
+		//How far between the last two fixed steps the time Step has reached, 0 to 1. Render bodies at
+		//GetInterpolatedPosition to hide the step rate
+		inline float GetInterpolationAlpha() const { return m_Accumulator / m_FixedTimeStep; }
+		glm::vec3 GetInterpolatedPosition(const Object* obj) const;
+		inline Integrator& GetIntegrator() { return m_Integrator; }
+		//Iterations and penetration recovery of the contact solve. The time step is set from the substep length
+		inline ContactSolverSettings& GetSolverSettings() { return m_SolverSettings; }
+		inline const ContactSolver& GetContactSolver() const { return m_Solver; }
+		//Springs packed for solving in batches, rebuilt at the start of the step after springs or their bodies change
+		inline SpringSolver& GetSpringSolver() { return m_SpringSolver; }
+		//Explicit or implicit springs and the implicit solve's limits. The time step is set from the substep length
+		inline SpringSolverSettings& GetSpringSettings() { return m_SpringSettings; }
+		//Sweeps bodies flagged with Object::SetContinuous
+		inline ContinuousCollision& GetContinuousCollision() { return m_Continuous; }
+		//Island building and sleep settings
+		inline IslandManager& GetIslands() { return m_Islands; }
+		inline JobSystem* GetJobSystem() const { return m_JobSystem; }
+		//Items per parallel batch in a phase. Phases that don't split their work ignore it
+		inline uint32_t GetGrainSize(ProfilePhase phase) const { return m_GrainSizes[(int)phase]; }
+		//Phases of a substep as tasks, for inspection
+		inline const TaskGraph& GetStepGraph() const { return m_StepGraph; }
+		//Kernels the narrowphase uses for each pair of collider types, register new ones here
+		inline CollisionDispatcher& GetCollisionDispatcher() { return m_Dispatcher; }
+		inline const std::vector<Object*>& GetObjects() const { return m_Bodies.objects; }
+		inline const BodyStore& GetBodies() const { return m_Bodies; }
 		inline const std::vector<Constraint*>& GetConstraints() const { return m_Constraints; }
+		inline ProfileSink* GetProfileSink() const { return m_ProfileSink; }
+		inline SceneListener* GetListener() const { return m_Listener; }
+		inline BroadphaseType GetBroadphaseType() const { return m_BroadphaseType; }
+		//Candidate pairs the broadphase produced last step
+		inline size_t GetCandidatePairCount() const { return m_CandidatePairs.size(); }
+		inline size_t GetCollisionCount() const { return m_Contacts.size(); }
+		//Contacts last step that were carried over from the step before instead of regenerated
+		inline size_t GetReusedContactCount() const { return m_ReusedContactCount; }
+		inline ContactCache& GetContactCache() { return m_ContactCache; }
+		//Begin, stay and end events from the last fixed step, and listeners for every step's. Off until enabled
+		inline CollisionEvents& GetCollisionEvents() { return m_CollisionEvents; }
+		//Pools objects and colliders made by the Create functions come from, for usage statistics
+		inline const BlockPool& GetObjectPool() const { return m_ObjectPool; }
+		inline const BlockPool& GetSphereColliderPool() const { return m_SpherePool; }
+		inline const BlockPool& GetAABBColliderPool() const { return m_AABBPool; }
+		//Memory for temporaries that only last one fixed step, reset at the start of each
+		inline ScratchArena& GetScratch() { return m_Scratch; }
 
 		//Setters
 		inline void SetGravity(const glm::vec3& gravity) { m_Gravity = gravity; }
+		//Seconds per fixed step. Anything not above 0 is ignored, since Step could never use up the time
+		inline void SetFixedTimeStep(float timeStep) { if(timeStep > 0.0f) m_FixedTimeStep = timeStep; }
+		//Substeps every fixed step is split into, at least 1. Adaptive substepping never goes below this
+		inline void SetSubsteps(uint32_t substeps) { m_Substeps = (substeps > 0) ? substeps : 1; }
+		//Upper limit for adaptive substepping
+		inline void SetMaxSubsteps(uint32_t substeps) { m_MaxSubsteps = (substeps > 0) ? substeps : 1; }
+		//Picks the substep count each fixed step so no body moves further than the Courant number times the
+		//smallest collider size in one substep
+		inline void SetAdaptiveSubsteps(bool adaptive) { m_AdaptiveSubsteps = adaptive; }
+		inline void SetCourantNumber(float courant) { m_CourantNumber = courant; }
+		//Fixed steps one Step call may run. Time beyond that is dropped, so a slow frame doesn't leave more to
+		//catch up on next frame and the one after
+		inline void SetMaxStepsPerCall(uint32_t steps) { m_MaxStepsPerCall = (steps > 0) ? steps : 1; }
+		//Sink that receives per-phase timings each step, nullptr disables timing
+		inline void SetProfileSink(ProfileSink* sink) { m_ProfileSink = sink; }
+		//Listener told about objects and constraints as they're removed, nullptr for none
+		inline void SetListener(SceneListener* listener) { m_Listener = listener; }
+		//Replaces the broadphase, re-inserting every attached body
+		void SetBroadphase(BroadphaseType type);
+		//Threads used for parallel phases, the calling thread included. 0 uses every hardware thread
+		void SetThreadCount(uint32_t count);
+		//Runs the scene on a job system owned elsewhere, shared with other work. It must outlive the scene
+		void SetJobSystem(JobSystem* jobs);
+		//Runs every phase inline on the calling thread, for debugging. Results are bit for bit the same as a
+		//threaded run, since batch boundaries and merge order don't depend on the thread count
+		inline void SetSingleThreaded(bool singleThreaded) { m_JobSystem->SetSingleThreaded(singleThreaded); }
+		inline void SetGrainSize(ProfilePhase phase, uint32_t size) { m_GrainSizes[(int)phase] = (size > 0) ? size : 1; }
+
+		//Objects and colliders allocated from the scene's pools. They're used like ones made with new, but must
+		//be destroyed by the scene, through RemoveObject or Object::Destroy, before the scene is
+		Object* CreateObject();
+		Collider* CreateSphereCollider(float radius);
+		Collider* CreateAABBCollider(const glm::vec3& extents);
 
 		void AttachObject(Object* obj);
+		//Detaches and destroys the object, along with every constraint attached to it
 		void RemoveObject(Object* obj);
+		//Returns false if the handle is stale
+		bool RemoveObject(Handle handle);
+
+		//Attach or remove many objects at once. When the batch is large compared to the scene the broadphase isn't
+		//touched per object, it is rebuilt in one go at the start of the next step instead
+		void AttachObjects(Object* const* objs, size_t count);
+		inline void AttachObjects(const std::vector<Object*>& objs) { AttachObjects(objs.data(), objs.size()); }
+		//Objects listed more than once are removed once
+		void RemoveObjects(Object* const* objs, size_t count);
+		inline void RemoveObjects(const std::vector<Object*>& objs) { RemoveObjects(objs.data(), objs.size()); }
 		
 		void AttachConstraint(Constraint* con);
 		void RemoveConstraint(Constraint* con);
+		bool RemoveConstraint(Handle handle);
+
+		//The object or constraint a handle refers to, nullptr once it has been removed
+		Object* FindObject(Handle handle) const;
+		Constraint* FindConstraint(Handle handle) const;
 
-		inline bool IsInCollision(Object* obj) { return m_InCollisionLookup[obj]; }
+		//Contacts the object was part of in the last substep. A sleeping object keeps the count from the substep it
+		//fell asleep in, since pairs that are both resting aren't tested. Objects not attached to this scene have none.
+		//To react to contacts starting and ending without polling, use GetCollisionEvents
+		uint32_t GetContactCount(const Object* obj) const;
+		inline bool IsInCollision(const Object* obj) const { return GetContactCount(obj) > 0; }
 
 	protected:
 
-		friend class Tree;
+		static Broadphase* CreateBroadphase(BroadphaseType type);
+
+		//One pass of the pipeline over timeStep seconds
+		void Substep(float timeStep);
+		//Lays the phases of a substep out as tasks in m_StepGraph
+		void BuildStepGraph();
+		uint32_t ChooseSubstepCount() const;
+
+		//Whether obj is attached to this scene rather than another one. Its index is only checked against the store
+		//once it's known to be in range
+		bool IsInStore(const Object* obj) const;
+
+		//Takes an attached body out of the store and destroys it, along with its constraints
+		void DetachBody(Object* obj);
+
+		void DetectCollisions();
+		//Adds contacts to the step's list and the cache. Reused contacts leave the cache's geometry alone
+		void MergeContacts(const std::vector<Contact>& contacts, bool regenerated);
+		void ResolveCollisions(float timeStep);
+		void UpdateIslands(float timeStep);
 
-		//void DetectCollisions();
-		//void ResolveCollisions();
+		BodyStore m_Bodies;
+		//Handles for bodies, kept in step with the store's dense order
+		SlotMap m_ObjectSlots;
 
-		std::vector<Object*> m_Objects;
+		Integrator m_Integrator;
+		//1 for every body the integrator moved far enough that the broadphase has to update it
+		std::vector<uint8_t> m_MovedMask;
 		std::vector<Constraint*> m_Constraints;
+		SlotMap m_ConstraintSlots;
+		SpringSolver m_SpringSolver;
+		SpringSolverSettings m_SpringSettings;
+		//Constraints the spring solver didn't pack, updated one at a time
+		std::vector<Constraint*> m_LooseConstraints;
+		//Set when constraints, or bodies with constraints, are attached, removed or moved to a new index
+		bool m_SpringsStale;
 
-		std::vector<CollisionInfo> m_CollisionPairs;
-		std::map<Object*, bool> m_InCollisionLookup;
+		IslandManager m_Islands;
+		//Contacts and constraints joining bodies this step, as body index pairs
+		std::vector<BodyPair> m_IslandEdges;
+
+		std::vector<BodyPair> m_CandidatePairs;
+		ContinuousCollision m_Continuous;
+		CollisionDispatcher m_Dispatcher;
+		ContactCache m_ContactCache;
+		//Candidates each batch found in the cache, and the ones it left for the narrowphase
+		std::vector<std::vector<Contact>> m_BatchReused;
+		std::vector<std::vector<BodyPair>> m_BatchFresh;
+		std::vector<BodyPair> m_FreshPairs;
+		size_t m_ReusedContactCount;
+		//Contacts found by each batch of candidate pairs, merged into m_Contacts in batch order
+		std::vector<std::vector<Contact>> m_BatchContacts;
+		std::vector<Contact> m_Contacts;
+		//Per contact: its cache slot, and the impulse along its normal, last step's going into the solve and
+		//this step's coming out
+		std::vector<size_t> m_ContactSlots;
+		std::vector<float> m_ContactImpulses;
+
+		ContactSolver m_Solver;
+		ContactSolverSettings m_SolverSettings;
+		CollisionEvents m_CollisionEvents;
 
 		glm::vec3 m_GlobalForce;
 		glm::vec3 m_Gravity;
 
-		Tree* m_tree;
+		float m_FixedTimeStep;
+		//Real time not yet simulated
+		float m_Accumulator;
+		uint32_t m_MaxStepsPerCall;
+
+		uint32_t m_Substeps;
+		uint32_t m_MaxSubsteps;
+		bool m_AdaptiveSubsteps;
+		float m_CourantNumber;
+		uint32_t m_LastSubstepCount;
+
+		//Length of the substep being run, read by the step graph's tasks
+		float m_SubstepTime;
+		TaskGraph m_StepGraph;
+		uint32_t m_GrainSizes[(int)ProfilePhase::COUNT];
+
+		//Worker threads shared by the phases that split their work
+		JobSystem* m_JobSystem;
+		bool m_OwnsJobSystem;
+
+		Broadphase* m_Broadphase;
+		BroadphaseType m_BroadphaseType;
+		//Set by bulk changes, the broadphase is built from scratch at the start of the next step
+		bool m_BroadphaseStale;
+
+		BlockPool m_ObjectPool;
+		BlockPool m_SpherePool;
+		BlockPool m_AABBPool;
+		ScratchArena m_Scratch;
+
+		ProfileSink* m_ProfileSink;
+		SceneListener* m_Listener;
 
 	};
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physics {
+
+	//Fixed size blocks carved out of chunks, with freed blocks kept on a free list threaded through the blocks
+	//themselves. Allocating and freeing never touch the heap once a chunk has room, and chunks are only released
+	//when the pool is destroyed, so every block handed out must be freed before then
+	class BlockPool {
+	public:
+		BlockPool(size_t blockSize, size_t blocksPerChunk = 256);
+		~BlockPool();
+
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+
+		void* Allocate();
+		void Free(void* block);
+
+		//Getters
+		inline size_t GetBlockSize() const { return m_BlockSize; }
+		//Blocks handed out and not yet freed
+		inline size_t GetLiveCount() const { return m_Live; }
+		//Most blocks that have been live at once
+		inline size_t GetPeakCount() const { return m_Peak; }
+		//Blocks in every chunk, live or free
+		inline size_t GetCapacity() const { return m_Chunks.size() * m_BlocksPerChunk; }
+		inline size_t GetChunkCount() const { return m_Chunks.size(); }
+		inline size_t GetCapacityBytes() const { return GetCapacity() * m_BlockSize; }
+
+	protected:
+
+		void AddChunk();
+
+		size_t m_BlockSize;
+		size_t m_BlocksPerChunk;
+
+		std::vector<char*> m_Chunks;
+		void* m_FreeList;
+
+		size_t m_Live;
+		size_t m_Peak;
+
+	};
+
+	//Bump allocator for memory that only lives for one step. Nothing is freed individually, Reset hands everything
+	//back at once. Not thread safe, allocate from the thread running the step
+	class ScratchArena {
+	public:
+		explicit ScratchArena(size_t blockSize = 256 * 1024);
+		~ScratchArena();
+
+		ScratchArena(const ScratchArena&) = delete;
+		ScratchArena& operator=(const ScratchArena&) = delete;
+
+		void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+		//Uninitialised room for count values of T. Only for types that don't need destroying
+		template<typename T>
+		inline T* AllocateArray(size_t count) { return (T*)Allocate(count * sizeof(T), alignof(T)); }
+
+		//Releases everything allocated since the last reset. If that took more than one block they are replaced
+		//by one big enough for all of it, so a step that needs the same again fits in a single block
+		void Reset();
+
+		//Getters
+		//Bytes allocated since the last reset
+		inline size_t GetUsed() const { return m_Used; }
+		//Most bytes used between two resets
+		inline size_t GetPeak() const { return m_Peak; }
+		inline size_t GetCapacity() const { return m_Capacity; }
+		inline size_t GetBlockCount() const { return m_Blocks.size(); }
+
+	protected:
+
+		struct Block {
+			char* data;
+			size_t size;
+		};
+
+		void AddBlock(size_t minSize);
+
+		size_t m_BlockSize;
+
+		std::vector<Block> m_Blocks;
+		//Block being bumped through and the offset into it
+		size_t m_Current;
+		size_t m_Offset;
+
+		size_t m_Used;
+		size_t m_Peak;
+		size_t m_Capacity;
+
+	};
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+
+namespace Physics {
+
+	enum class ProfilePhase {
+		CONSTRAINTS,
+		INTEGRATE,
+		BROADPHASE,
+		CCD,
+		NARROWPHASE,
+		SOLVE,
+		ISLANDS,
+		COUNT
+	};
+
+	const char* GetPhaseName(ProfilePhase phase);
+
+	//Receives per-phase timings from a Scene step. Implementations decide where they go (UI, log, benchmark)
+	class ProfileSink {
+	public:
+		virtual ~ProfileSink() {}
+
+		virtual void Record(ProfilePhase phase, double milliseconds) = 0;
+
+	};
+
+	//Times a scope and reports it to a sink on destruction. Does nothing if there is no sink
+	class ScopedPhaseTimer {
+	public:
+		ScopedPhaseTimer(ProfileSink* sink, ProfilePhase phase) : m_Sink(sink), m_Phase(phase) {
+			if(m_Sink != nullptr)
+				m_Start = std::chrono::steady_clock::now();
+		}
+
+		~ScopedPhaseTimer() {
+			if(m_Sink == nullptr)	return;
+			std::chrono::duration<double, std::milli> length = std::chrono::steady_clock::now() - m_Start;
+			m_Sink->Record(m_Phase, length.count());
+		}
+
+	protected:
+
+		ProfileSink* m_Sink;
+		ProfilePhase m_Phase;
+		std::chrono::steady_clock::time_point m_Start;
+
+	};
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+//Zones are compiled in unless the build sets PHYSICS_PROFILING to 0, then every PHYSICS_ZONE is nothing at all
+#ifndef PHYSICS_PROFILING
+#define PHYSICS_PROFILING 1
+#endif
+
+namespace Physics {
+
+	//A finished zone. Times are nanoseconds from Profiler::Now
+	struct ProfileEvent {
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+	};
+
+	//Collects timed zones from every thread. Each thread writes only to its own ring buffer, so recording takes no
+	//lock, and once a ring is full its oldest zones are overwritten. Off until SetEnabled, when a zone costs one
+	//relaxed load. Reading the rings while zones are being recorded can pick up half written entries, so dump and
+	//clear between steps
+	class Profiler {
+	public:
+		//Zones each thread's ring keeps
+		static const uint32_t RING_SIZE = 1 << 16;
+
+		//Nanoseconds on the steady clock
+		static uint64_t Now();
+
+		static void Record(const char* name, uint64_t start, uint64_t end);
+		//Empties every ring
+		static void Clear();
+
+		//Zones recorded since the last clear, including any since overwritten
+		static uint64_t GetRecordedCount();
+		//Appends every zone the rings still hold, with the ring each came from in threads. Each ring's zones come
+		//oldest first
+		static void Collect(std::vector<ProfileEvent>& events, std::vector<uint32_t>& threads);
+		//Writes every zone the rings still hold as Chrome trace JSON, for chrome://tracing or Perfetto. Zone names
+		//go in as they are, so shouldn't need escaping
+		static bool WriteChromeTrace(const char* path);
+
+		inline static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+		inline static void SetEnabled(bool enabled) { s_Enabled.store(enabled, std::memory_order_relaxed); }
+
+	protected:
+
+		struct Ring {
+			//Order the ring was created in, which is its thread in traces
+			uint32_t thread;
+			std::unique_ptr<ProfileEvent[]> events;
+			//Zones ever written, the next goes in at written % RING_SIZE
+			std::atomic<uint64_t> written;
+		};
+
+		//The calling thread's ring, made on its first zone
+		static Ring* GetRing();
+
+		static std::atomic<bool> s_Enabled;
+
+		//Rings outlive their threads so a dump after the pool is gone still sees them
+		static std::mutex s_RingMutex;
+		static std::vector<std::unique_ptr<Ring>> s_Rings;
+
+	};
+
+	//Times its scope as a zone while the profiler is enabled. Use PHYSICS_ZONE so it compiles out
+	class ProfileZone {
+	public:
+		explicit ProfileZone(const char* name) : m_Name(name), m_Active(Profiler::IsEnabled()), m_Start(0) {
+			if(m_Active)
+				m_Start = Profiler::Now();
+		}
+
+		~ProfileZone() {
+			if(m_Active)
+				Profiler::Record(m_Name, m_Start, Profiler::Now());
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	protected:
+
+		const char* m_Name;
+		bool m_Active;
+		uint64_t m_Start;
+
+	};
+
+}
+
+#if PHYSICS_PROFILING
+#define PHYSICS_ZONE_JOIN_INNER(a, b) a##b
+#define PHYSICS_ZONE_JOIN(a, b) PHYSICS_ZONE_JOIN_INNER(a, b)
+//Times the rest of the enclosing scope as a zone. name has to be a string literal, rings keep the pointer
+#define PHYSICS_ZONE(name) ::Physics::ProfileZone PHYSICS_ZONE_JOIN(physicsZone, __LINE__)("" name "")
+#else
+#define PHYSICS_ZONE(name)
+#endif
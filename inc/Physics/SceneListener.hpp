@@ -0,0 +1,20 @@
+#pragma once
+
+namespace Physics {
+
+	class Object;
+	class Constraint;
+
+	//Told about things leaving a Scene, so anything keeping its own data about them (renderers, gameplay code) can
+	//drop it. Each call comes just before the object or constraint is destroyed, while it is still safe to read
+	class SceneListener {
+	public:
+		virtual ~SceneListener() {}
+
+		virtual void OnObjectRemoved(Object* obj) {}
+		//Also called for every constraint removed because one of its objects was
+		virtual void OnConstraintRemoved(Constraint* con) {}
+
+	};
+
+}
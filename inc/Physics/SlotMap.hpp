@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Physics {
+
+	//Stable reference to an entry in a SlotMap. The generation changes every time the slot is reused, so a handle to
+	//something that has since been removed is detected instead of silently pointing at whatever took its place
+	struct Handle {
+		uint32_t slot = ~0u;
+		uint32_t generation = 0;
+
+		inline bool operator==(const Handle& other) const { return slot == other.slot && generation == other.generation; }
+		inline bool operator!=(const Handle& other) const { return !(*this == other); }
+	};
+
+	//Maps handles to indices in dense arrays kept by the owner. Insert always appends at the end of the dense range
+	//and Remove mirrors a swap-remove, moving the last entry into the hole, so the owner's arrays stay in step by doing
+	//the same. Every operation is O(1)
+	class SlotMap {
+	public:
+		SlotMap();
+		~SlotMap();
+
+		//Hands out a handle for a new entry at dense index Size()
+		Handle Insert();
+		//Frees the handle's slot and moves the last entry into its dense index. The handle must be valid
+		void Remove(Handle handle);
+		void Clear();
+
+		inline bool IsValid(Handle handle) const {
+			return handle.slot < m_Slots.size() && m_Slots[handle.slot].generation == handle.generation && m_Slots[handle.slot].dense != FREE;
+		}
+
+		//Getters
+		inline uint32_t GetIndex(Handle handle) const { return m_Slots[handle.slot].dense; }
+		inline Handle GetHandle(uint32_t index) const { return { m_DenseToSlot[index], m_Slots[m_DenseToSlot[index]].generation }; }
+		inline size_t Size() const { return m_DenseToSlot.size(); }
+
+	protected:
+
+		static const uint32_t FREE = ~0u;
+
+		struct Slot {
+			//Dense index of the entry, or FREE while on the free list
+			uint32_t dense;
+			uint32_t generation;
+			uint32_t nextFree;
+		};
+
+		std::vector<Slot> m_Slots;
+		std::vector<uint32_t> m_DenseToSlot;
+		uint32_t m_FreeHead;
+
+	};
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Broadphase.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	//Uniform grid hashed into a flat table, rebuilt from scratch every update. Bodies are counting sorted by the
+	//hash of the cell holding their centre, so each cell's bodies sit contiguously and finding neighbours is a scan
+	//over the 27 surrounding cells. Cells are sized to the largest collider short of outliers many times the
+	//average. Bodies too big for a cell, those outliers and fast bodies whose bounds are swept along their path,
+	//look through every cell they cover and are swept against each other along one axis
+	class SpatialHashGrid : public Broadphase {
+	public:
+		SpatialHashGrid();
+		virtual ~SpatialHashGrid();
+
+		//The grid holds no state between updates so there is nothing to do on insert or remove
+		virtual void Insert(const BodyStore& bodies, uint32_t index) {}
+		virtual void Remove(const BodyStore& bodies, uint32_t index) {}
+		virtual void Build(const BodyStore& bodies) {}
+
+		virtual void Update(const BodyStore& bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs);
+
+		//Cell size used by the last update
+		inline float GetCellSize() const { return m_CellSize; }
+		inline size_t GetOversizedCount() const { return m_Oversized.size(); }
+
+		//Fixes the cell size, 0 derives it from the sphere diameters every update
+		inline void SetCellSize(float size) { m_FixedCellSize = size; }
+
+	protected:
+
+		//Cell coordinates are packed 21 bits per axis, oversized bodies get a key no cell can have
+		static const uint64_t OVERSIZED = ~0ull;
+
+		float ChooseCellSize(const BodyStore& bodies) const;
+		void BuildCells(const BodyStore& bodies);
+		void FindPairs(const BodyStore& bodies, std::vector<BodyPair>& pairs) const;
+		//Pairs the entry at slot with every later slot in [begin, end) whose cell lies in the z row starting at rowFirst
+		inline void ScanRange(uint32_t slot, uint32_t begin, uint32_t end, uint64_t rowFirst, std::vector<BodyPair>& pairs) const;
+		//Pairs an oversized body with every entry in the cells its bounds cover
+		void QueryOversized(const BodyStore& bodies, uint32_t big, std::vector<BodyPair>& pairs) const;
+		//Pairs an oversized body with every entry in [begin, end) whose key is in [keyFirst, keyLast]
+		inline void ScanOversized(uint32_t big, const float* min, const float* max, uint32_t begin, uint32_t end,
+								  uint64_t keyFirst, uint64_t keyLast, std::vector<BodyPair>& pairs) const;
+		//Picks the sweep axis for the oversized bodies and sorts them along it
+		void SortOversized(const BodyStore& bodies);
+
+		//A body's cell key and bounds, copied out so a bucket scan reads one contiguous block
+		struct Entry {
+			uint64_t key;
+			uint32_t body;
+			float min[3];
+			float max[3];
+		};
+
+		static uint64_t PackCell(int32_t x, int32_t y, int32_t z);
+		inline uint32_t HashCell(uint64_t key) const;
+
+		float m_CellSize;
+		float m_FixedCellSize;
+
+		//Per body cell key, indexed by body
+		std::vector<uint64_t> m_BodyKeys;
+
+		//While the occupied cells span a small enough box the hash is the cell's linear index inside it, so entries are
+		//laid out in spatial order. Otherwise cells are scattered by a prime hash
+		bool m_Dense;
+		uint32_t m_Origin[3];
+		uint32_t m_Dims[3];
+		//Range of cells holding entries, empty if none do
+		int32_t m_CellMin[3];
+		int32_t m_CellMax[3];
+
+		//Hash table, bucket i holds m_CellCount[i] entries starting at m_CellStart[i]. The start array has one extra
+		//element holding the entry count, so bucket i always ends at m_CellStart[i + 1]
+		std::vector<uint32_t> m_CellStart;
+		std::vector<uint32_t> m_CellCount;
+		uint32_t m_TableMask;
+
+		//Entries ordered by bucket
+		std::vector<Entry> m_Entries;
+
+		//Bodies too big for a cell, sorted along m_SweepAxis by their bounds' minimum
+		std::vector<uint32_t> m_Oversized;
+		int m_SweepAxis;
+
+	};
+
+}
@@ -11,14 +11,11 @@ namespace Physics {
 		SphereCollider(float radius);
 		virtual ~SphereCollider();
 
-		inline const glm::vec3& GetPosition() const { return m_Position; }
+		glm::vec3 GetPosition() const;
 		inline const float GetRadius() const { return m_Radius; }
 
-		virtual void Transform(Object* obj);
-
 	protected:
 
-		glm::vec3 m_Position;
 		float m_Radius;
 
 	};
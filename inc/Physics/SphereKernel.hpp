@@ -0,0 +1,19 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+#include "CollisionDispatch.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	struct BodyStore;
+
+	//Sphere against sphere tests for a batch of pairs, 8 pairs at a time with AVX2 or 4 with SSE. Overlap is decided
+	//on squared distances, and the square root and normal are only worked out when at least one lane hits.
+	//Spheres with coincident centres are pushed apart along +y. Every level produces bit for bit the same contacts
+	//in the same order, so level only changes speed. Levels the CPU doesn't support fall back to the best one it does
+	void SphereSphereBatch(SimdLevel level, const BodyStore& bodies, const BodyPair* pairs, uint32_t count, std::vector<Contact>& contacts);
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Constraint.hpp"
+#include "SpringSolver.hpp"
+
+#include <cstdint>
 
 namespace Physics {
 
@@ -18,16 +21,28 @@ namespace Physics {
 		inline const float GetStiffness() const { return m_Stiffness; }
 		inline const float GetFriction() const { return m_Friction; }
 
-		//Setters
-		inline void SetStiffness(float stiff) { m_Stiffness = stiff; }
-		inline void SetFriction(float fric) { m_Friction = fric; }
+		//Setters. Springs packed by a scene's spring solver update their packed copy too
+		inline void SetStiffness(float stiff) {
+			m_Stiffness = stiff;
+			if(m_Solver != nullptr)	m_Solver->SetStiffness(m_Index, stiff);
+		}
+		inline void SetFriction(float fric) {
+			m_Friction = fric;
+			if(m_Solver != nullptr)	m_Solver->SetFriction(m_Index, fric);
+		}
 
 	protected:
 
+		friend class SpringSolver;
+
 		float m_Length;
 		float m_Stiffness;
 		float m_Friction;
 
+		//Solver holding the packed copy of this spring and its index there, nullptr when not packed
+		SpringSolver* m_Solver;
+		uint32_t m_Index;
+
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "CpuFeatures.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+namespace Physics {
+
+	struct BodyStore;
+	class JobSystem;
+	class Constraint;
+	class Spring;
+
+	enum class SpringIntegration {
+		//Forces from the state at the start of the step. Cheap, but stiff springs need short steps to stay stable
+		EXPLICIT,
+		//Backward Euler, solving for the velocity change that leaves every spring pulling with its end of step
+		//force. Stable at any stiffness for the cost of a sparse solve each step
+		IMPLICIT
+	};
+
+	//Symmetric 3x3 block of the implicit spring system
+	struct SymmetricBlock {
+		float xx, xy, xz;
+		float yy, yz;
+		float zz;
+	};
+
+	struct SpringSolverSettings {
+		SpringIntegration integration = SpringIntegration::EXPLICIT;
+		float timeStep = 1.0f / 60.0f;
+		//Conjugate gradient iterations at most, and the residual relative to the right hand side that ends them early
+		uint32_t maxIterations = 64;
+		float tolerance = 1e-4f;
+		//Springs per parallel batch within a colour, and bodies per batch for the implicit solve
+		uint32_t batchSize = 4096;
+	};
+
+	//Every spring of a scene packed into flat arrays and evaluated in one pass, 8 springs at a time with AVX2 or 4
+	//with SSE. Forces go straight into the bodies' acceleration arrays.
+	//Springs are coloured so no two of a colour share a body, then each colour runs as parallel batches with no
+	//locking. Colours run one after another, so a body sees its springs in the same order whatever the thread count,
+	//and every level computes bit for bit the same forces.
+	//Springs between two resting bodies are skipped, rigid ends are never written and sleeping ends are woken.
+	//In implicit mode every body touched by a spring is a 3x3 block row of one sparse system. Its layout is worked out
+	//once per build and the values are refreshed each step, each row summing its own springs so rows fill in parallel
+	//without colouring. It's solved by conjugate gradient with a block Jacobi preconditioner, starting from last
+	//step's answer. The result goes into acceleration like the explicit forces
+	class SpringSolver {
+	public:
+		SpringSolver();
+		~SpringSolver();
+
+		//Packs every spring in constraints with both ends attached to bodies, and links each to its packed entry so
+		//its setters write through. Everything else is added to loose, to be updated one at a time
+		void Build(const BodyStore& bodies, const std::vector<Constraint*>& constraints, std::vector<Constraint*>& loose);
+		//Adds every spring's force to the acceleration of its bodies
+		void Apply(BodyStore& bodies, const SpringSolverSettings& settings, JobSystem* jobs);
+
+		//Getters
+		inline size_t Size() const { return m_BodyA.size(); }
+		//Body indices of each packed spring's ends, as of the last build
+		inline const std::vector<uint32_t>& GetBodiesA() const { return m_BodyA; }
+		inline const std::vector<uint32_t>& GetBodiesB() const { return m_BodyB; }
+		//Colours the last build needed, the overflow included
+		inline uint32_t GetColourCount() const { return (uint32_t)m_ColourStart.size() - 1; }
+		inline SimdLevel GetSimdLevel() const { return m_SimdLevel; }
+		//Conjugate gradient iterations the last implicit solve took, and the relative residual it stopped at
+		inline uint32_t GetLastIterations() const { return m_LastIterations; }
+		inline float GetLastResidual() const { return m_LastResidual; }
+
+		//Setters
+		inline void SetStiffness(uint32_t index, float stiffness) {
+			m_Stiffness[index] = stiffness;
+			m_LinksStale = true;
+		}
+		inline void SetFriction(uint32_t index, float friction) {
+			m_Friction[index] = friction;
+			m_LinksStale = true;
+		}
+		//Forces a code path, clamped to what the CPU supports
+		void SetSimdLevel(SimdLevel level);
+
+	protected:
+
+		void ApplyRange(BodyStore& bodies, uint32_t begin, uint32_t end) const;
+
+		//Lays out the implicit system for the packed springs
+		void BuildSystem(size_t bodyCount);
+		void ApplyImplicit(BodyStore& bodies, const SpringSolverSettings& settings, JobSystem* jobs);
+		//Copies spring parameters out to the links
+		void RefreshLinks();
+		//Fills rows [begin, end) of the system and right hand side from the springs of each row's body
+		void AssembleRows(const BodyStore& bodies, float timeStep, uint32_t begin, uint32_t end);
+		//out = A * in for rows [begin, end), zero for fixed rows
+		void Multiply(const std::vector<glm::vec3>& in, std::vector<glm::vec3>& out, uint32_t begin, uint32_t end) const;
+
+		//Runs func over every colour in turn, each colour's springs split into parallel batches
+		template<typename Func>
+		void ForEachColour(JobSystem* jobs, uint32_t batchSize, const Func& func);
+		//Runs func over [0, count) in batches, each adding up to PARTIAL_SUMS sums into the array it's given, and
+		//adds the batches up in order into sums. The totals don't depend on which thread ran which batch
+		template<typename Func>
+		void SumBatches(JobSystem* jobs, uint32_t count, uint32_t batchSize, const Func& func, double* sums);
+
+		//Springs sorted by colour, with m_ColourStart holding the first of each colour plus the end. The last colour
+		//is the overflow, springs that found no free colour, and runs on one thread
+		std::vector<uint32_t> m_BodyA;
+		std::vector<uint32_t> m_BodyB;
+		std::vector<float> m_Length;
+		std::vector<float> m_Stiffness;
+		std::vector<float> m_Friction;
+		std::vector<uint32_t> m_ColourStart;
+
+		//Springs being packed by a build, with their ends and colours
+		std::vector<Spring*> m_Packing;
+		std::vector<uint32_t> m_PackingA;
+		std::vector<uint32_t> m_PackingB;
+		std::vector<uint32_t> m_PackingColour;
+		//Bit per colour already used by each body's springs
+		std::vector<uint64_t> m_BodyColours;
+
+		//Implicit system over every body a packed spring touches, as nodes in body order. Blocks are stored row by
+		//row with m_RowStart holding the first of each row plus the end, and m_Column the node of each block
+		bool m_SystemStale;
+		std::vector<uint32_t> m_BodyNode;
+		std::vector<uint32_t> m_NodeBody;
+		std::vector<uint32_t> m_RowStart;
+		std::vector<uint32_t> m_Column;
+		std::vector<uint32_t> m_Diagonal;
+		std::vector<SymmetricBlock> m_Blocks;
+		//Every node's springs, as links grouped by node with m_LinkStart holding the first of each plus the end. A link
+		//has the node at the spring's other end, the block joining them in this node's row, and the spring's
+		//parameters copied out of the packed arrays so rows read them in order
+		std::vector<uint32_t> m_LinkStart;
+		std::vector<uint32_t> m_LinkNode;
+		std::vector<uint32_t> m_LinkBlock;
+		std::vector<uint32_t> m_LinkSpring;
+		std::vector<float> m_LinkLength;
+		std::vector<float> m_LinkStiffness;
+		std::vector<float> m_LinkFriction;
+		//Set by the setters, the copies are refreshed before the next implicit solve
+		bool m_LinksStale;
+
+		//Per node. m_DeltaV is the solution, kept to start the next step's solve from
+		std::vector<glm::vec3> m_Rhs;
+		std::vector<glm::vec3> m_DeltaV;
+		std::vector<glm::vec3> m_Residual;
+		std::vector<glm::vec3> m_Search;
+		std::vector<glm::vec3> m_Product;
+		std::vector<glm::vec3> m_Preconditioned;
+		std::vector<SymmetricBlock> m_InvDiagonal;
+		//Rigid and sleeping bodies keep their velocity, their rows are filtered out of the solve
+		std::vector<uint8_t> m_Fixed;
+		//Nodes with a spring that isn't resting at both ends, woken once assembly has finished reading flags
+		std::vector<uint8_t> m_Pulled;
+		std::vector<double> m_Partials;
+
+		uint32_t m_LastIterations;
+		float m_LastResidual;
+
+		SimdLevel m_SimdLevel;
+
+	};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Broadphase.hpp"
+#include "PairSet.hpp"
+#include "SpatialHashGrid.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace Physics {
+
+	//Incremental sweep and prune. Keeps a sorted list of bounds endpoints per axis and a persistent set of
+	//overlapping pairs. Each step the lists are re-sorted with insertion sort, which is close to linear when
+	//bodies only move a little, and pairs are added or dropped as endpoints swap past one another.
+	//Removing a body leaves its endpoints in the lists. Endpoints keep the body index they had at the last update,
+	//mapped to the current one, and the next update drops or renames them in the pass that refreshes their values
+	class SweepAndPrune : public Broadphase {
+	public:
+		SweepAndPrune();
+		virtual ~SweepAndPrune();
+
+		virtual void Insert(const BodyStore& bodies, uint32_t index);
+		virtual void Remove(const BodyStore& bodies, uint32_t index);
+		virtual void Build(const BodyStore& bodies);
+
+		virtual void Update(const BodyStore& bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs);
+
+		inline size_t GetPairCount() const { return m_Pairs.Size(); }
+
+	protected:
+
+		struct Endpoint {
+			float value;
+			//Body index shifted up one, lowest bit set for a max endpoint
+			uint32_t data;
+
+			inline uint32_t GetBody() const { return data >> 1; }
+			inline bool IsMax() const { return (data & 1) != 0; }
+		};
+
+		static const uint32_t REMOVED = ~0u;
+
+		//Also applies m_BodyOf to every endpoint if bodies were removed, dropping the removed ones
+		void RefreshValues(const BodyStore& bodies, int axis);
+		void SortAxis(const BodyStore& bodies, int axis);
+		//Sorts every axis from scratch and rebuilds the pair set from a spatial hash pass
+		void Rebuild(const BodyStore& bodies);
+		//Points every endpoint body at the body of the same index
+		void ResetBodyMap(uint32_t count);
+
+		std::vector<Endpoint> m_Axes[3];
+		PairSet m_Pairs;
+
+		//Finds the pairs a rebuild starts from. The grid ignores the moved mask, so it's left empty
+		SpatialHashGrid m_SeedGrid;
+		std::vector<BodyPair> m_SeedPairs;
+		std::vector<uint8_t> m_SeedMask;
+
+		//Current body of each body index in the endpoint lists, REMOVED once removed
+		std::vector<uint32_t> m_BodyOf;
+		//Endpoint body index of each current body
+		std::vector<uint32_t> m_EndpointOf;
+		//Bodies removed since the last update
+		size_t m_PendingRemoves;
+
+		//Bodies inserted since the last update. Lots of them makes a full rebuild cheaper than sorting them in
+		size_t m_PendingInserts;
+
+	};
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Physics/SceneListener.hpp"
+
 #include <map>
 #include <glm/vec4.hpp>
 
@@ -8,13 +10,17 @@ namespace Physics {
 	class Scene;
 	class Object;
 	class Spring;
-	class GizmosRenderer {
+	//Set as the scene's listener so render info is dropped with the object or spring it belongs to
+	class GizmosRenderer : public SceneListener {
 	public:
 		GizmosRenderer();
 		virtual ~GizmosRenderer();
 
 		void Draw(Scene* scene);
 
+		virtual void OnObjectRemoved(Object* obj) override;
+		virtual void OnConstraintRemoved(Constraint* con) override;
+
 		struct RenderInfo {
 			glm::vec4 color = glm::vec4(1);
 		};
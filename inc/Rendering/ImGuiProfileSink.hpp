@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Physics/ProfileSink.hpp"
+
+namespace Physics {
+
+	//Collects phase timings from the scene and shows them in an ImGui "Performance" window
+	class ImGuiProfileSink : public ProfileSink {
+	public:
+		ImGuiProfileSink();
+		virtual ~ImGuiProfileSink();
+
+		virtual void Record(ProfilePhase phase, double milliseconds);
+
+		void Draw();
+
+	protected:
+
+		double m_Timings[(int)ProfilePhase::COUNT];
+
+	};
+
+}
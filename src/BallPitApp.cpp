@@ -6,6 +6,7 @@
 
 #include "Rendering/Camera.h"
 #include "Rendering/GizmosRenderer.hpp"
+#include "Rendering/ImGuiProfileSink.hpp"
 
 #include "Physics/PhysicsObject.hpp"
 #include "Physics/SphereCollider.hpp"
@@ -22,7 +23,7 @@ float GetDistance(const glm::vec3& posA, const glm::vec3& posB) {
 	return glm::distance(posA, posB);
 }
 
-BallPitApp::BallPitApp() : m_Camera(nullptr), m_PhysicsScene(nullptr), m_GizmosRenderer(nullptr) {
+BallPitApp::BallPitApp() : m_Camera(nullptr), m_PhysicsScene(nullptr), m_GizmosRenderer(nullptr), m_ProfileSink(nullptr) {
 
 }
 
@@ -31,6 +32,7 @@ BallPitApp::~BallPitApp() {
 	m_Camera = nullptr;
 	m_PhysicsScene = nullptr;
 	m_GizmosRenderer = nullptr;
+	m_ProfileSink = nullptr;
 
 }
 
@@ -52,14 +54,18 @@ bool BallPitApp::startup() {
 	//Initialize Scene and Renderer
 	m_PhysicsScene = new Physics::Scene();
 	m_GizmosRenderer = new Physics::GizmosRenderer();
+	m_ProfileSink = new Physics::ImGuiProfileSink();
+	m_PhysicsScene->SetProfileSink(m_ProfileSink);
+	m_PhysicsScene->SetListener(m_GizmosRenderer);
 
-	//Add Objects to the scene
+	//Add Objects to the scene, attached together so the broadphase is built in one go
+	std::vector<Physics::Object*> balls;
 	for(int x = -5; x < 5; x++) {
 		for(int y = 1; y < 4; y++) {
 			for(int z = -5; z < 5; z++) {
-				Physics::Object* obj = new Physics::Object();
+				Physics::Object* obj = m_PhysicsScene->CreateObject();
 				obj->SetPosition(glm::vec3(x + 0.5f, y, z + 0.5f));
-				obj->SetCollider(new Physics::SphereCollider(0.5f));
+				obj->SetCollider(m_PhysicsScene->CreateSphereCollider(0.5f));
 				m_GizmosRenderer->GetRenderInfo(obj)->color =
 					glm::vec4(
 						rand() % 255 / 255.0f,
@@ -68,18 +74,19 @@ bool BallPitApp::startup() {
 						1.0f
 					);
 
-				m_PhysicsScene->AttachObject(obj);
+				balls.push_back(obj);
 			}
 		}
 	}
+	m_PhysicsScene->AttachObjects(balls);
 
 	float border = 7.5f;
 	float height = 2.0f;
 
 	//Create AABB container
-	Physics::Object* leftBorder = new Physics::Object();
+	Physics::Object* leftBorder = m_PhysicsScene->CreateObject();
 	leftBorder->SetPosition(glm::vec3(-border - 4, 1, 0));
-	leftBorder->SetCollider(new Physics::AABBCollider(glm::vec3(5.0f, height + 0.5f, border + 4.5f)));
+	leftBorder->SetCollider(m_PhysicsScene->CreateAABBCollider(glm::vec3(5.0f, height + 0.5f, border + 4.5f)));
 	leftBorder->SetRigid(true);
 	m_GizmosRenderer->GetRenderInfo(leftBorder)->color =
 		glm::vec4(
@@ -90,9 +97,9 @@ bool BallPitApp::startup() {
 		);
 	m_PhysicsScene->AttachObject(leftBorder);
 
-	Physics::Object* rightBorder = new Physics::Object();
+	Physics::Object* rightBorder = m_PhysicsScene->CreateObject();
 	rightBorder->SetPosition(glm::vec3(border + 4, 1, 0));
-	rightBorder->SetCollider(new Physics::AABBCollider(glm::vec3(5.0f, height + 0.5f, border + 4.5f)));
+	rightBorder->SetCollider(m_PhysicsScene->CreateAABBCollider(glm::vec3(5.0f, height + 0.5f, border + 4.5f)));
 	rightBorder->SetRigid(true);
 	m_GizmosRenderer->GetRenderInfo(rightBorder)->color =
 		glm::vec4(
@@ -103,9 +110,9 @@ bool BallPitApp::startup() {
 		);
 	m_PhysicsScene->AttachObject(rightBorder);
 
-	Physics::Object* topBorder = new Physics::Object();
+	Physics::Object* topBorder = m_PhysicsScene->CreateObject();
 	topBorder->SetPosition(glm::vec3(0, 1, -border - 4));
-	topBorder->SetCollider(new Physics::AABBCollider(glm::vec3(border + 4.5f, height + 0.5f, 5.0f)));
+	topBorder->SetCollider(m_PhysicsScene->CreateAABBCollider(glm::vec3(border + 4.5f, height + 0.5f, 5.0f)));
 	topBorder->SetRigid(true);
 	m_GizmosRenderer->GetRenderInfo(topBorder)->color =
 		glm::vec4(
@@ -116,9 +123,9 @@ bool BallPitApp::startup() {
 		);
 	m_PhysicsScene->AttachObject(topBorder);
 
-	Physics::Object* bottomBorder = new Physics::Object();
+	Physics::Object* bottomBorder = m_PhysicsScene->CreateObject();
 	bottomBorder->SetPosition(glm::vec3(0, 1, border + 4));
-	bottomBorder->SetCollider(new Physics::AABBCollider(glm::vec3(border + 4.5f, height + 0.5f, 5.0f)));
+	bottomBorder->SetCollider(m_PhysicsScene->CreateAABBCollider(glm::vec3(border + 4.5f, height + 0.5f, 5.0f)));
 	bottomBorder->SetRigid(true);
 	m_GizmosRenderer->GetRenderInfo(bottomBorder)->color =
 		glm::vec4(
@@ -157,6 +164,7 @@ void BallPitApp::shutdown() {
 	if(m_Camera != nullptr)			delete m_Camera;
 	if(m_PhysicsScene != nullptr)	delete m_PhysicsScene;
 	if(m_GizmosRenderer != nullptr)	delete m_GizmosRenderer;
+	if(m_ProfileSink != nullptr)	delete m_ProfileSink;
 	
 }
 
@@ -173,12 +181,14 @@ void BallPitApp::update(float deltaTime) {
 	//Shoot ball
 	if(input->wasMouseButtonPressed(aie::INPUT_MOUSE_BUTTON_LEFT) && input->isKeyDown(aie::INPUT_KEY_LEFT_SHIFT)) {
 		float shotSpeed = 20.0f;
-		Physics::Object* obj = new Physics::Object();
+		Physics::Object* obj = m_PhysicsScene->CreateObject();
 		obj->SetPosition(m_Camera->GetPosition());
 		obj->SetVelocity(m_Camera->GetForward() * shotSpeed);
-		obj->SetCollider(new Physics::SphereCollider(0.25f));
+		obj->SetCollider(m_PhysicsScene->CreateSphereCollider(0.25f));
 		obj->SetMass(10.0f);
 		obj->SetBounciness(5);
+		//Fast enough to pass through a wall between steps
+		obj->SetContinuous(true);
 
 		m_GizmosRenderer->GetRenderInfo(obj)->color = glm::vec4(
 			rand() % 255 / 255.0f,
@@ -190,7 +200,9 @@ void BallPitApp::update(float deltaTime) {
 		m_PhysicsScene->AttachObject(obj);
 	}
 
-	m_PhysicsScene->FixedUpdate();
+	//Runs however many fixed steps this frame's time covers, so simulation speed doesn't follow frame rate
+	m_PhysicsScene->Step(deltaTime);
+	m_ProfileSink->Draw();
 
 }
 
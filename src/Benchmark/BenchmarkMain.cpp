@@ -0,0 +1,918 @@
+#include "Physics/PhysicsScene.hpp"
+#include "Physics/PhysicsObject.hpp"
+#include "Physics/SphereCollider.hpp"
+#include "Physics/AABBCollider.hpp"
+#include "Physics/Spring.hpp"
+#include "Physics/ProfileSink.hpp"
+#include "Physics/Profiler.hpp"
+#include "Physics/CpuFeatures.hpp"
+#include "Physics/SphereKernel.hpp"
+
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+
+//Reproducible scenarios for timing Scene::FixedUpdate. Every scenario is built from a seeded generator so two runs
+//with the same seed, broadphase and thread count simulate exactly the same thing. Results are written as JSON
+
+//Sums each phase over a run and keeps the slowest step
+class BenchmarkSink : public Physics::ProfileSink {
+public:
+	BenchmarkSink() {
+		for(int i = 0; i < (int)Physics::ProfilePhase::COUNT; i++) {
+			m_Totals[i] = 0.0;
+			m_Max[i] = 0.0;
+		}
+	}
+
+	virtual void Record(Physics::ProfilePhase phase, double milliseconds) {
+		m_Totals[(int)phase] += milliseconds;
+		if(milliseconds > m_Max[(int)phase])
+			m_Max[(int)phase] = milliseconds;
+	}
+
+	double GetTotal(Physics::ProfilePhase phase) const { return m_Totals[(int)phase]; }
+	double GetMax(Physics::ProfilePhase phase) const { return m_Max[(int)phase]; }
+
+protected:
+
+	double m_Totals[(int)Physics::ProfilePhase::COUNT];
+	double m_Max[(int)Physics::ProfilePhase::COUNT];
+
+};
+
+struct BenchmarkOptions {
+	unsigned int seed = 1;
+	//0 uses each scenario's own step count
+	int steps = 0;
+	uint32_t threads = 0;
+	uint32_t substeps = 1;
+	bool adaptive = false;
+	bool ccd = true;
+	//Every phase inline on the main thread
+	bool deterministic = false;
+	//Backward Euler for every scenario's springs, not just the ones that ask for it
+	bool implicitSprings = false;
+	//Records profiling zones through every run and writes them out as a Chrome trace
+	std::string tracePath;
+	//Runs each scenario again with zones recording and reports how much slower it was
+	bool profileOverhead = false;
+	//Diffs contacts into begin, stay and end events every step
+	bool collisionEvents = false;
+	Physics::BroadphaseType broadphase = Physics::BroadphaseType::DYNAMIC_TREE;
+	std::string scenario = "all";
+	std::string outPath;
+};
+
+//A scenario builds its bodies once, then gets a callback before every step for spawning
+struct Scenario {
+	const char* name;
+	int defaultSteps;
+	void(*build)(Physics::Scene* scene, std::mt19937& rng);
+	void(*beforeStep)(Physics::Scene* scene, std::mt19937& rng, int step);
+	//Bodies that ended up somewhere they shouldn't have, nullptr if the scenario doesn't check
+	uint32_t(*countEscaped)(const Physics::Scene* scene);
+};
+
+struct ScenarioResult {
+	std::string name;
+	int steps = 0;
+	//Substeps run over all steps, only differs from steps * substeps in adaptive mode
+	uint64_t substeps = 0;
+	size_t startBodies = 0;
+	size_t endBodies = 0;
+	size_t constraints = 0;
+	uint32_t sleepingEnd = 0;
+	double setupMs = 0.0;
+	//Bodies attached in bulk are only put in the broadphase on the first step, so startup is setup plus this
+	double firstStepMs = 0.0;
+	double stepMs = 0.0;
+	double maxStepMs = 0.0;
+	uint64_t pairsTested = 0;
+	uint64_t contacts = 0;
+	uint64_t contactsReused = 0;
+	//Continuous collision totals over all steps
+	uint64_t fastBodies = 0;
+	uint64_t impacts = 0;
+	bool checksEscaped = false;
+	uint32_t escaped = 0;
+	//Pool blocks live at once and bytes reserved, and the most scratch one step used
+	size_t objectPoolPeak = 0;
+	size_t colliderPoolPeak = 0;
+	size_t poolBytes = 0;
+	size_t scratchPeak = 0;
+	//Conjugate gradient iterations of implicit spring solves over all steps, and the fastest body at the end
+	uint64_t springIterations = 0;
+	float maxSpeedEnd = 0.0f;
+	//FNV-1a over final positions and velocities, identical across thread counts when the pipeline is deterministic
+	uint64_t stateHash = 0;
+	//Zones recorded while stepping, 0 unless tracing. With --profile-overhead, the step time of a second run with
+	//zones recording
+	uint64_t zones = 0;
+	//Collision events over all steps, with --collision-events
+	uint64_t eventsBegin = 0;
+	uint64_t eventsStay = 0;
+	uint64_t eventsEnd = 0;
+	bool profiled = false;
+	double profiledStepMs = 0.0;
+	double phaseTotal[(int)Physics::ProfilePhase::COUNT];
+	double phaseMax[(int)Physics::ProfilePhase::COUNT];
+};
+
+static double Now() {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void HashFloats(uint64_t& hash, const std::vector<float>& values) {
+	const unsigned char* bytes = (const unsigned char*)values.data();
+	for(size_t i = 0; i < values.size() * sizeof(float); i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+static uint64_t HashState(const Physics::BodyStore& bodies) {
+	uint64_t hash = 14695981039346656037ull;
+	const Physics::Vec3Array* arrays[] = { &bodies.position, &bodies.velocity };
+	for(auto array : arrays) {
+		HashFloats(hash, array->x);
+		HashFloats(hash, array->y);
+		HashFloats(hash, array->z);
+	}
+	return hash;
+}
+
+static float RandomRange(std::mt19937& rng, float min, float max) {
+	return std::uniform_real_distribution<float>(min, max)(rng);
+}
+
+static Physics::Object* MakeBall(Physics::Scene* scene, const glm::vec3& pos, float radius) {
+	Physics::Object* obj = scene->CreateObject();
+	obj->SetPosition(pos);
+	obj->SetCollider(scene->CreateSphereCollider(radius));
+	return obj;
+}
+
+static Physics::Object* AddBall(Physics::Scene* scene, const glm::vec3& pos, float radius) {
+	Physics::Object* obj = MakeBall(scene, pos, radius);
+	scene->AttachObject(obj);
+	return obj;
+}
+
+//Four rigid boxes around a square pit, the same shape as BallPitApp's border scaled to halfWidth
+static void AddWalls(Physics::Scene* scene, float halfWidth, float height) {
+
+	float border = halfWidth + 2.5f;
+
+	glm::vec3 positions[] = {
+		glm::vec3(-border - 4, 1, 0), glm::vec3(border + 4, 1, 0),
+		glm::vec3(0, 1, -border - 4), glm::vec3(0, 1, border + 4)
+	};
+	glm::vec3 extents[] = {
+		glm::vec3(5.0f, height + 0.5f, border + 4.5f), glm::vec3(5.0f, height + 0.5f, border + 4.5f),
+		glm::vec3(border + 4.5f, height + 0.5f, 5.0f), glm::vec3(border + 4.5f, height + 0.5f, 5.0f)
+	};
+
+	for(int i = 0; i < 4; i++) {
+		Physics::Object* wall = scene->CreateObject();
+		wall->SetPosition(positions[i]);
+		wall->SetCollider(scene->CreateAABBCollider(extents[i]));
+		wall->SetRigid(true);
+		scene->AttachObject(wall);
+	}
+
+}
+
+//Balls stacked one unit apart in a side x side square, filling as many layers as count needs. With smallEvery
+//set, every smallEvery-th ball is half size
+static void BuildScaledPit(Physics::Scene* scene, int count, int smallEvery = 0) {
+
+	int side = (int)std::ceil(std::cbrt(count * 4.0));
+	float offset = side * 0.5f;
+
+	//Attached in one batch so the broadphase is built once on the first step
+	std::vector<Physics::Object*> balls(count);
+	for(int i = 0; i < count; i++) {
+		int x = i % side;
+		int z = (i / side) % side;
+		int y = i / (side * side);
+		float radius = (smallEvery > 0 && i % smallEvery == smallEvery - 1) ? 0.25f : 0.5f;
+		balls[i] = MakeBall(scene, glm::vec3(x - offset + 0.5f, y + 1.0f, z - offset + 0.5f), radius);
+	}
+	scene->AttachObjects(balls);
+
+	AddWalls(scene, offset, 2.0f);
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+
+}
+
+//The 10 x 3 x 10 pit BallPitApp::startup creates
+static void BuildDefaultPit(Physics::Scene* scene, std::mt19937& rng) {
+
+	for(int x = -5; x < 5; x++)
+		for(int y = 1; y < 4; y++)
+			for(int z = -5; z < 5; z++)
+				AddBall(scene, glm::vec3(x + 0.5f, y, z + 0.5f), 0.5f);
+
+	AddWalls(scene, 5.0f, 2.0f);
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+
+}
+
+static void BuildPit1k(Physics::Scene* scene, std::mt19937& rng) { BuildScaledPit(scene, 1000); }
+static void BuildPit10k(Physics::Scene* scene, std::mt19937& rng) { BuildScaledPit(scene, 10000); }
+static void BuildPit100k(Physics::Scene* scene, std::mt19937& rng) { BuildScaledPit(scene, 100000); }
+static void BuildPit1M(Physics::Scene* scene, std::mt19937& rng) { BuildScaledPit(scene, 1000000); }
+//8000 full size balls with 800 half size ones spread through them
+static void BuildPitMixed(Physics::Scene* scene, std::mt19937& rng) { BuildScaledPit(scene, 8800, 11); }
+
+//An empty pit that balls keep falling into
+static void BuildRain(Physics::Scene* scene, std::mt19937& rng) {
+	AddWalls(scene, 5.0f, 2.0f);
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+}
+
+static void RainStep(Physics::Scene* scene, std::mt19937& rng, int step) {
+
+	//A few balls a step, dropped from random points above the pit
+	for(int i = 0; i < 4; i++) {
+		glm::vec3 pos(RandomRange(rng, -4.5f, 4.5f), RandomRange(rng, 8.0f, 12.0f), RandomRange(rng, -4.5f, 4.5f));
+		AddBall(scene, pos, 0.5f);
+	}
+
+}
+
+//A cube of balls joined to their axis neighbours by springs, dropped onto the ground
+static void BuildSpringLattice(Physics::Scene* scene, std::mt19937& rng) {
+
+	const int size = 12;
+	const float spacing = 1.0f;
+	std::vector<Physics::Object*> lattice(size * size * size);
+
+	for(int x = 0; x < size; x++) {
+		for(int y = 0; y < size; y++) {
+			for(int z = 0; z < size; z++) {
+				glm::vec3 jitter(RandomRange(rng, -0.05f, 0.05f), RandomRange(rng, -0.05f, 0.05f), RandomRange(rng, -0.05f, 0.05f));
+				glm::vec3 pos = glm::vec3(x - size * 0.5f, y + 2.0f, z - size * 0.5f) * spacing + jitter;
+				lattice[(x * size + y) * size + z] = AddBall(scene, pos, 0.5f);
+			}
+		}
+	}
+
+	for(int x = 0; x < size; x++) {
+		for(int y = 0; y < size; y++) {
+			for(int z = 0; z < size; z++) {
+				Physics::Object* obj = lattice[(x * size + y) * size + z];
+				if(x + 1 < size)	scene->AttachConstraint(new Physics::Spring(obj, lattice[((x + 1) * size + y) * size + z], spacing, 50.0f, 0.5f));
+				if(y + 1 < size)	scene->AttachConstraint(new Physics::Spring(obj, lattice[(x * size + y + 1) * size + z], spacing, 50.0f, 0.5f));
+				if(z + 1 < size)	scene->AttachConstraint(new Physics::Spring(obj, lattice[(x * size + y) * size + z + 1], spacing, 50.0f, 0.5f));
+			}
+		}
+	}
+
+	//The app has no floor, so the lattice gets a rigid slab to land on
+	Physics::Object* ground = scene->CreateObject();
+	ground->SetPosition(glm::vec3(0, -1.0f, 0));
+	ground->SetCollider(scene->CreateAABBCollider(glm::vec3(size * spacing * 2.0f, 1.0f, size * spacing * 2.0f)));
+	ground->SetRigid(true);
+	scene->AttachObject(ground);
+
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+
+}
+
+//A side x side sheet of point masses hanging from its two top corners. Each is joined to its row and column
+//neighbours and across both diagonals, close to 4 springs per mass
+static void BuildCloth(Physics::Scene* scene, int side, float stiffness) {
+
+	const float spacing = 0.5f;
+	const float friction = 1.0f;
+	float offset = side * spacing * 0.5f;
+
+	std::vector<Physics::Object*> cloth(side * side);
+	for(int y = 0; y < side; y++) {
+		for(int x = 0; x < side; x++) {
+			Physics::Object* obj = scene->CreateObject();
+			obj->SetPosition(glm::vec3(x * spacing - offset, 2.0f + side * spacing - y * spacing, 0.0f));
+			cloth[y * side + x] = obj;
+		}
+	}
+	cloth[0]->SetRigid(true);
+	cloth[side - 1]->SetRigid(true);
+	scene->AttachObjects(cloth);
+
+	const float diagonal = spacing * std::sqrt(2.0f);
+	for(int y = 0; y < side; y++) {
+		for(int x = 0; x < side; x++) {
+			Physics::Object* obj = cloth[y * side + x];
+			if(x + 1 < side)				scene->AttachConstraint(new Physics::Spring(obj, cloth[y * side + x + 1], spacing, stiffness, friction));
+			if(y + 1 < side)				scene->AttachConstraint(new Physics::Spring(obj, cloth[(y + 1) * side + x], spacing, stiffness, friction));
+			if(x + 1 < side && y + 1 < side) {
+				scene->AttachConstraint(new Physics::Spring(obj, cloth[(y + 1) * side + x + 1], diagonal, stiffness, friction));
+				scene->AttachConstraint(new Physics::Spring(cloth[y * side + x + 1], cloth[(y + 1) * side + x], diagonal, stiffness, friction));
+			}
+		}
+	}
+
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+
+}
+
+static void BuildCloth64(Physics::Scene* scene, std::mt19937& rng) { BuildCloth(scene, 64, 200.0f); }
+static void BuildCloth1M(Physics::Scene* scene, std::mt19937& rng) { BuildCloth(scene, 500, 200.0f); }
+
+//Springs a hundred times stiffer, far past what explicit integration survives at 60Hz without substeps
+static void BuildClothStiff(Physics::Scene* scene, std::mt19937& rng) {
+	scene->GetSpringSettings().integration = Physics::SpringIntegration::IMPLICIT;
+	BuildCloth(scene, 64, 20000.0f);
+}
+
+//The default pit under fire from BallPitApp's shift-click shooter, fired from the app's starting camera
+static void BarrageStep(Physics::Scene* scene, std::mt19937& rng, int step) {
+
+	if(step % 5 != 0)	return;
+
+	glm::vec3 origin(5, 10, 5);
+	glm::vec3 target(RandomRange(rng, -5.0f, 5.0f), RandomRange(rng, 0.0f, 3.0f), RandomRange(rng, -5.0f, 5.0f));
+
+	float shotSpeed = 20.0f;
+	Physics::Object* obj = scene->CreateObject();
+	obj->SetPosition(origin);
+	obj->SetVelocity(glm::normalize(target - origin) * shotSpeed);
+	obj->SetCollider(scene->CreateSphereCollider(0.25f));
+	obj->SetMass(10.0f);
+	obj->SetBounciness(5);
+	scene->AttachObject(obj);
+
+}
+
+//A thin wall with projectiles fired at it far faster than its thickness per step. Without continuous collision
+//most of them pass straight through. The wall is much wider than the spread of shots, though the pile that builds
+//up against it still throws the odd ball round the edge
+static const float PROJECTILE_WALL_X = 10.0f;
+static const float PROJECTILE_WALL_HALF_WIDTH = 0.05f;
+
+static void BuildProjectiles(Physics::Scene* scene, std::mt19937& rng) {
+
+	Physics::Object* wall = scene->CreateObject();
+	wall->SetPosition(glm::vec3(PROJECTILE_WALL_X, 10, 0));
+	wall->SetCollider(scene->CreateAABBCollider(glm::vec3(PROJECTILE_WALL_HALF_WIDTH, 50.0f, 50.0f)));
+	wall->SetRigid(true);
+	scene->AttachObject(wall);
+
+}
+
+static void ProjectilesStep(Physics::Scene* scene, std::mt19937& rng, int step) {
+
+	float shotSpeed = 170.0f;
+	for(int i = 0; i < 10; i++) {
+		Physics::Object* obj = AddBall(scene, glm::vec3(0, RandomRange(rng, 1.0f, 19.0f), RandomRange(rng, -9.0f, 9.0f)), 0.25f);
+		obj->SetVelocity(glm::vec3(shotSpeed, 0, 0));
+		obj->SetMaxVelocity(glm::vec3(shotSpeed));
+		obj->SetMass(10.0f);
+		obj->SetBounciness(0.5f);
+		obj->SetContinuous(true);
+	}
+
+}
+
+static uint32_t CountProjectilesThroughWall(const Physics::Scene* scene) {
+
+	uint32_t escaped = 0;
+	const Physics::BodyStore& bodies = scene->GetBodies();
+	for(size_t i = 0; i < bodies.Size(); i++) {
+		//Behind the wall and within its span, so not just thrown round the edge by the pile
+		if(bodies.position.x[i] > PROJECTILE_WALL_X + PROJECTILE_WALL_HALF_WIDTH &&
+		   std::abs(bodies.position.y[i] - 10.0f) < 50.0f && std::abs(bodies.position.z[i]) < 50.0f)
+			escaped++;
+	}
+	return escaped;
+
+}
+
+static const Scenario SCENARIOS[] = {
+	{ "pit",			600,	BuildDefaultPit,		nullptr,			nullptr },
+	{ "pit_1k",			300,	BuildPit1k,				nullptr,			nullptr },
+	{ "pit_10k",		100,	BuildPit10k,			nullptr,			nullptr },
+	{ "pit_100k",		20,		BuildPit100k,			nullptr,			nullptr },
+	{ "pit_1m",			5,		BuildPit1M,				nullptr,			nullptr },
+	{ "pit_mixed",		100,	BuildPitMixed,			nullptr,			nullptr },
+	{ "rain",			600,	BuildRain,				RainStep,			nullptr },
+	{ "spring_lattice",	300,	BuildSpringLattice,		nullptr,			nullptr },
+	{ "cloth",			300,	BuildCloth64,			nullptr,			nullptr },
+	{ "cloth_1m",		10,		BuildCloth1M,			nullptr,			nullptr },
+	{ "cloth_stiff",	300,	BuildClothStiff,		nullptr,			nullptr },
+	{ "barrage",		600,	BuildDefaultPit,		BarrageStep,		nullptr },
+	{ "projectiles",	300,	BuildProjectiles,		ProjectilesStep,	CountProjectilesThroughWall },
+};
+
+static const char* GetBroadphaseName(Physics::BroadphaseType type) {
+
+	switch(type) {
+		case Physics::BroadphaseType::SWEEP_AND_PRUNE:	return "sap";
+		case Physics::BroadphaseType::SPATIAL_HASH:		return "grid";
+		case Physics::BroadphaseType::OCTREE:			return "octree";
+		case Physics::BroadphaseType::DYNAMIC_TREE:
+		default:										return "tree";
+	}
+
+}
+
+static bool ParseBroadphase(const char* name, Physics::BroadphaseType& type) {
+
+	for(int i = 0; i <= (int)Physics::BroadphaseType::OCTREE; i++) {
+		if(strcmp(name, GetBroadphaseName((Physics::BroadphaseType)i)) == 0) {
+			type = (Physics::BroadphaseType)i;
+			return true;
+		}
+	}
+	return false;
+
+}
+
+//Nanoseconds per zone with the profiler off and on, over a loop of empty zones
+struct ZoneCostResult {
+	double disabledNs = 0.0;
+	double enabledNs = 0.0;
+};
+
+static ZoneCostResult MeasureZoneCost() {
+
+	ZoneCostResult result;
+#if PHYSICS_PROFILING
+	const int zones = 1000000;
+	bool enabled = Physics::Profiler::IsEnabled();
+
+	Physics::Profiler::SetEnabled(false);
+	double start = Now();
+	for(int i = 0; i < zones; i++) {
+		PHYSICS_ZONE("Zone cost");
+	}
+	result.disabledNs = (Now() - start) * 1e6 / zones;
+
+	Physics::Profiler::SetEnabled(true);
+	start = Now();
+	for(int i = 0; i < zones; i++) {
+		PHYSICS_ZONE("Zone cost");
+	}
+	result.enabledNs = (Now() - start) * 1e6 / zones;
+
+	//The loop filled the rings with nothing of interest
+	Physics::Profiler::Clear();
+	Physics::Profiler::SetEnabled(enabled);
+#endif
+	return result;
+
+}
+
+static ScenarioResult RunScenario(const Scenario& scenario, const BenchmarkOptions& options) {
+
+	ScenarioResult result;
+	result.name = scenario.name;
+	result.steps = (options.steps > 0) ? options.steps : scenario.defaultSteps;
+
+	std::mt19937 rng(options.seed);
+	BenchmarkSink sink;
+
+	double setupStart = Now();
+
+	Physics::Scene* scene = new Physics::Scene();
+	scene->SetBroadphase(options.broadphase);
+	scene->SetThreadCount(options.threads);
+	scene->SetSingleThreaded(options.deterministic);
+	if(options.implicitSprings)
+		scene->GetSpringSettings().integration = Physics::SpringIntegration::IMPLICIT;
+	scene->SetSubsteps(options.substeps);
+	scene->SetAdaptiveSubsteps(options.adaptive);
+	scene->GetContinuousCollision().SetEnabled(options.ccd);
+	scene->GetCollisionEvents().SetEnabled(options.collisionEvents);
+	scenario.build(scene, rng);
+
+	result.setupMs = Now() - setupStart;
+	result.startBodies = scene->GetObjects().size();
+
+	//Timing starts once the scene is built so setup doesn't land in the first step
+	scene->SetProfileSink(&sink);
+	uint64_t zonesBefore = Physics::Profiler::GetRecordedCount();
+
+	for(int step = 0; step < result.steps; step++) {
+
+		if(scenario.beforeStep != nullptr)
+			scenario.beforeStep(scene, rng, step);
+
+		double stepStart = Now();
+		scene->FixedUpdate();
+		double stepMs = Now() - stepStart;
+
+		result.stepMs += stepMs;
+		if(step == 0)
+			result.firstStepMs = stepMs;
+		if(stepMs > result.maxStepMs)
+			result.maxStepMs = stepMs;
+
+		result.substeps += scene->GetLastSubstepCount();
+		result.pairsTested += scene->GetCandidatePairCount();
+		result.contacts += scene->GetCollisionCount();
+		result.contactsReused += scene->GetReusedContactCount();
+		result.fastBodies += scene->GetContinuousCollision().GetFastBodyCount();
+		result.impacts += scene->GetContinuousCollision().GetImpactCount();
+		if(scene->GetSpringSettings().integration == Physics::SpringIntegration::IMPLICIT)
+			result.springIterations += scene->GetSpringSolver().GetLastIterations();
+		result.eventsBegin += scene->GetCollisionEvents().GetBegins().size();
+		result.eventsStay += scene->GetCollisionEvents().GetStays().size();
+		result.eventsEnd += scene->GetCollisionEvents().GetEnds().size();
+
+	}
+
+	result.zones = Physics::Profiler::GetRecordedCount() - zonesBefore;
+	result.endBodies = scene->GetObjects().size();
+	result.constraints = scene->GetConstraints().size();
+	result.sleepingEnd = scene->GetIslands().GetSleepingCount();
+	if(scenario.countEscaped != nullptr) {
+		result.checksEscaped = true;
+		result.escaped = scenario.countEscaped(scene);
+	}
+	result.objectPoolPeak = scene->GetObjectPool().GetPeakCount();
+	result.colliderPoolPeak = scene->GetSphereColliderPool().GetPeakCount() + scene->GetAABBColliderPool().GetPeakCount();
+	result.poolBytes = scene->GetObjectPool().GetCapacityBytes() + scene->GetSphereColliderPool().GetCapacityBytes() +
+		scene->GetAABBColliderPool().GetCapacityBytes();
+	result.scratchPeak = scene->GetScratch().GetPeak();
+	result.stateHash = HashState(scene->GetBodies());
+	const Physics::BodyStore& bodies = scene->GetBodies();
+	for(size_t i = 0; i < bodies.Size(); i++)
+		result.maxSpeedEnd = std::max(result.maxSpeedEnd, glm::length(bodies.velocity.Get(i)));
+	for(int i = 0; i < (int)Physics::ProfilePhase::COUNT; i++) {
+		result.phaseTotal[i] = sink.GetTotal((Physics::ProfilePhase)i);
+		result.phaseMax[i] = sink.GetMax((Physics::ProfilePhase)i);
+	}
+
+	delete scene;
+
+	return result;
+
+}
+
+struct KernelCheckResult {
+	uint32_t pairs = 0;
+	uint32_t contacts = 0;
+	//Contacts differing from the scalar path at each SIMD level
+	uint32_t mismatches[(int)Physics::SimdLevel::AVX2 + 1] = {};
+};
+
+static bool ContactsMatch(const Physics::Contact& a, const Physics::Contact& b) {
+	return a.a == b.a && a.b == b.b && a.intersection.intersectionType == b.intersection.intersectionType &&
+		memcmp(&a.intersection.collisionVector, &b.intersection.collisionVector, sizeof(glm::vec3)) == 0;
+}
+
+//Runs the sphere kernel at every level the CPU supports over the same random pairs and compares each against the
+//scalar path bit for bit. Some spheres share a centre so the coincident case is covered too
+static KernelCheckResult CheckSphereKernel(unsigned int seed) {
+
+	KernelCheckResult result;
+	std::mt19937 rng(seed);
+
+	Physics::Scene* scene = new Physics::Scene();
+	for(int i = 0; i < 4096; i++) {
+		glm::vec3 pos(RandomRange(rng, -8.0f, 8.0f), RandomRange(rng, -8.0f, 8.0f), RandomRange(rng, -8.0f, 8.0f));
+		if(i % 64 == 1)
+			pos = scene->GetObjects()[i - 1]->GetPosition();
+		AddBall(scene, pos, RandomRange(rng, 0.25f, 1.5f));
+	}
+
+	std::vector<Physics::BodyPair> pairs;
+	std::uniform_int_distribution<uint32_t> body(0, 4095);
+	for(int i = 0; i < 100003; i++) {
+		uint32_t a = body(rng);
+		uint32_t b = (i % 64 == 0) ? (a ^ 1) : body(rng);
+		if(a != b)
+			pairs.push_back({ a, b });
+	}
+	result.pairs = (uint32_t)pairs.size();
+
+	std::vector<Physics::Contact> reference;
+	Physics::SphereSphereBatch(Physics::SimdLevel::SCALAR, scene->GetBodies(), pairs.data(), result.pairs, reference);
+	result.contacts = (uint32_t)reference.size();
+
+	for(int level = (int)Physics::SimdLevel::SSE; level <= (int)Physics::GetSupportedSimdLevel(); level++) {
+
+		std::vector<Physics::Contact> contacts;
+		Physics::SphereSphereBatch((Physics::SimdLevel)level, scene->GetBodies(), pairs.data(), result.pairs, contacts);
+
+		size_t common = std::min(contacts.size(), reference.size());
+		uint32_t mismatches = (uint32_t)(std::max(contacts.size(), reference.size()) - common);
+		for(size_t i = 0; i < common; i++) {
+			if(!ContactsMatch(contacts[i], reference[i]))
+				mismatches++;
+		}
+		result.mismatches[level] = mismatches;
+
+	}
+
+	delete scene;
+
+	return result;
+
+}
+
+struct ReuseCheckResult {
+	uint32_t steps = 0;
+	//Steps where the pair was still in contact, reused or not, with the spheres apart
+	uint32_t staleContacts = 0;
+	float endDistance = 0.0f;
+};
+
+//Two spheres pulled apart diagonally by less than the contact reuse tolerance each step. Reuse is measured from
+//when the contact was generated, so the slow drift still adds up and the contact has to end once they separate
+static ReuseCheckResult CheckContactReuse() {
+
+	ReuseCheckResult result;
+
+	Physics::Scene* scene = new Physics::Scene();
+	scene->SetGravity(glm::vec3(0));
+	Physics::Object* a = AddBall(scene, glm::vec3(0, 5, 0), 0.5f);
+	Physics::Object* b = AddBall(scene, glm::vec3(0.9f, 5, 0), 0.5f);
+
+	const float drift = 0.0005f / std::sqrt(2.0f);
+	const float tolerance = scene->GetContactCache().GetReuseTolerance();
+	glm::vec3 position = b->GetPosition();
+	for(; result.steps < 800; result.steps++) {
+
+		position += glm::vec3(drift, drift, 0);
+		a->SetPosition(glm::vec3(0, 5, 0));
+		a->SetVelocity(glm::vec3(0));
+		b->SetPosition(position);
+		b->SetVelocity(glm::vec3(0));
+
+		//Apart as the narrowphase sees them, the solver may push them further during the step
+		result.endDistance = glm::length(position - glm::vec3(0, 5, 0));
+		scene->FixedUpdate();
+
+		//Reuse allows up to the tolerance of movement, so only count contacts further apart than that
+		if(result.endDistance > 1.0f + tolerance && scene->GetCollisionCount() > 0)
+			result.staleContacts++;
+
+	}
+
+	delete scene;
+
+	return result;
+
+}
+
+static void WriteResult(FILE* out, const ScenarioResult& result, const ZoneCostResult& zoneCost, bool last) {
+
+	fprintf(out, "    {\n");
+	fprintf(out, "      \"name\": \"%s\",\n", result.name.c_str());
+	fprintf(out, "      \"steps\": %d,\n", result.steps);
+	fprintf(out, "      \"substeps\": %llu,\n", (unsigned long long)result.substeps);
+	fprintf(out, "      \"bodies_start\": %zu,\n", result.startBodies);
+	fprintf(out, "      \"bodies_end\": %zu,\n", result.endBodies);
+	fprintf(out, "      \"constraints\": %zu,\n", result.constraints);
+	fprintf(out, "      \"sleeping_end\": %u,\n", result.sleepingEnd);
+	fprintf(out, "      \"setup_ms\": %.4f,\n", result.setupMs);
+	fprintf(out, "      \"first_step_ms\": %.4f,\n", result.firstStepMs);
+	fprintf(out, "      \"step_ms_total\": %.4f,\n", result.stepMs);
+	fprintf(out, "      \"step_ms_mean\": %.6f,\n", result.stepMs / result.steps);
+	fprintf(out, "      \"step_ms_max\": %.6f,\n", result.maxStepMs);
+	fprintf(out, "      \"pairs_tested\": %llu,\n", (unsigned long long)result.pairsTested);
+	fprintf(out, "      \"contacts\": %llu,\n", (unsigned long long)result.contacts);
+	fprintf(out, "      \"contacts_reused\": %llu,\n", (unsigned long long)result.contactsReused);
+	fprintf(out, "      \"ccd_fast_bodies\": %llu,\n", (unsigned long long)result.fastBodies);
+	fprintf(out, "      \"ccd_impacts\": %llu,\n", (unsigned long long)result.impacts);
+	if(result.checksEscaped)
+		fprintf(out, "      \"escaped\": %u,\n", result.escaped);
+	fprintf(out, "      \"object_pool_peak\": %zu,\n", result.objectPoolPeak);
+	fprintf(out, "      \"collider_pool_peak\": %zu,\n", result.colliderPoolPeak);
+	fprintf(out, "      \"pool_bytes\": %zu,\n", result.poolBytes);
+	fprintf(out, "      \"scratch_peak_bytes\": %zu,\n", result.scratchPeak);
+	fprintf(out, "      \"spring_iterations\": %llu,\n", (unsigned long long)result.springIterations);
+	fprintf(out, "      \"max_speed_end\": %.4f,\n", result.maxSpeedEnd);
+	fprintf(out, "      \"state_hash\": \"%016llx\",\n", (unsigned long long)result.stateHash);
+	fprintf(out, "      \"zones\": %llu,\n", (unsigned long long)result.zones);
+	fprintf(out, "      \"collision_events\": { \"begin\": %llu, \"stay\": %llu, \"end\": %llu },\n", (unsigned long long)result.eventsBegin,
+		(unsigned long long)result.eventsStay, (unsigned long long)result.eventsEnd);
+	if(result.profiled) {
+		//The two runs differ by more than the zones cost on a busy machine, so the estimate from the zone count and
+		//the measured cost per zone goes alongside
+		fprintf(out, "      \"step_ms_profiled\": %.4f,\n", result.profiledStepMs);
+		fprintf(out, "      \"profile_overhead_pct\": %.2f,\n", (result.profiledStepMs / result.stepMs - 1.0) * 100.0);
+		fprintf(out, "      \"profile_overhead_est_pct\": %.4f,\n", result.zones * zoneCost.enabledNs * 1e-6 / result.stepMs * 100.0);
+	}
+	fprintf(out, "      \"phases\": {\n");
+
+	for(int i = 0; i < (int)Physics::ProfilePhase::COUNT; i++) {
+		std::string name = Physics::GetPhaseName((Physics::ProfilePhase)i);
+		for(auto& c : name)
+			c = (char)tolower(c);
+		fprintf(out, "        \"%s\": { \"total_ms\": %.4f, \"mean_ms\": %.6f, \"max_ms\": %.6f }%s\n", name.c_str(),
+			result.phaseTotal[i], result.phaseTotal[i] / result.steps, result.phaseMax[i],
+			(i + 1 < (int)Physics::ProfilePhase::COUNT) ? "," : "");
+	}
+
+	fprintf(out, "      }\n");
+	fprintf(out, "    }%s\n", last ? "" : ",");
+
+}
+
+static void PrintUsage() {
+
+	fprintf(stderr, "Usage: BallPitBenchmark [options]\n");
+	fprintf(stderr, "  --scenario <name|all>   scenario to run (default all)\n");
+	fprintf(stderr, "  --steps <n>             steps per scenario, overriding each scenario's default\n");
+	fprintf(stderr, "  --seed <n>              random seed (default 1)\n");
+	fprintf(stderr, "  --broadphase <name>     tree, sap, grid or octree (default tree)\n");
+	fprintf(stderr, "  --threads <n>           threads including the main thread, 0 for all (default 0)\n");
+	fprintf(stderr, "  --substeps <n>          substeps per step, the minimum when adaptive (default 1)\n");
+	fprintf(stderr, "  --adaptive              pick substeps per step from body speed and collider size\n");
+	fprintf(stderr, "  --no-ccd                disable continuous collision for flagged bodies\n");
+	fprintf(stderr, "  --implicit-springs      integrate every scenario's springs with backward Euler\n");
+	fprintf(stderr, "  --deterministic         run every phase inline on the main thread, for debugging\n");
+	fprintf(stderr, "  --collision-events      diff contacts into begin, stay and end events every step\n");
+	fprintf(stderr, "  --trace <file>          record profiling zones and write them as a Chrome trace\n");
+	fprintf(stderr, "  --profile-overhead      rerun each scenario with zones recording and report the slowdown\n");
+	fprintf(stderr, "  --out <file>            write JSON to a file instead of stdout\n");
+	fprintf(stderr, "Scenarios:");
+	for(auto& scenario : SCENARIOS)
+		fprintf(stderr, " %s", scenario.name);
+	fprintf(stderr, "\n");
+
+}
+
+int main(int argc, char** argv) {
+
+	BenchmarkOptions options;
+
+	for(int i = 1; i < argc; i++) {
+
+		bool hasValue = i + 1 < argc;
+
+		if(strcmp(argv[i], "--scenario") == 0 && hasValue) {
+			options.scenario = argv[++i];
+		} else if(strcmp(argv[i], "--steps") == 0 && hasValue) {
+			options.steps = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--seed") == 0 && hasValue) {
+			options.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		} else if(strcmp(argv[i], "--threads") == 0 && hasValue) {
+			options.threads = (uint32_t)atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--substeps") == 0 && hasValue) {
+			options.substeps = (uint32_t)atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--adaptive") == 0) {
+			options.adaptive = true;
+		} else if(strcmp(argv[i], "--no-ccd") == 0) {
+			options.ccd = false;
+		} else if(strcmp(argv[i], "--deterministic") == 0) {
+			options.deterministic = true;
+		} else if(strcmp(argv[i], "--implicit-springs") == 0) {
+			options.implicitSprings = true;
+		} else if(strcmp(argv[i], "--collision-events") == 0) {
+			options.collisionEvents = true;
+		} else if(strcmp(argv[i], "--trace") == 0 && hasValue) {
+			options.tracePath = argv[++i];
+		} else if(strcmp(argv[i], "--profile-overhead") == 0) {
+			options.profileOverhead = true;
+		} else if(strcmp(argv[i], "--out") == 0 && hasValue) {
+			options.outPath = argv[++i];
+		} else if(strcmp(argv[i], "--broadphase") == 0 && hasValue) {
+			if(!ParseBroadphase(argv[++i], options.broadphase)) {
+				fprintf(stderr, "Unknown broadphase %s\n", argv[i]);
+				return 1;
+			}
+		} else {
+			PrintUsage();
+			return 1;
+		}
+
+	}
+
+	std::vector<const Scenario*> selected;
+	for(auto& scenario : SCENARIOS) {
+		if(options.scenario == "all" || options.scenario == scenario.name)
+			selected.push_back(&scenario);
+	}
+
+	if(selected.empty()) {
+		fprintf(stderr, "Unknown scenario %s\n", options.scenario.c_str());
+		PrintUsage();
+		return 1;
+	}
+
+#if !PHYSICS_PROFILING
+	if(!options.tracePath.empty() || options.profileOverhead) {
+		fprintf(stderr, "Profiling zones were compiled out\n");
+		return 1;
+	}
+#endif
+
+	KernelCheckResult kernelCheck = CheckSphereKernel(options.seed);
+	ReuseCheckResult reuseCheck = CheckContactReuse();
+	ZoneCostResult zoneCost = MeasureZoneCost();
+
+	Physics::Profiler::SetEnabled(!options.tracePath.empty());
+
+	std::vector<ScenarioResult> results;
+	for(auto scenario : selected) {
+
+		fprintf(stderr, "Running %s...\n", scenario->name);
+		results.push_back(RunScenario(*scenario, options));
+
+		//Same seed and settings, so the only difference is the zones recording. Rings are cleared after so the
+		//rerun doesn't crowd the traced run out of them
+		if(options.profileOverhead) {
+			fprintf(stderr, "Running %s with zones...\n", scenario->name);
+			bool tracing = Physics::Profiler::IsEnabled();
+			Physics::Profiler::SetEnabled(true);
+			ScenarioResult profiled = RunScenario(*scenario, options);
+			results.back().profiled = true;
+			results.back().profiledStepMs = profiled.stepMs;
+			if(!tracing) {
+				results.back().zones = profiled.zones;
+				Physics::Profiler::Clear();
+			}
+			Physics::Profiler::SetEnabled(tracing);
+		}
+
+	}
+
+	Physics::Profiler::SetEnabled(false);
+	if(!options.tracePath.empty() && !Physics::Profiler::WriteChromeTrace(options.tracePath.c_str())) {
+		fprintf(stderr, "Could not write %s\n", options.tracePath.c_str());
+		return 1;
+	}
+
+	FILE* out = stdout;
+	if(!options.outPath.empty()) {
+		out = fopen(options.outPath.c_str(), "w");
+		if(out == nullptr) {
+			fprintf(stderr, "Could not open %s\n", options.outPath.c_str());
+			return 1;
+		}
+	}
+
+	//Counted the way each scene's JobSystem counts them, without starting a pool just to ask
+	uint32_t threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+	fprintf(out, "{\n");
+	fprintf(out, "  \"seed\": %u,\n", options.seed);
+	fprintf(out, "  \"broadphase\": \"%s\",\n", GetBroadphaseName(options.broadphase));
+	fprintf(out, "  \"threads\": %u,\n", threads);
+	fprintf(out, "  \"substeps\": %u,\n", options.substeps);
+	fprintf(out, "  \"adaptive\": %s,\n", options.adaptive ? "true" : "false");
+	fprintf(out, "  \"ccd\": %s,\n", options.ccd ? "true" : "false");
+	fprintf(out, "  \"deterministic\": %s,\n", options.deterministic ? "true" : "false");
+	fprintf(out, "  \"implicit_springs\": %s,\n", options.implicitSprings ? "true" : "false");
+	fprintf(out, "  \"collision_events\": %s,\n", options.collisionEvents ? "true" : "false");
+	fprintf(out, "  \"profiling\": {\n");
+	fprintf(out, "    \"compiled\": %s,\n", PHYSICS_PROFILING ? "true" : "false");
+	fprintf(out, "    \"traced\": %s,\n", options.tracePath.empty() ? "false" : "true");
+	fprintf(out, "    \"zone_ns_disabled\": %.3f,\n", zoneCost.disabledNs);
+	fprintf(out, "    \"zone_ns_enabled\": %.3f\n", zoneCost.enabledNs);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"simd\": \"%s\",\n", Physics::GetSimdLevelName(Physics::GetSupportedSimdLevel()));
+	fprintf(out, "  \"sphere_kernel_check\": {\n");
+	fprintf(out, "    \"pairs\": %u,\n", kernelCheck.pairs);
+	fprintf(out, "    \"contacts\": %u,\n", kernelCheck.contacts);
+	fprintf(out, "    \"mismatches\": {");
+	for(int level = (int)Physics::SimdLevel::SSE; level <= (int)Physics::GetSupportedSimdLevel(); level++)
+		fprintf(out, "%s \"%s\": %u", (level > (int)Physics::SimdLevel::SSE) ? "," : "", Physics::GetSimdLevelName((Physics::SimdLevel)level), kernelCheck.mismatches[level]);
+	fprintf(out, " }\n");
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"contact_reuse_check\": {\n");
+	fprintf(out, "    \"steps\": %u,\n", reuseCheck.steps);
+	fprintf(out, "    \"end_distance\": %.4f,\n", reuseCheck.endDistance);
+	fprintf(out, "    \"stale_contacts\": %u\n", reuseCheck.staleContacts);
+	fprintf(out, "  },\n");
+	fprintf(out, "  \"scenarios\": [\n");
+	for(size_t i = 0; i < results.size(); i++)
+		WriteResult(out, results[i], zoneCost, i + 1 == results.size());
+	fprintf(out, "  ]\n");
+	fprintf(out, "}\n");
+
+	if(out != stdout)
+		fclose(out);
+
+	//A SIMD path disagreeing with the scalar one is a bug, fail the run so scripts notice
+	for(auto mismatches : kernelCheck.mismatches) {
+		if(mismatches > 0) {
+			fprintf(stderr, "Sphere kernel SIMD results differ from scalar\n");
+			return 2;
+		}
+	}
+
+	//A contact outliving the overlap it came from means reuse has drifted away from the geometry
+	if(reuseCheck.staleContacts > 0) {
+		fprintf(stderr, "Reused contacts outlived their overlap\n");
+		return 2;
+	}
+
+	return 0;
+
+}
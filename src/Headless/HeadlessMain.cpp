@@ -0,0 +1,108 @@
+#include "Physics/PhysicsScene.hpp"
+#include "Physics/PhysicsObject.hpp"
+#include "Physics/SphereCollider.hpp"
+#include "Physics/AABBCollider.hpp"
+#include "Physics/ProfileSink.hpp"
+
+#include <glm/vec3.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//Accumulates phase timings over a run so they can be averaged at the end
+class AccumulatingSink : public Physics::ProfileSink {
+public:
+	AccumulatingSink() {
+		for(auto& total : m_Totals)
+			total = 0.0;
+	}
+
+	virtual void Record(Physics::ProfilePhase phase, double milliseconds) {
+		m_Totals[(int)phase] += milliseconds;
+	}
+
+	double GetTotal(Physics::ProfilePhase phase) const { return m_Totals[(int)phase]; }
+
+protected:
+
+	double m_Totals[(int)Physics::ProfilePhase::COUNT];
+
+};
+
+//Builds the same pit BallPitApp::startup creates, without any rendering
+void BuildBallPit(Physics::Scene* scene) {
+
+	for(int x = -5; x < 5; x++) {
+		for(int y = 1; y < 4; y++) {
+			for(int z = -5; z < 5; z++) {
+				Physics::Object* obj = new Physics::Object();
+				obj->SetPosition(glm::vec3(x + 0.5f, y, z + 0.5f));
+				obj->SetCollider(new Physics::SphereCollider(0.5f));
+				scene->AttachObject(obj);
+			}
+		}
+	}
+
+	float border = 7.5f;
+	float height = 2.0f;
+
+	glm::vec3 borderPositions[] = {
+		glm::vec3(-border - 4, 1, 0), glm::vec3(border + 4, 1, 0),
+		glm::vec3(0, 1, -border - 4), glm::vec3(0, 1, border + 4)
+	};
+	glm::vec3 borderExtents[] = {
+		glm::vec3(5.0f, height + 0.5f, border + 4.5f), glm::vec3(5.0f, height + 0.5f, border + 4.5f),
+		glm::vec3(border + 4.5f, height + 0.5f, 5.0f), glm::vec3(border + 4.5f, height + 0.5f, 5.0f)
+	};
+
+	for(int i = 0; i < 4; i++) {
+		Physics::Object* wall = new Physics::Object();
+		wall->SetPosition(borderPositions[i]);
+		wall->SetCollider(new Physics::AABBCollider(borderExtents[i]));
+		wall->SetRigid(true);
+		scene->AttachObject(wall);
+	}
+
+	scene->SetGravity(glm::vec3(0, -9.8f, 0));
+
+}
+
+int main(int argc, char** argv) {
+
+	int steps = (argc > 1) ? atoi(argv[1]) : 600;
+	if(steps <= 0)	steps = 600;
+
+	Physics::BroadphaseType broadphase = Physics::BroadphaseType::DYNAMIC_TREE;
+	if(argc > 2 && strcmp(argv[2], "sap") == 0)
+		broadphase = Physics::BroadphaseType::SWEEP_AND_PRUNE;
+	else if(argc > 2 && strcmp(argv[2], "grid") == 0)
+		broadphase = Physics::BroadphaseType::SPATIAL_HASH;
+	else if(argc > 2 && strcmp(argv[2], "octree") == 0)
+		broadphase = Physics::BroadphaseType::OCTREE;
+
+	uint32_t threads = (argc > 3) ? (uint32_t)atoi(argv[3]) : 0;
+
+	AccumulatingSink sink;
+
+	Physics::Scene* scene = new Physics::Scene();
+	scene->SetProfileSink(&sink);
+	scene->SetBroadphase(broadphase);
+	scene->SetThreadCount(threads);
+	BuildBallPit(scene);
+
+	for(int i = 0; i < steps; i++)
+		scene->FixedUpdate();
+
+	const Physics::BodyStore& bodies = scene->GetBodies();
+	printf("Stepped %d bodies for %d steps\n", (int)bodies.Size(), steps);
+	printf("Last step: %d candidate pairs, %d collisions\n", (int)scene->GetCandidatePairCount(), (int)scene->GetCollisionCount());
+	printf("Body storage: %d bytes per body, %d bytes reserved\n", (int)Physics::BodyStore::GetBytesPerBody(), (int)bodies.GetMemoryUsage());
+	for(int i = 0; i < (int)Physics::ProfilePhase::COUNT; i++) {
+		Physics::ProfilePhase phase = (Physics::ProfilePhase)i;
+		printf("%-12s total %10.3fms  avg %8.4fms\n", Physics::GetPhaseName(phase), sink.GetTotal(phase), sink.GetTotal(phase) / steps);
+	}
+
+	delete scene;
+
+	return 0;
+}
@@ -15,9 +15,9 @@ namespace Physics {
 	AABBCollider::~AABBCollider() {
 	}
 
-	void AABBCollider::Transform(Object * obj) {
+	glm::vec3 AABBCollider::GetCentre() const {
 
-		m_Centre = obj->GetPosition();
+		return (m_Owner != nullptr) ? m_Owner->GetPosition() : glm::vec3(0);
 
 	}
 
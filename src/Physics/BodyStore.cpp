@@ -0,0 +1,280 @@
+#include "Physics/BodyStore.hpp"
+#include "Physics/PhysicsObject.hpp"
+#include "Physics/SphereCollider.hpp"
+#include "Physics/AABBCollider.hpp"
+
+namespace Physics {
+
+	template<typename T>
+	static void SwapRemove(std::vector<T>& vec, size_t i) {
+		vec[i] = vec.back();
+		vec.pop_back();
+	}
+
+	template<typename T>
+	static size_t CapacityBytes(const std::vector<T>& vec) {
+		return vec.capacity() * sizeof(T);
+	}
+
+	void Vec3Array::PushBack(const glm::vec3 & v) {
+		x.push_back(v.x);
+		y.push_back(v.y);
+		z.push_back(v.z);
+	}
+
+	void Vec3Array::SwapRemove(size_t i) {
+		Physics::SwapRemove(x, i);
+		Physics::SwapRemove(y, i);
+		Physics::SwapRemove(z, i);
+	}
+
+	void Vec3Array::Reserve(size_t count) {
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+	}
+
+	size_t Vec3Array::GetCapacityBytes() const {
+		return CapacityBytes(x) + CapacityBytes(y) + CapacityBytes(z);
+	}
+
+	uint32_t BodyStore::Add(Object * obj) {
+
+		uint32_t index = (uint32_t)objects.size();
+
+		position.PushBack(obj->m_Position);
+		velocity.PushBack(obj->m_Velocity);
+		acceleration.PushBack(obj->m_Acceleration);
+		maxVelocity.PushBack(obj->m_MaxVelocity);
+		previousPosition.PushBack(obj->m_Position);
+
+		mass.push_back(obj->m_Mass);
+		invMass.push_back(1.0f / obj->m_Mass);
+		friction.push_back(obj->m_Friction);
+		bounciness.push_back(obj->m_Bounciness);
+		flags.push_back((obj->m_Rigid ? BODY_RIGID : 0) | (obj->m_Continuous ? BODY_CONTINUOUS : 0));
+
+		boundsMin.PushBack(obj->m_Position);
+		boundsMax.PushBack(obj->m_Position);
+
+		contactCount.push_back(0);
+
+		sleepTime.push_back(0.0f);
+		sleepIsland.push_back(0);
+
+		colliderType.push_back(Collider::ColliderType::NONE);
+		colliderIndex.push_back(0);
+
+		objects.push_back(obj);
+
+		AddToGroup(index, obj->m_Collider);
+		UpdateBounds(index);
+
+		obj->m_Store = this;
+		obj->m_Index = index;
+
+		return index;
+
+	}
+
+	void BodyStore::Remove(uint32_t index) {
+
+		Object* obj = objects[index];
+
+		//Hand the state back so the object is still valid once detached
+		obj->m_Position = position.Get(index);
+		obj->m_Velocity = velocity.Get(index);
+		obj->m_Acceleration = acceleration.Get(index);
+		obj->m_MaxVelocity = maxVelocity.Get(index);
+		obj->m_Mass = mass[index];
+		obj->m_Friction = friction[index];
+		obj->m_Bounciness = bounciness[index];
+		obj->m_Rigid = (flags[index] & BODY_RIGID) != 0;
+		obj->m_Continuous = (flags[index] & BODY_CONTINUOUS) != 0;
+		obj->m_Store = nullptr;
+		obj->m_Index = 0;
+
+		RemoveFromGroup(index);
+
+		//Collider group entries of the body being moved need to point at its new index
+		uint32_t last = (uint32_t)objects.size() - 1;
+		if(index != last) {
+			switch(colliderType[last]) {
+				case Collider::ColliderType::SPHERE:	spheres.body[colliderIndex[last]] = index;	break;
+				case Collider::ColliderType::AABB:		boxes.body[colliderIndex[last]] = index;	break;
+				default:	break;
+			}
+			objects[last]->m_Index = index;
+		}
+
+		position.SwapRemove(index);
+		velocity.SwapRemove(index);
+		acceleration.SwapRemove(index);
+		maxVelocity.SwapRemove(index);
+		previousPosition.SwapRemove(index);
+
+		Physics::SwapRemove(mass, index);
+		Physics::SwapRemove(invMass, index);
+		Physics::SwapRemove(friction, index);
+		Physics::SwapRemove(bounciness, index);
+		Physics::SwapRemove(flags, index);
+
+		boundsMin.SwapRemove(index);
+		boundsMax.SwapRemove(index);
+
+		Physics::SwapRemove(contactCount, index);
+
+		Physics::SwapRemove(sleepTime, index);
+		Physics::SwapRemove(sleepIsland, index);
+
+		Physics::SwapRemove(colliderType, index);
+		Physics::SwapRemove(colliderIndex, index);
+
+		Physics::SwapRemove(objects, index);
+
+	}
+
+	void BodyStore::Reserve(size_t count) {
+
+		position.Reserve(count);
+		velocity.Reserve(count);
+		acceleration.Reserve(count);
+		maxVelocity.Reserve(count);
+		previousPosition.Reserve(count);
+
+		mass.reserve(count);
+		invMass.reserve(count);
+		friction.reserve(count);
+		bounciness.reserve(count);
+		flags.reserve(count);
+
+		boundsMin.Reserve(count);
+		boundsMax.Reserve(count);
+
+		contactCount.reserve(count);
+
+		sleepTime.reserve(count);
+		sleepIsland.reserve(count);
+
+		colliderType.reserve(count);
+		colliderIndex.reserve(count);
+
+		objects.reserve(count);
+
+	}
+
+	void BodyStore::SetCollider(uint32_t index, Collider * coll) {
+		RemoveFromGroup(index);
+		AddToGroup(index, coll);
+		UpdateBounds(index);
+	}
+
+	void BodyStore::UpdateBounds() {
+
+		boundsMin.x = position.x;	boundsMin.y = position.y;	boundsMin.z = position.z;
+		boundsMax.x = position.x;	boundsMax.y = position.y;	boundsMax.z = position.z;
+
+		for(size_t i = 0; i < spheres.body.size(); i++) {
+			uint32_t body = spheres.body[i];
+			float radius = spheres.radius[i];
+			boundsMin.x[body] -= radius;	boundsMin.y[body] -= radius;	boundsMin.z[body] -= radius;
+			boundsMax.x[body] += radius;	boundsMax.y[body] += radius;	boundsMax.z[body] += radius;
+		}
+
+		for(size_t i = 0; i < boxes.body.size(); i++) {
+			uint32_t body = boxes.body[i];
+			glm::vec3 extents = boxes.extents.Get(i);
+			boundsMin.Set(body, boundsMin.Get(body) - extents);
+			boundsMax.Set(body, boundsMax.Get(body) + extents);
+		}
+
+	}
+
+	void BodyStore::UpdateBounds(uint32_t index) {
+
+		glm::vec3 pos = position.Get(index);
+		glm::vec3 extents(0);
+
+		switch(colliderType[index]) {
+			case Collider::ColliderType::SPHERE:	extents = glm::vec3(spheres.radius[colliderIndex[index]]);	break;
+			case Collider::ColliderType::AABB:		extents = boxes.extents.Get(colliderIndex[index]);			break;
+			default:	break;
+		}
+
+		boundsMin.Set(index, pos - extents);
+		boundsMax.Set(index, pos + extents);
+
+	}
+
+	size_t BodyStore::GetBytesPerBody() {
+
+		return 7 * 3 * sizeof(float)						//position, velocity, acceleration, max velocity, previous position, bounds
+			+ 4 * sizeof(float) + sizeof(uint8_t)			//mass, inverse mass, friction, bounciness, flags
+			+ sizeof(uint32_t)								//contact count
+			+ sizeof(float) + sizeof(uint32_t)				//sleep time, sleep island
+			+ sizeof(Collider::ColliderType) + sizeof(uint32_t)
+			+ sizeof(Object*);
+
+	}
+
+	size_t BodyStore::GetMemoryUsage() const {
+
+		return position.GetCapacityBytes() + velocity.GetCapacityBytes() + acceleration.GetCapacityBytes() + maxVelocity.GetCapacityBytes()
+			+ previousPosition.GetCapacityBytes() + boundsMin.GetCapacityBytes() + boundsMax.GetCapacityBytes()
+			+ CapacityBytes(mass) + CapacityBytes(invMass) + CapacityBytes(friction) + CapacityBytes(bounciness) + CapacityBytes(flags)
+			+ CapacityBytes(contactCount)
+			+ CapacityBytes(sleepTime) + CapacityBytes(sleepIsland)
+			+ CapacityBytes(colliderType) + CapacityBytes(colliderIndex) + CapacityBytes(objects)
+			+ CapacityBytes(spheres.radius) + CapacityBytes(spheres.body)
+			+ boxes.extents.GetCapacityBytes() + CapacityBytes(boxes.body);
+
+	}
+
+	void BodyStore::AddToGroup(uint32_t index, Collider * coll) {
+
+		Collider::ColliderType type = (coll != nullptr) ? coll->GetType() : Collider::ColliderType::NONE;
+		colliderType[index] = type;
+
+		switch(type) {
+			case Collider::ColliderType::SPHERE:
+				colliderIndex[index] = (uint32_t)spheres.body.size();
+				spheres.radius.push_back(((SphereCollider*)coll)->GetRadius());
+				spheres.body.push_back(index);
+				break;
+			case Collider::ColliderType::AABB:
+				colliderIndex[index] = (uint32_t)boxes.body.size();
+				boxes.extents.PushBack(((AABBCollider*)coll)->GetExtents());
+				boxes.body.push_back(index);
+				break;
+			default:
+				colliderIndex[index] = 0;
+				break;
+		}
+
+	}
+
+	void BodyStore::RemoveFromGroup(uint32_t index) {
+
+		uint32_t slot = colliderIndex[index];
+
+		switch(colliderType[index]) {
+			case Collider::ColliderType::SPHERE:
+				//The group's last entry moves into this slot
+				colliderIndex[spheres.body.back()] = slot;
+				Physics::SwapRemove(spheres.radius, slot);
+				Physics::SwapRemove(spheres.body, slot);
+				break;
+			case Collider::ColliderType::AABB:
+				colliderIndex[boxes.body.back()] = slot;
+				boxes.extents.SwapRemove(slot);
+				Physics::SwapRemove(boxes.body, slot);
+				break;
+			default:
+				break;
+		}
+
+		colliderType[index] = Collider::ColliderType::NONE;
+
+	}
+
+}
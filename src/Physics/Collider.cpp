@@ -1,38 +1,55 @@
 #include "Physics/Collider.hpp"
 #include "Physics/SphereCollider.hpp"
 #include "Physics/AABBCollider.hpp"
+#include "Physics/Pool.hpp"
 
 #include <glm/geometric.hpp>
 #include <iostream>
 
 namespace Physics {
 
-	Collider::Collider(ColliderType type) : m_Type(type) {
+	Collider::Collider(ColliderType type) : m_Type(type), m_Owner(nullptr), m_Pool(nullptr) {
 	}
 
 
 	Collider::~Collider() {
 	}
 
-	bool Collider::Intersects(Collider * other, IntersectData * intersection) {
-		
-		if(m_Type == ColliderType::SPHERE) {
-			switch(other->GetType()) {
-				case ColliderType::SPHERE:
-					return Sphere2Sphere((SphereCollider*)this, (SphereCollider*)other, intersection);
-				case ColliderType::AABB:
-					return Sphere2AABB((SphereCollider*)this, (AABBCollider*)other, intersection);
-			}
-		} else if(m_Type == ColliderType::AABB) {
-			switch(other->GetType()) {
-				case ColliderType::SPHERE:
-					return AABB2Sphere((AABBCollider*)this, (SphereCollider*)other, intersection);
-				case ColliderType::AABB:
-					return AABB2AABB((AABBCollider*)this, (AABBCollider*)other, intersection);
-			}
+	void Collider::Destroy(Collider * coll) {
+
+		if(coll == nullptr)	return;
+
+		BlockPool* pool = coll->m_Pool;
+		if(pool == nullptr) {
+			delete coll;
+			return;
 		}
-		
-		return false;
+
+		coll->~Collider();
+		pool->Free(coll);
+
+	}
+
+	//Single pair tests, adapting the typed functions to one signature so they can sit in a table
+	typedef bool(*IntersectFunc)(Collider* objA, Collider* objB, IntersectData* intersection);
+
+	template<typename A, typename B, bool(*Test)(A*, B*, IntersectData*)>
+	static bool IntersectAs(Collider* objA, Collider* objB, IntersectData* intersection) {
+		return Test(static_cast<A*>(objA), static_cast<B*>(objB), intersection);
+	}
+
+	//Indexed by the types of this collider then the other one. NONE never collides
+	static const IntersectFunc INTERSECT_TABLE[(int)Collider::ColliderType::COUNT][(int)Collider::ColliderType::COUNT] = {
+		{ nullptr, nullptr, nullptr },
+		{ nullptr, IntersectAs<SphereCollider, SphereCollider, Collider::Sphere2Sphere>, IntersectAs<SphereCollider, AABBCollider, Collider::Sphere2AABB> },
+		{ nullptr, IntersectAs<AABBCollider, SphereCollider, Collider::AABB2Sphere>, IntersectAs<AABBCollider, AABBCollider, Collider::AABB2AABB> }
+	};
+
+	bool Collider::Intersects(Collider * other, IntersectData * intersection) {
+
+		IntersectFunc func = INTERSECT_TABLE[(int)m_Type][(int)other->GetType()];
+		return (func != nullptr) ? func(this, other, intersection) : false;
+
 	}
 
 	bool Collider::Sphere2Sphere(SphereCollider * objA, SphereCollider * objB, IntersectData * intersection) {
@@ -52,12 +69,33 @@ namespace Physics {
 
 	}
 
+	//Overlap of a sphere and a box as a vector from the sphere towards the box. Along the line to the closest point,
+	//or through the nearest face when the sphere's centre is inside the box
+	static glm::vec3 SphereBoxPushOut(const glm::vec3& sphereCentre, float sphereRadius, const glm::vec3& closest, float dist,
+									  const glm::vec3& boxCentre, const glm::vec3& extents) {
+
+		if(dist > 0.0f)
+			return (closest - sphereCentre) * ((sphereRadius - dist) / dist);
+
+		glm::vec3 offset = sphereCentre - boxCentre;
+		int axis = 0;
+		for(int i = 1; i < 3; i++) {
+			if(extents[i] - glm::abs(offset[i]) < extents[axis] - glm::abs(offset[axis]))
+				axis = i;
+		}
+
+		glm::vec3 push(0);
+		push[axis] = (offset[axis] < 0.0f ? 1.0f : -1.0f) * (sphereRadius + extents[axis] - glm::abs(offset[axis]));
+		return push;
+
+	}
+
 	bool Collider::Sphere2AABB(SphereCollider * objA, AABBCollider * objB, IntersectData * intersection) {
 
 		//Cache the centre and extents of the AABB and sphere centre
-		auto& boxCentre = objB->GetCentre();
+		glm::vec3 boxCentre = objB->GetCentre();
 		auto& extents = objB->GetExtents();
-		auto& sphereCentre = objA->GetPosition();
+		glm::vec3 sphereCentre = objA->GetPosition();
 		float sphereRadius = objA->GetRadius();
 		
 		//Get the min and max of the box
@@ -75,9 +113,7 @@ namespace Physics {
 		
 		//Store collision data
 		if(intersection != nullptr) {
-			glm::vec3 collisionNormal = glm::normalize(boxCentre - sphereCentre);
-			float overlap = sphereRadius - dist;
-			intersection->collisionVector = collisionNormal * overlap;
+			intersection->collisionVector = SphereBoxPushOut(sphereCentre, sphereRadius, glm::vec3(x, y, z), dist, boxCentre, extents);
 			intersection->intersectionType = CollisionType::SPHERE2AABB;
 		}		
 		
@@ -88,9 +124,9 @@ namespace Physics {
 
 	bool Collider::AABB2Sphere(AABBCollider* objA, SphereCollider* objB, IntersectData* intersection) {
 		//Cache the centre and extents of the AABB and sphere centre
-		auto& boxCentre = objA->GetCentre();
+		glm::vec3 boxCentre = objA->GetCentre();
 		auto& extents = objA->GetExtents();
-		auto& sphereCentre = objB->GetPosition();
+		glm::vec3 sphereCentre = objB->GetPosition();
 		float sphereRadius = objB->GetRadius();
 
 		//Get the min and max of the box
@@ -107,9 +143,7 @@ namespace Physics {
 			glm::pow(z - sphereCentre.z, 2));
 
 		if(intersection != nullptr) {
-			glm::vec3 collisionNormal = glm::normalize(sphereCentre - boxCentre);
-			float overlap = sphereRadius - dist;
-			intersection->collisionVector = collisionNormal * overlap;
+			intersection->collisionVector = -SphereBoxPushOut(sphereCentre, sphereRadius, glm::vec3(x, y, z), dist, boxCentre, extents);
 			intersection->intersectionType = CollisionType::SPHERE2AABB;
 		}
 		
@@ -121,10 +155,10 @@ namespace Physics {
 	bool Collider::AABB2AABB(AABBCollider * objA, AABBCollider * objB, IntersectData * intersection) {
 
 		//Cache box values
-		auto& boxACenter = objA->GetCentre();
+		glm::vec3 boxACenter = objA->GetCentre();
 		auto& boxAExtents = objA->GetExtents();
 
-		auto& boxBCenter = objB->GetCentre();
+		glm::vec3 boxBCenter = objB->GetCentre();
 		auto& boxBExtents = objB->GetExtents();
 
 		//Calculate min and max of both boxes
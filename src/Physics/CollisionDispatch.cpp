@@ -0,0 +1,230 @@
+#include "Physics/CollisionDispatch.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/SphereKernel.hpp"
+
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace Physics {
+
+	const uint32_t CollisionDispatcher::TYPE_COUNT;
+
+	static const uint32_t BUCKET_COUNT = CollisionDispatcher::TYPE_COUNT * CollisionDispatcher::TYPE_COUNT + 1;
+	static const uint32_t NO_KERNEL = BUCKET_COUNT - 1;
+	static_assert(BUCKET_COUNT <= 256, "Pair buckets are stored as uint8_t");
+
+	CollisionDispatcher::CollisionDispatcher() {
+
+		for(uint32_t a = 0; a < TYPE_COUNT; a++)
+			for(uint32_t b = 0; b < TYPE_COUNT; b++)
+				m_Kernels[a][b] = nullptr;
+
+		m_Kernels[(uint32_t)Collider::ColliderType::SPHERE][(uint32_t)Collider::ColliderType::SPHERE] = SphereSphereKernel;
+		m_Kernels[(uint32_t)Collider::ColliderType::SPHERE][(uint32_t)Collider::ColliderType::AABB] = SphereAABBKernel;
+		m_Kernels[(uint32_t)Collider::ColliderType::AABB][(uint32_t)Collider::ColliderType::AABB] = AABBAABBKernel;
+
+		BuildRoutes();
+
+	}
+
+	CollisionDispatcher::~CollisionDispatcher() {
+	}
+
+	void CollisionDispatcher::Register(Collider::ColliderType typeA, Collider::ColliderType typeB, CollisionKernel kernel) {
+
+		m_Kernels[(uint32_t)typeA][(uint32_t)typeB] = kernel;
+		BuildRoutes();
+
+	}
+
+	void CollisionDispatcher::Unregister(Collider::ColliderType typeA, Collider::ColliderType typeB) {
+		Register(typeA, typeB, nullptr);
+	}
+
+	void CollisionDispatcher::BuildRoutes() {
+
+		for(uint32_t a = 0; a < TYPE_COUNT; a++) {
+			for(uint32_t b = 0; b < TYPE_COUNT; b++) {
+				//A kernel for the pair as it arrives wins over one for the swapped order
+				if(m_Kernels[a][b] != nullptr)
+					m_Routes[a][b] = { a * TYPE_COUNT + b, false };
+				else if(m_Kernels[b][a] != nullptr)
+					m_Routes[a][b] = { b * TYPE_COUNT + a, true };
+				else
+					m_Routes[a][b] = { NO_KERNEL, false };
+			}
+		}
+
+	}
+
+	void CollisionDispatcher::Sort(const BodyStore & bodies, const std::vector<BodyPair>& pairs) {
+
+		uint32_t count = (uint32_t)pairs.size();
+		m_PairBucket.resize(count);
+		m_BucketStart.assign(BUCKET_COUNT + 1, 0);
+
+		//Counting sort on the bucket, so every bucket ends up contiguous and in arrival order
+		for(uint32_t i = 0; i < count; i++) {
+
+			//A sleeping body against another sleeping or rigid body has nothing to resolve
+			uint32_t bucket = m_Routes[(uint32_t)bodies.colliderType[pairs[i].a]][(uint32_t)bodies.colliderType[pairs[i].b]].bucket;
+			if(bodies.IsRestingPair(pairs[i].a, pairs[i].b))
+				bucket = NO_KERNEL;
+
+			m_PairBucket[i] = (uint8_t)bucket;
+			m_BucketStart[bucket + 1]++;
+
+		}
+
+		for(uint32_t b = 0; b < BUCKET_COUNT; b++)
+			m_BucketStart[b + 1] += m_BucketStart[b];
+
+		//Pairs without a kernel sort to the end and are cut off
+		m_Sorted.resize(m_BucketStart[NO_KERNEL]);
+
+		uint32_t next[BUCKET_COUNT];
+		std::copy(m_BucketStart.begin(), m_BucketStart.end() - 1, next);
+		for(uint32_t i = 0; i < count; i++) {
+
+			uint32_t bucket = m_PairBucket[i];
+			if(bucket == NO_KERNEL)	continue;
+
+			BodyPair pair = pairs[i];
+			const Route& route = m_Routes[(uint32_t)bodies.colliderType[pair.a]][(uint32_t)bodies.colliderType[pair.b]];
+			if(route.swap)
+				std::swap(pair.a, pair.b);
+
+			m_Sorted[next[bucket]++] = pair;
+
+		}
+
+	}
+
+	void CollisionDispatcher::Run(const BodyStore & bodies, uint32_t begin, uint32_t end, std::vector<Contact>& contacts) const {
+
+		//Find the bucket holding begin, then walk forward one bucket at a time
+		uint32_t bucket = (uint32_t)(std::upper_bound(m_BucketStart.begin(), m_BucketStart.begin() + NO_KERNEL + 1, begin) - m_BucketStart.begin()) - 1;
+
+		while(begin < end && bucket < NO_KERNEL) {
+
+			uint32_t bucketEnd = std::min(end, m_BucketStart[bucket + 1]);
+			if(bucketEnd > begin) {
+				CollisionKernel kernel = m_Kernels[bucket / TYPE_COUNT][bucket % TYPE_COUNT];
+				kernel(bodies, &m_Sorted[begin], bucketEnd - begin, contacts);
+				begin = bucketEnd;
+			}
+			bucket++;
+
+		}
+
+	}
+
+	void SphereSphereKernel(const BodyStore & bodies, const BodyPair * pairs, uint32_t count, std::vector<Contact>& contacts) {
+		//Most pairs are spheres, so this one goes through the SIMD kernel for the best level the CPU has
+		SphereSphereBatch(GetSupportedSimdLevel(), bodies, pairs, count, contacts);
+	}
+
+	void SphereAABBKernel(const BodyStore & bodies, const BodyPair * pairs, uint32_t count, std::vector<Contact>& contacts) {
+
+		const float* radius = bodies.spheres.radius.data();
+		const float* ex = bodies.boxes.extents.x.data();
+		const float* ey = bodies.boxes.extents.y.data();
+		const float* ez = bodies.boxes.extents.z.data();
+		const uint32_t* colliderIndex = bodies.colliderIndex.data();
+		const float* px = bodies.position.x.data();
+		const float* py = bodies.position.y.data();
+		const float* pz = bodies.position.z.data();
+
+		for(uint32_t i = 0; i < count; i++) {
+
+			uint32_t sphere = pairs[i].a;
+			uint32_t box = pairs[i].b;
+			uint32_t boxIndex = colliderIndex[box];
+			float sphereRadius = radius[colliderIndex[sphere]];
+
+			//Closest point on the box to the sphere centre, by clamping
+			float x = std::max(px[box] - ex[boxIndex], std::min(px[sphere], px[box] + ex[boxIndex]));
+			float y = std::max(py[box] - ey[boxIndex], std::min(py[sphere], py[box] + ey[boxIndex]));
+			float z = std::max(pz[box] - ez[boxIndex], std::min(pz[sphere], pz[box] + ez[boxIndex]));
+
+			float dx = x - px[sphere];
+			float dy = y - py[sphere];
+			float dz = z - pz[sphere];
+			float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+			if(!(dist < sphereRadius))	continue;
+
+			//Push out along the line to the closest point, or through the nearest face if the centre is inside
+			glm::vec3 collisionVector;
+			if(dist > 0.0f) {
+				collisionVector = glm::vec3(dx, dy, dz) * ((sphereRadius - dist) / dist);
+			} else {
+				float offset[3] = { px[sphere] - px[box], py[sphere] - py[box], pz[sphere] - pz[box] };
+				float extents[3] = { ex[boxIndex], ey[boxIndex], ez[boxIndex] };
+				int axis = 0;
+				for(int k = 1; k < 3; k++) {
+					if(extents[k] - std::abs(offset[k]) < extents[axis] - std::abs(offset[axis]))
+						axis = k;
+				}
+				collisionVector = glm::vec3(0);
+				collisionVector[axis] = (offset[axis] < 0.0f ? 1.0f : -1.0f) * (sphereRadius + extents[axis] - std::abs(offset[axis]));
+			}
+
+			Contact contact;
+			contact.a = sphere;
+			contact.b = box;
+			contact.intersection.collisionVector = collisionVector;
+			contact.intersection.intersectionType = CollisionType::SPHERE2AABB;
+			contacts.push_back(contact);
+
+		}
+
+	}
+
+	void AABBAABBKernel(const BodyStore & bodies, const BodyPair * pairs, uint32_t count, std::vector<Contact>& contacts) {
+
+		const float* ex = bodies.boxes.extents.x.data();
+		const float* ey = bodies.boxes.extents.y.data();
+		const float* ez = bodies.boxes.extents.z.data();
+		const uint32_t* colliderIndex = bodies.colliderIndex.data();
+		const float* px = bodies.position.x.data();
+		const float* py = bodies.position.y.data();
+		const float* pz = bodies.position.z.data();
+
+		for(uint32_t i = 0; i < count; i++) {
+
+			uint32_t a = pairs[i].a;
+			uint32_t b = pairs[i].b;
+			glm::vec3 centreA(px[a], py[a], pz[a]);
+			glm::vec3 centreB(px[b], py[b], pz[b]);
+			glm::vec3 extentsA(ex[colliderIndex[a]], ey[colliderIndex[a]], ez[colliderIndex[a]]);
+			glm::vec3 extentsB(ex[colliderIndex[b]], ey[colliderIndex[b]], ez[colliderIndex[b]]);
+
+			glm::vec3 minA = centreA - extentsA;
+			glm::vec3 maxA = centreA + extentsA;
+			glm::vec3 minB = centreB - extentsB;
+			glm::vec3 maxB = centreB + extentsB;
+
+			if(!(minA.x <= maxB.x && maxA.x >= minB.x &&
+				 minA.y <= maxB.y && maxA.y >= minB.y &&
+				 minA.z <= maxB.z && maxA.z >= minB.z))
+				continue;
+
+			//Distance between each box's closest point to the other's centre
+			glm::vec3 closestA = glm::max(minA, glm::min(centreB, maxA));
+			glm::vec3 closestB = glm::max(minB, glm::min(centreA, maxB));
+			float dist = glm::length(closestA - closestB);
+
+			Contact contact;
+			contact.a = a;
+			contact.b = b;
+			contact.intersection.collisionVector = glm::normalize(centreB - centreA) * dist;
+			contact.intersection.intersectionType = CollisionType::AABB2AABB;
+			contacts.push_back(contact);
+
+		}
+
+	}
+
+}
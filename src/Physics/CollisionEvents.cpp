@@ -0,0 +1,150 @@
+#include "Physics/CollisionEvents.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <glm/geometric.hpp>
+#include <algorithm>
+
+namespace Physics {
+
+	static inline uint64_t PackHandle(Handle handle) {
+		return ((uint64_t)handle.slot << 32) | handle.generation;
+	}
+
+	static inline Handle UnpackHandle(uint64_t key) {
+		return { (uint32_t)(key >> 32), (uint32_t)key };
+	}
+
+	CollisionEvents::CollisionEvents() : m_Enabled(false) {
+	}
+
+	CollisionEvents::~CollisionEvents() {
+	}
+
+	void CollisionEvents::AddContacts(const SlotMap & slots, const std::vector<Contact>& contacts, const std::vector<float>& impulses) {
+
+		if(!m_Enabled)	return;
+
+		for(size_t c = 0; c < contacts.size(); c++) {
+
+			const Contact& contact = contacts[c];
+			Record record;
+			record.keyA = PackHandle(slots.GetHandle(contact.a));
+			record.keyB = PackHandle(slots.GetHandle(contact.b));
+			record.order = (uint32_t)m_Current.size();
+			record.impulse = impulses[c];
+
+			float depth = glm::length(contact.intersection.collisionVector);
+			record.normal = (depth > 0.0f) ? contact.intersection.collisionVector / depth : glm::vec3(0, 1, 0);
+
+			//Slots order the pair, flipping the normal along with it
+			if(record.keyA > record.keyB) {
+				std::swap(record.keyA, record.keyB);
+				record.normal = -record.normal;
+			}
+
+			m_Current.push_back(record);
+
+		}
+
+	}
+
+	void CollisionEvents::EndStep(const SlotMap & slots, const BodyStore & bodies) {
+
+		if(!m_Enabled)	return;
+
+		PHYSICS_ZONE("CollisionEvents::EndStep");
+
+		m_Begins.clear();
+		m_Stays.clear();
+		m_Ends.clear();
+
+		//One record per pair, the impulse summed over substeps and the normal from the last
+		std::sort(m_Current.begin(), m_Current.end(), CollectedLess);
+		size_t pairs = 0;
+		for(size_t i = 0; i < m_Current.size(); i++) {
+			if(pairs > 0 && SamePair(m_Current[pairs - 1], m_Current[i])) {
+				m_Current[pairs - 1].normal = m_Current[i].normal;
+				m_Current[pairs - 1].impulse += m_Current[i].impulse;
+			} else {
+				m_Current[pairs++] = m_Current[i];
+			}
+		}
+		m_Current.resize(pairs);
+
+		//Both lists are sorted by pair, so one walk over them finds every pair in either
+		m_Next.clear();
+		size_t cur = 0, prev = 0;
+		while(cur < m_Current.size() || prev < m_Previous.size()) {
+
+			bool takeCurrent = prev == m_Previous.size() || (cur < m_Current.size() && PairLess(m_Current[cur], m_Previous[prev]));
+			bool takePrevious = cur == m_Current.size() || (prev < m_Previous.size() && PairLess(m_Previous[prev], m_Current[cur]));
+
+			if(takeCurrent && !takePrevious) {
+				m_Begins.push_back(MakeEvent(m_Current[cur]));
+				m_Next.push_back(m_Current[cur++]);
+			} else if(takePrevious && !takeCurrent) {
+				//Resting pairs aren't tested, so a pair that went to sleep touching is still touching
+				const Record& record = m_Previous[prev++];
+				Handle a = UnpackHandle(record.keyA);
+				Handle b = UnpackHandle(record.keyB);
+				if(slots.IsValid(a) && slots.IsValid(b) && bodies.IsRestingPair(slots.GetIndex(a), slots.GetIndex(b)))
+					m_Next.push_back(record);
+				else
+					m_Ends.push_back(MakeEvent(record));
+			} else {
+				m_Stays.push_back(MakeEvent(m_Current[cur]));
+				m_Next.push_back(m_Current[cur++]);
+				prev++;
+			}
+
+		}
+
+		m_Previous.swap(m_Next);
+		m_Current.clear();
+
+		for(auto listener : m_Listeners)
+			listener->OnCollisionEvents(*this);
+
+	}
+
+	void CollisionEvents::Clear() {
+
+		m_Current.clear();
+		m_Previous.clear();
+		m_Next.clear();
+		m_Begins.clear();
+		m_Stays.clear();
+		m_Ends.clear();
+
+	}
+
+	void CollisionEvents::AddListener(CollisionListener * listener) {
+
+		if(std::find(m_Listeners.begin(), m_Listeners.end(), listener) == m_Listeners.end())
+			m_Listeners.push_back(listener);
+
+	}
+
+	void CollisionEvents::RemoveListener(CollisionListener * listener) {
+
+		auto iter = std::find(m_Listeners.begin(), m_Listeners.end(), listener);
+		if(iter != m_Listeners.end())
+			m_Listeners.erase(iter);
+
+	}
+
+	void CollisionEvents::SetEnabled(bool enabled) {
+
+		if(enabled == m_Enabled)	return;
+
+		m_Enabled = enabled;
+		Clear();
+
+	}
+
+	CollisionEvent CollisionEvents::MakeEvent(const Record & record) {
+		return { UnpackHandle(record.keyA), UnpackHandle(record.keyB), record.normal, record.impulse };
+	}
+
+}
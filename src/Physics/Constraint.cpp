@@ -3,7 +3,7 @@
 
 namespace Physics {
 
-	Constraint::Constraint( Object * objA, Object * objB, ConstraintType type) : m_ObjA(objA), m_ObjB(objB), m_Type(type) {
+	Constraint::Constraint( Object * objA, Object * objB, ConstraintType type) : m_Scene(nullptr), m_ObjA(objA), m_ObjB(objB), m_Type(type) {
 	}
 
 	Constraint::~Constraint() {
@@ -0,0 +1,250 @@
+#include "Physics/ContactCache.hpp"
+#include "Physics/PairSet.hpp"
+#include "Physics/CpuFeatures.hpp"
+
+#include <algorithm>
+
+#if PHYSICS_X86
+#include <xmmintrin.h>
+#endif
+
+namespace Physics {
+
+	const uint64_t ContactCache::EMPTY;
+	const size_t ContactCache::NOT_FOUND;
+
+	ContactCache::ContactCache() : m_Keys(64, EMPTY), m_Entries(64), m_Count(0), m_Live(0), m_Step(1), m_ReuseTolerance(0.001f) {
+	}
+
+	ContactCache::~ContactCache() {
+	}
+
+	void ContactCache::BeginStep() {
+
+		m_Step++;
+		m_Live = 0;
+
+	}
+
+	void ContactCache::EndStep() {
+
+		//Stale entries cost nothing but probe length, so they're only swept once they outnumber the live ones
+		if(m_Count - m_Live > m_Live + 64)
+			Rebuild(m_Keys.size());
+
+	}
+
+	size_t ContactCache::Find(uint32_t a, uint32_t b) const {
+
+		uint64_t key = PairSet::MakeKey(a, b);
+		size_t slot = FindSlot(key);
+		return (m_Keys[slot] == key) ? slot : NOT_FOUND;
+
+	}
+
+	void ContactCache::Prefetch(uint32_t a, uint32_t b) const {
+
+#if PHYSICS_X86
+		size_t slot = PairSet::HashKey(PairSet::MakeKey(a, b)) & (m_Keys.size() - 1);
+		_mm_prefetch((const char*)&m_Keys[slot], _MM_HINT_T0);
+		_mm_prefetch((const char*)&m_Entries[slot], _MM_HINT_T0);
+#endif
+
+	}
+
+	bool ContactCache::CanReuse(size_t slot, const glm::vec3 & relPosition) const {
+
+		const Entry& entry = m_Entries[slot];
+		if(entry.step + 1 != m_Step)	return false;
+
+		glm::vec3 delta = relPosition - entry.relPosition;
+		return delta.x * delta.x + delta.y * delta.y + delta.z * delta.z < m_ReuseTolerance * m_ReuseTolerance;
+
+	}
+
+	void ContactCache::Reserve(size_t count) {
+
+		//Keep the load factor under a half so probe runs stay short, sweeping stale entries before growing
+		if((m_Count + count) * 2 <= m_Keys.size())	return;
+
+		size_t capacity = m_Keys.size();
+		while((m_Live + count) * 2 > capacity)
+			capacity *= 2;
+		Rebuild(capacity);
+
+		//Sweeping alone wasn't enough
+		if((m_Count + count) * 2 > m_Keys.size())
+			Rebuild(capacity * 2);
+
+	}
+
+	size_t ContactCache::Touch(uint32_t a, uint32_t b, const glm::vec3 & relPosition, const IntersectData & intersection, bool regenerated) {
+
+		Reserve(1);
+
+		uint64_t key = PairSet::MakeKey(a, b);
+		size_t slot = FindSlot(key);
+		Entry& entry = m_Entries[slot];
+
+		if(m_Keys[slot] != key) {
+			m_Keys[slot] = key;
+			m_Count++;
+			entry.step = 0;
+			regenerated = true;
+			AddPartner(a, b);
+			AddPartner(b, a);
+		}
+
+		//A pair that wasn't in contact last step starts from no impulse
+		if(entry.step != m_Step) {
+			if(entry.step + 1 != m_Step)
+				entry.normalImpulse = 0.0f;
+			m_Live++;
+		}
+
+		//Updating a reused contact's geometry would let it creep past the tolerance a step at a time for ever
+		if(regenerated) {
+			entry.a = a;
+			entry.b = b;
+			entry.relPosition = relPosition;
+			entry.intersection = intersection;
+		}
+		entry.step = m_Step;
+
+		return slot;
+
+	}
+
+	void ContactCache::RemoveBody(uint32_t index, uint32_t from) {
+
+		if(index < m_Partners.size()) {
+			for(auto partner : m_Partners[index]) {
+				EraseSlot(Find(index, partner));
+				DropPartner(partner, index);
+			}
+			m_Partners[index].clear();
+		}
+
+		if(index == from || from >= m_Partners.size())	return;
+
+		//Keys change with the index, so each of from's entries goes in again under the new one
+		for(auto partner : m_Partners[from]) {
+
+			size_t slot = Find(from, partner);
+			Entry entry = m_Entries[slot];
+			EraseSlot(slot);
+
+			if(entry.a == from)	entry.a = index;
+			if(entry.b == from)	entry.b = index;
+			InsertEntry(entry);
+
+			std::vector<uint32_t>& partners = m_Partners[partner];
+			*std::find(partners.begin(), partners.end(), from) = index;
+
+		}
+		m_Partners[index].swap(m_Partners[from]);
+
+	}
+
+	void ContactCache::Clear() {
+
+		for(auto& key : m_Keys)
+			key = EMPTY;
+		m_Count = 0;
+		m_Live = 0;
+		//Lists keep their capacity so they don't allocate again as contacts come back
+		for(auto& partners : m_Partners)
+			partners.clear();
+
+	}
+
+	size_t ContactCache::FindSlot(uint64_t key) const {
+
+		size_t mask = m_Keys.size() - 1;
+		size_t slot = PairSet::HashKey(key) & mask;
+		while(m_Keys[slot] != EMPTY && m_Keys[slot] != key)
+			slot = (slot + 1) & mask;
+		return slot;
+
+	}
+
+	void ContactCache::Rebuild(size_t capacity) {
+
+		//Keep entries from this step and the last, the only ones that can still be reused or warm started
+		m_Scratch.clear();
+		for(size_t slot = 0; slot < m_Keys.size(); slot++) {
+			if(m_Keys[slot] != EMPTY && m_Entries[slot].step + 1 >= m_Step)
+				m_Scratch.push_back(m_Entries[slot]);
+		}
+
+		m_Keys.assign(capacity, EMPTY);
+		m_Entries.resize(capacity);
+		m_Count = 0;
+		m_Live = 0;
+		for(auto& partners : m_Partners)
+			partners.clear();
+
+		for(auto& entry : m_Scratch) {
+			InsertEntry(entry);
+			AddPartner(entry.a, entry.b);
+			AddPartner(entry.b, entry.a);
+		}
+
+	}
+
+	void ContactCache::EraseSlot(size_t slot) {
+
+		if(m_Entries[slot].step == m_Step)
+			m_Live--;
+		m_Count--;
+
+		//Shift back any entry in the probe run that could sit in the freed slot
+		size_t mask = m_Keys.size() - 1;
+		size_t next = slot;
+		for(;;) {
+			next = (next + 1) & mask;
+			if(m_Keys[next] == EMPTY)	break;
+
+			size_t home = PairSet::HashKey(m_Keys[next]) & mask;
+			bool canMove = (slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next);
+			if(canMove) {
+				m_Keys[slot] = m_Keys[next];
+				m_Entries[slot] = m_Entries[next];
+				slot = next;
+			}
+		}
+
+		m_Keys[slot] = EMPTY;
+
+	}
+
+	void ContactCache::InsertEntry(const Entry & entry) {
+
+		uint64_t key = PairSet::MakeKey(entry.a, entry.b);
+		size_t slot = FindSlot(key);
+		m_Keys[slot] = key;
+		m_Entries[slot] = entry;
+		m_Count++;
+		if(entry.step == m_Step)
+			m_Live++;
+
+	}
+
+	void ContactCache::AddPartner(uint32_t body, uint32_t partner) {
+
+		if(m_Partners.size() <= body)
+			m_Partners.resize(body + 1);
+		m_Partners[body].push_back(partner);
+
+	}
+
+	void ContactCache::DropPartner(uint32_t body, uint32_t partner) {
+
+		std::vector<uint32_t>& partners = m_Partners[body];
+		auto iter = std::find(partners.begin(), partners.end(), partner);
+		*iter = partners.back();
+		partners.pop_back();
+
+	}
+
+}
@@ -0,0 +1,267 @@
+#include "Physics/ContactSolver.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/JobSystem.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <glm/geometric.hpp>
+#include <algorithm>
+
+namespace Physics {
+
+	//One bit per colour in a body's mask, contacts that find them all taken go to the overflow
+	static const uint32_t MAX_COLOURS = 64;
+
+	static const uint32_t NO_COLOUR = ~0u;
+
+	ContactSolver::ContactSolver() : m_ColourStart(1, 0) {
+	}
+
+	ContactSolver::~ContactSolver() {
+	}
+
+	void ContactSolver::Solve(BodyStore & bodies, const std::vector<Contact>& contacts, std::vector<float>& impulses,
+							  const ContactSolverSettings & settings, JobSystem * jobs) {
+
+		PHYSICS_ZONE("ContactSolver::Solve");
+
+		impulses.resize(contacts.size(), 0.0f);
+
+		Prepare(bodies, contacts, impulses, settings);
+
+		if(!m_Contacts.empty()) {
+
+			{
+				PHYSICS_ZONE("Warm start");
+				ForEachColour(jobs, settings.batchSize, [this, &bodies](uint32_t begin, uint32_t end) { WarmStart(bodies, begin, end); });
+			}
+
+			{
+				PHYSICS_ZONE("Velocity iterations");
+				for(uint32_t i = 0; i < settings.velocityIterations; i++)
+					ForEachColour(jobs, settings.batchSize, [this, &bodies](uint32_t begin, uint32_t end) { SolveVelocity(bodies, begin, end); });
+			}
+
+			if(settings.recovery == PenetrationRecovery::SPLIT_IMPULSE) {
+
+				PHYSICS_ZONE("Position iterations");
+				m_PseudoVelocity.assign(bodies.Size(), glm::vec3(0));
+
+				for(uint32_t i = 0; i < settings.positionIterations; i++)
+					ForEachColour(jobs, settings.batchSize, [this](uint32_t begin, uint32_t end) { SolvePosition(begin, end); });
+
+				//Bodies without contacts have no pseudo velocity and aren't moved
+				const float dt = settings.timeStep;
+				ParallelFor(jobs, (uint32_t)bodies.Size(), settings.batchSize * 4, [this, &bodies, dt](uint32_t begin, uint32_t end, uint32_t thread) {
+					for(uint32_t i = begin; i < end; i++) {
+						const glm::vec3& push = m_PseudoVelocity[i];
+						bodies.position.x[i] += push.x * dt;
+						bodies.position.y[i] += push.y * dt;
+						bodies.position.z[i] += push.z * dt;
+					}
+				});
+
+			}
+
+		}
+
+		for(size_t c = 0; c < impulses.size(); c++)
+			impulses[c] = 0.0f;
+		for(size_t i = 0; i < m_Contacts.size(); i++)
+			impulses[m_Order[i]] = m_Contacts[i].impulse;
+
+	}
+
+	void ContactSolver::Prepare(const BodyStore & bodies, const std::vector<Contact>& contacts, const std::vector<float>& impulses,
+								const ContactSolverSettings & settings) {
+
+		PHYSICS_ZONE("ContactSolver::Prepare");
+
+		const uint8_t infiniteMass = BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING;
+
+		//Greedy colouring in contact order, so the same contacts always get the same colours. A body with infinite
+		//mass is never written, so it doesn't stop two of its contacts sharing a colour
+		m_BodyColours.assign(bodies.Size(), 0);
+		m_ContactColour.resize(contacts.size());
+
+		uint32_t colourCount = 0;
+		uint32_t counts[MAX_COLOURS + 1] = {};
+
+		for(size_t c = 0; c < contacts.size(); c++) {
+
+			uint32_t a = contacts[c].a;
+			uint32_t b = contacts[c].b;
+			bool dynamicA = (bodies.flags[a] & infiniteMass) == 0;
+			bool dynamicB = (bodies.flags[b] & infiniteMass) == 0;
+
+			//Nothing to solve between two immovable bodies
+			if(!dynamicA && !dynamicB) {
+				m_ContactColour[c] = NO_COLOUR;
+				continue;
+			}
+
+			uint64_t used = (dynamicA ? m_BodyColours[a] : 0) | (dynamicB ? m_BodyColours[b] : 0);
+			uint32_t colour = MAX_COLOURS;
+			for(uint32_t k = 0; k < MAX_COLOURS; k++) {
+				if((used & (1ull << k)) == 0) {
+					colour = k;
+					break;
+				}
+			}
+
+			if(colour < MAX_COLOURS) {
+				if(dynamicA)	m_BodyColours[a] |= 1ull << colour;
+				if(dynamicB)	m_BodyColours[b] |= 1ull << colour;
+				colourCount = std::max(colourCount, colour + 1);
+			}
+
+			m_ContactColour[c] = colour;
+			counts[colour]++;
+
+		}
+
+		//Colours in use, then the overflow
+		m_ColourStart.assign(colourCount + 2, 0);
+		for(uint32_t k = 0; k < colourCount; k++)
+			m_ColourStart[k + 1] = m_ColourStart[k] + counts[k];
+		m_ColourStart[colourCount + 1] = m_ColourStart[colourCount] + counts[MAX_COLOURS];
+
+		uint32_t total = m_ColourStart[colourCount + 1];
+		m_Contacts.resize(total);
+		m_Order.resize(total);
+
+		uint32_t cursor[MAX_COLOURS + 1];
+		for(uint32_t k = 0; k < colourCount; k++)
+			cursor[k] = m_ColourStart[k];
+		cursor[MAX_COLOURS] = m_ColourStart[colourCount];
+
+		const float dt = settings.timeStep;
+
+		for(size_t c = 0; c < contacts.size(); c++) {
+
+			if(m_ContactColour[c] == NO_COLOUR)	continue;
+
+			const Contact& contact = contacts[c];
+			uint32_t slot = cursor[m_ContactColour[c]]++;
+			m_Order[slot] = (uint32_t)c;
+
+			SolverContact& sc = m_Contacts[slot];
+			sc.a = contact.a;
+			sc.b = contact.b;
+			sc.invMassA = (bodies.flags[contact.a] & infiniteMass) ? 0.0f : bodies.invMass[contact.a];
+			sc.invMassB = (bodies.flags[contact.b] & infiniteMass) ? 0.0f : bodies.invMass[contact.b];
+			sc.normalMass = 1.0f / (sc.invMassA + sc.invMassB);
+
+			//Bodies sitting exactly on each other have no direction to separate in, push them apart along +y
+			float depth = glm::length(contact.intersection.collisionVector);
+			sc.normal = (depth > 0.0f) ? contact.intersection.collisionVector / depth : glm::vec3(0, 1, 0);
+
+			//Restitution only for contacts coming together fast enough, so piles can come to rest
+			glm::vec3 relVelocity = bodies.velocity.Get(contact.b) - bodies.velocity.Get(contact.a);
+			float approach = glm::dot(relVelocity, sc.normal);
+			float bounciness = std::min(bodies.bounciness[contact.a], bodies.bounciness[contact.b]);
+			sc.velocityBias = (approach < -settings.restitutionThreshold) ? -bounciness * approach : 0.0f;
+
+			float recovery = settings.baumgarte / dt * std::max(depth - settings.slop, 0.0f);
+			if(settings.recovery == PenetrationRecovery::BAUMGARTE) {
+				sc.velocityBias = std::max(sc.velocityBias, recovery);
+				sc.positionBias = 0.0f;
+			} else {
+				sc.positionBias = recovery;
+			}
+
+			sc.impulse = impulses[c] * settings.warmStartFactor;
+			sc.positionImpulse = 0.0f;
+
+		}
+
+	}
+
+	template<typename Func>
+	void ContactSolver::ForEachColour(JobSystem * jobs, uint32_t batchSize, const Func & func) {
+
+		uint32_t colours = (uint32_t)m_ColourStart.size() - 1;
+
+		for(uint32_t k = 0; k < colours; k++) {
+
+			uint32_t begin = m_ColourStart[k];
+			uint32_t count = m_ColourStart[k + 1] - begin;
+			if(count == 0)	continue;
+
+			//The overflow has contacts sharing bodies, so it stays on this thread
+			if(k + 1 == colours) {
+				func(begin, begin + count);
+				continue;
+			}
+
+			ParallelFor(jobs, count, batchSize, [&func, begin](uint32_t first, uint32_t last, uint32_t thread) {
+				func(begin + first, begin + last);
+			});
+
+		}
+
+	}
+
+	void ContactSolver::WarmStart(BodyStore & bodies, uint32_t begin, uint32_t end) {
+
+		for(uint32_t i = begin; i < end; i++) {
+
+			const SolverContact& sc = m_Contacts[i];
+			if(sc.impulse == 0.0f)	continue;
+
+			//Bodies with infinite mass can be shared within a colour, so they must not even be written back unchanged
+			glm::vec3 impulse = sc.normal * sc.impulse;
+			if(sc.invMassA > 0.0f)	bodies.velocity.Set(sc.a, bodies.velocity.Get(sc.a) - impulse * sc.invMassA);
+			if(sc.invMassB > 0.0f)	bodies.velocity.Set(sc.b, bodies.velocity.Get(sc.b) + impulse * sc.invMassB);
+
+		}
+
+	}
+
+	void ContactSolver::SolveVelocity(BodyStore & bodies, uint32_t begin, uint32_t end) {
+
+		for(uint32_t i = begin; i < end; i++) {
+
+			SolverContact& sc = m_Contacts[i];
+
+			glm::vec3 velA = bodies.velocity.Get(sc.a);
+			glm::vec3 velB = bodies.velocity.Get(sc.b);
+
+			//Clamp the running total rather than this iteration's share of it
+			float separating = glm::dot(velB - velA, sc.normal);
+			float lambda = sc.normalMass * (sc.velocityBias - separating);
+			float total = std::max(sc.impulse + lambda, 0.0f);
+			lambda = total - sc.impulse;
+			sc.impulse = total;
+
+			glm::vec3 impulse = sc.normal * lambda;
+			if(sc.invMassA > 0.0f)	bodies.velocity.Set(sc.a, velA - impulse * sc.invMassA);
+			if(sc.invMassB > 0.0f)	bodies.velocity.Set(sc.b, velB + impulse * sc.invMassB);
+
+		}
+
+	}
+
+	void ContactSolver::SolvePosition(uint32_t begin, uint32_t end) {
+
+		for(uint32_t i = begin; i < end; i++) {
+
+			SolverContact& sc = m_Contacts[i];
+
+			glm::vec3& pushA = m_PseudoVelocity[sc.a];
+			glm::vec3& pushB = m_PseudoVelocity[sc.b];
+
+			float separating = glm::dot(pushB - pushA, sc.normal);
+			float lambda = sc.normalMass * (sc.positionBias - separating);
+			float total = std::max(sc.positionImpulse + lambda, 0.0f);
+			lambda = total - sc.positionImpulse;
+			sc.positionImpulse = total;
+
+			glm::vec3 impulse = sc.normal * lambda;
+			if(sc.invMassA > 0.0f)	pushA -= impulse * sc.invMassA;
+			if(sc.invMassB > 0.0f)	pushB += impulse * sc.invMassB;
+
+		}
+
+	}
+
+}
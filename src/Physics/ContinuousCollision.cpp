@@ -0,0 +1,202 @@
+#include "Physics/ContinuousCollision.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace Physics {
+
+	static const uint32_t NOT_FAST = ~0u;
+
+	//Returned by the sweeps when there's no impact
+	static const float NO_IMPACT = FLT_MAX;
+
+	float SweepSphereSphere(const glm::vec3 & start, const glm::vec3 & motion, float radius, const glm::vec3 & otherCentre, float otherRadius) {
+
+		glm::vec3 offset = start - otherCentre;
+		float reach = radius + otherRadius;
+
+		//Already touching. Only an impact if the sweep goes further in, so bodies can slide off each other
+		float c = glm::dot(offset, offset) - reach * reach;
+		if(c < 0.0f)
+			return (glm::dot(motion, offset) < 0.0f) ? 0.0f : NO_IMPACT;
+
+		//|offset + motion * t| = reach
+		float a = glm::dot(motion, motion);
+		if(a == 0.0f)	return NO_IMPACT;
+		float b = glm::dot(offset, motion);
+		float disc = b * b - a * c;
+		if(disc < 0.0f)	return NO_IMPACT;
+
+		float t = (-b - std::sqrt(disc)) / a;
+		return (t >= 0.0f && t <= 1.0f) ? t : NO_IMPACT;
+
+	}
+
+	float SweepSphereAABB(const glm::vec3 & start, const glm::vec3 & motion, float radius, const glm::vec3 & centre, const glm::vec3 & extents) {
+
+		glm::vec3 min = centre - extents - glm::vec3(radius);
+		glm::vec3 max = centre + extents + glm::vec3(radius);
+
+		//Already inside the grown box. Only an impact if the sweep heads further in, judged against the face the
+		//sphere is least far through, so sliding along a face isn't stopped
+		if(start.x > min.x && start.x < max.x && start.y > min.y && start.y < max.y && start.z > min.z && start.z < max.z) {
+			int axis = 0;
+			float side = 0.0f;
+			float shallowest = FLT_MAX;
+			for(int i = 0; i < 3; i++) {
+				float belowMin = start[i] - min[i];
+				float belowMax = max[i] - start[i];
+				if(belowMin < shallowest)	{ shallowest = belowMin; axis = i; side = -1.0f; }
+				if(belowMax < shallowest)	{ shallowest = belowMax; axis = i; side = 1.0f; }
+			}
+			return (motion[axis] * side < 0.0f) ? 0.0f : NO_IMPACT;
+		}
+
+		//Slab test, the ray enters once it is inside all three slabs
+		float enter = 0.0f;
+		float exit = 1.0f;
+		for(int axis = 0; axis < 3; axis++) {
+
+			if(motion[axis] == 0.0f) {
+				if(start[axis] < min[axis] || start[axis] > max[axis])	return NO_IMPACT;
+				continue;
+			}
+
+			float inv = 1.0f / motion[axis];
+			float t0 = (min[axis] - start[axis]) * inv;
+			float t1 = (max[axis] - start[axis]) * inv;
+			if(t0 > t1)	std::swap(t0, t1);
+
+			enter = std::max(enter, t0);
+			exit = std::min(exit, t1);
+			if(enter > exit)	return NO_IMPACT;
+
+		}
+
+		return enter;
+
+	}
+
+	ContinuousCollision::ContinuousCollision() : m_Enabled(true), m_Penetration(0.02f), m_Impacts(0) {
+	}
+
+	ContinuousCollision::~ContinuousCollision() {
+	}
+
+	void ContinuousCollision::BeginStep(const BodyStore & bodies) {
+
+		m_Tracked.clear();
+		m_TrackedStart.clear();
+		m_FastBodies.clear();
+		m_Impacts = 0;
+
+		if(!m_Enabled)	return;
+
+		const uint8_t frozen = BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING;
+		for(uint32_t i = 0; i < (uint32_t)bodies.Size(); i++) {
+			if((bodies.flags[i] & (BodyStore::BODY_CONTINUOUS | frozen)) != BodyStore::BODY_CONTINUOUS)	continue;
+			if(bodies.colliderType[i] != Collider::ColliderType::SPHERE)	continue;
+			m_Tracked.push_back(i);
+			m_TrackedStart.push_back(bodies.position.Get(i));
+		}
+
+	}
+
+	void ContinuousCollision::SweepBounds(BodyStore & bodies, std::vector<uint8_t>& movedMask) {
+
+		PHYSICS_ZONE("ContinuousCollision::SweepBounds");
+
+		m_SweepIndex.resize(bodies.Size(), NOT_FAST);
+
+		for(size_t i = 0; i < m_Tracked.size(); i++) {
+
+			uint32_t body = m_Tracked[i];
+			float radius = bodies.spheres.radius[bodies.colliderIndex[body]];
+			glm::vec3 motion = bodies.position.Get(body) - m_TrackedStart[i];
+
+			//Moving less than its radius, the body overlaps anything it crosses at one end of the step or the other
+			if(glm::dot(motion, motion) <= radius * radius)	continue;
+
+			m_SweepIndex[body] = (uint32_t)m_FastBodies.size();
+			m_FastBodies.push_back({ body, m_TrackedStart[i], motion, radius, NO_IMPACT });
+
+			//Bounds cover the start of the path as well as the end
+			glm::vec3 startMin = m_TrackedStart[i] - glm::vec3(radius);
+			glm::vec3 startMax = m_TrackedStart[i] + glm::vec3(radius);
+			bodies.boundsMin.Set(body, glm::min(bodies.boundsMin.Get(body), startMin));
+			bodies.boundsMax.Set(body, glm::max(bodies.boundsMax.Get(body), startMax));
+			movedMask[body] = 1;
+
+		}
+
+	}
+
+	void ContinuousCollision::Resolve(BodyStore & bodies, const std::vector<BodyPair>& pairs) {
+
+		PHYSICS_ZONE("ContinuousCollision::Resolve");
+
+		if(m_FastBodies.empty())	return;
+
+		for(auto& pair : pairs) {
+
+			uint32_t sweepA = m_SweepIndex[pair.a];
+			uint32_t sweepB = m_SweepIndex[pair.b];
+			if(sweepA == NOT_FAST && sweepB == NOT_FAST)	continue;
+
+			//Sweep a fast body against the other, which is either fast too, in which case they're swept against
+			//each other from both starts, or held where it ended the step
+			if(sweepA == NOT_FAST)	std::swap(sweepA, sweepB);
+			Sweep& sweep = m_FastBodies[sweepA];
+			uint32_t other = (sweep.body == pair.a) ? pair.b : pair.a;
+
+			float toi = NO_IMPACT;
+
+			switch(bodies.colliderType[other]) {
+
+				case Collider::ColliderType::SPHERE: {
+					float otherRadius = bodies.spheres.radius[bodies.colliderIndex[other]];
+					float reach = std::max(sweep.radius + otherRadius - m_Penetration, 0.0f);
+					if(sweepB != NOT_FAST) {
+						const Sweep& otherSweep = m_FastBodies[sweepB];
+						toi = SweepSphereSphere(sweep.start, sweep.motion - otherSweep.motion, reach, otherSweep.start, 0.0f);
+						m_FastBodies[sweepB].toi = std::min(m_FastBodies[sweepB].toi, toi);
+					} else {
+						toi = SweepSphereSphere(sweep.start, sweep.motion, reach, bodies.position.Get(other), 0.0f);
+					}
+					break;
+				}
+
+				case Collider::ColliderType::AABB: {
+					glm::vec3 extents = bodies.boxes.extents.Get(bodies.colliderIndex[other]);
+					float radius = std::max(sweep.radius - m_Penetration, 0.0f);
+					toi = SweepSphereAABB(sweep.start, sweep.motion, radius, bodies.position.Get(other), extents);
+					break;
+				}
+
+				default:
+					break;
+
+			}
+
+			sweep.toi = std::min(sweep.toi, toi);
+
+		}
+
+		//Cut each body's step short at its first impact. The rest of its motion this step is dropped
+		for(auto& sweep : m_FastBodies) {
+
+			m_SweepIndex[sweep.body] = NOT_FAST;
+			if(sweep.toi > 1.0f)	continue;
+
+			bodies.position.Set(sweep.body, sweep.start + sweep.motion * sweep.toi);
+			m_Impacts++;
+
+		}
+
+	}
+
+}
@@ -0,0 +1,55 @@
+#include "Physics/CpuFeatures.hpp"
+
+#if PHYSICS_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Physics {
+
+	static SimdLevel DetectSimdLevel() {
+
+#if PHYSICS_X86 && defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse = (info[3] & (1 << 26)) != 0;
+		bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+		bool avx2 = false;
+		if(maxLeaf >= 7 && osSavesAvx) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		if(avx2)	return SimdLevel::AVX2;
+		if(sse)		return SimdLevel::SSE;
+#elif PHYSICS_X86
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2"))	return SimdLevel::AVX2;
+		if(__builtin_cpu_supports("sse2"))	return SimdLevel::SSE;
+#endif
+
+		return SimdLevel::SCALAR;
+
+	}
+
+	SimdLevel GetSupportedSimdLevel() {
+		static SimdLevel level = DetectSimdLevel();
+		return level;
+	}
+
+	const char* GetSimdLevelName(SimdLevel level) {
+
+		switch(level) {
+			case SimdLevel::SCALAR:	return "Scalar";
+			case SimdLevel::SSE:	return "SSE";
+			case SimdLevel::AVX2:	return "AVX2";
+			default:				return "Unknown";
+		}
+
+	}
+
+}
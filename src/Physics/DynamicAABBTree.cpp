@@ -0,0 +1,548 @@
+#include "Physics/DynamicAABBTree.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace Physics {
+
+	const int32_t DynamicAABBTree::NULL_NODE;
+
+	static inline bool NodesOverlap(const float* minA, const float* maxA, const float* minB, const float* maxB) {
+		return minA[0] <= maxB[0] && maxA[0] >= minB[0] &&
+			   minA[1] <= maxB[1] && maxA[1] >= minB[1] &&
+			   minA[2] <= maxB[2] && maxA[2] >= minB[2];
+	}
+
+	static inline float CombinedArea(const float* minA, const float* maxA, const float* minB, const float* maxB) {
+		float dx = std::max(maxA[0], maxB[0]) - std::min(minA[0], minB[0]);
+		float dy = std::max(maxA[1], maxB[1]) - std::min(minA[1], minB[1]);
+		float dz = std::max(maxA[2], maxB[2]) - std::min(minA[2], minB[2]);
+		return 2.0f * (dx * dy + dy * dz + dz * dx);
+	}
+
+	//Slab test, narrows [tMin, tMax] to the part of the ray inside the box. False if nothing is left
+	static inline bool RayHitsBox(const glm::vec3& origin, const glm::vec3& invDir, const float* min, const float* max, float& tMin, float& tMax) {
+		for(int axis = 0; axis < 3; axis++) {
+			float t1 = (min[axis] - origin[axis]) * invDir[axis];
+			float t2 = (max[axis] - origin[axis]) * invDir[axis];
+			tMin = std::max(tMin, std::min(t1, t2));
+			tMax = std::min(tMax, std::max(t1, t2));
+		}
+		return tMin <= tMax;
+	}
+
+	DynamicAABBTree::DynamicAABBTree() : m_Root(NULL_NODE), m_FreeList(NULL_NODE), m_FreeCount(0), m_Margin(0.1f) {
+	}
+
+	DynamicAABBTree::~DynamicAABBTree() {
+	}
+
+	void DynamicAABBTree::Insert(const BodyStore & bodies, uint32_t index) {
+
+		int32_t leaf = AllocateNode();
+		m_Nodes[leaf].body = index;
+		SetFatBounds(bodies, leaf);
+		InsertLeaf(leaf);
+
+		if(m_BodyLeaves.size() <= index)
+			m_BodyLeaves.resize(index + 1, NULL_NODE);
+		m_BodyLeaves[index] = leaf;
+
+		MarkMoved(leaf);
+
+	}
+
+	void DynamicAABBTree::Remove(const BodyStore & bodies, uint32_t index) {
+
+		//A queued leaf stays in m_MovedLeaves, freeing it clears its flag so the update skips it
+		int32_t leaf = m_BodyLeaves[index];
+		RemoveLeaf(leaf);
+		FreeNode(leaf);
+
+		//The store moves its last body into the freed index
+		uint32_t last = (uint32_t)bodies.Size() - 1;
+		if(index != last) {
+			m_BodyLeaves[index] = m_BodyLeaves[last];
+			m_Nodes[m_BodyLeaves[index]].body = index;
+		}
+		m_BodyLeaves.pop_back();
+
+		m_Pairs.RemoveBody(index, last);
+
+	}
+
+	void DynamicAABBTree::Build(const BodyStore & bodies) {
+
+		PHYSICS_ZONE("DynamicAABBTree::Build");
+
+		uint32_t count = (uint32_t)bodies.Size();
+
+		m_Nodes.clear();
+		m_Nodes.reserve(count * 2);
+		m_Root = NULL_NODE;
+		m_FreeList = NULL_NODE;
+		m_FreeCount = 0;
+		m_MovedLeaves.clear();
+		m_Pairs.Clear();
+
+		//Leaves first, so body i's leaf is node i. All of them count as moved so the next update finds their pairs
+		m_BodyLeaves.resize(count);
+		for(uint32_t i = 0; i < count; i++) {
+			int32_t leaf = AllocateNode();
+			m_Nodes[leaf].body = i;
+			SetFatBounds(bodies, leaf);
+			m_BodyLeaves[i] = leaf;
+			MarkMoved(leaf);
+		}
+
+		if(count == 0)	return;
+
+		std::vector<int32_t> leaves(m_BodyLeaves);
+		m_Root = BuildRange(leaves.data(), count);
+		m_Nodes[m_Root].parent = NULL_NODE;
+
+	}
+
+	int32_t DynamicAABBTree::BuildRange(int32_t * leaves, uint32_t count) {
+
+		if(count == 1)	return leaves[0];
+
+		//Widest axis of the leaf centres
+		float centreMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float centreMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for(uint32_t i = 0; i < count; i++) {
+			const Node& leaf = m_Nodes[leaves[i]];
+			for(int axis = 0; axis < 3; axis++) {
+				float centre = leaf.min[axis] + leaf.max[axis];
+				centreMin[axis] = std::min(centreMin[axis], centre);
+				centreMax[axis] = std::max(centreMax[axis], centre);
+			}
+		}
+
+		int axis = 0;
+		for(int i = 1; i < 3; i++) {
+			if(centreMax[i] - centreMin[i] > centreMax[axis] - centreMin[axis])
+				axis = i;
+		}
+
+		//Median split keeps the tree balanced whatever the distribution
+		uint32_t half = count / 2;
+		std::nth_element(leaves, leaves + half, leaves + count, [this, axis](int32_t a, int32_t b) {
+			return m_Nodes[a].min[axis] + m_Nodes[a].max[axis] < m_Nodes[b].min[axis] + m_Nodes[b].max[axis];
+		});
+
+		int32_t child1 = BuildRange(leaves, half);
+		int32_t child2 = BuildRange(leaves + half, count - half);
+
+		//m_Nodes can grow while allocating, so nothing is held across the call
+		int32_t node = AllocateNode();
+		Node& parent = m_Nodes[node];
+		const Node& a = m_Nodes[child1];
+		const Node& b = m_Nodes[child2];
+		parent.child1 = child1;
+		parent.child2 = child2;
+		parent.height = std::max(a.height, b.height) + 1;
+		for(int i = 0; i < 3; i++) {
+			parent.min[i] = std::min(a.min[i], b.min[i]);
+			parent.max[i] = std::max(a.max[i], b.max[i]);
+		}
+		m_Nodes[child1].parent = node;
+		m_Nodes[child2].parent = node;
+
+		return node;
+
+	}
+
+	void DynamicAABBTree::Update(const BodyStore & bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs) {
+
+		PHYSICS_ZONE("DynamicAABBTree::Update");
+
+		//Reinsert bodies that have left their fat bounds. Anything still inside needs no work at all
+		uint32_t count = (uint32_t)bodies.Size();
+		for(uint32_t i = 0; i < count; i++) {
+
+			int32_t leaf = m_BodyLeaves[i];
+			const Node& node = m_Nodes[leaf];
+
+			if(node.min[0] <= bodies.boundsMin.x[i] && node.min[1] <= bodies.boundsMin.y[i] && node.min[2] <= bodies.boundsMin.z[i] &&
+			   node.max[0] >= bodies.boundsMax.x[i] && node.max[1] >= bodies.boundsMax.y[i] && node.max[2] >= bodies.boundsMax.z[i])
+				continue;
+
+			RemoveLeaf(leaf);
+			SetFatBounds(bodies, leaf);
+			InsertLeaf(leaf);
+			MarkMoved(leaf);
+
+		}
+
+		//Only moved leaves can have gained an overlap
+		for(auto leaf : m_MovedLeaves) {
+			if(!m_Nodes[leaf].moved)	continue;
+			QueryPairs(leaf);
+			m_Nodes[leaf].moved = false;
+		}
+		m_MovedLeaves.clear();
+
+		//Drop pairs whose fat bounds have separated and report the ones whose bodies actually overlap
+		m_PairScratch.clear();
+		m_Pairs.GetPairs(m_PairScratch);
+
+		for(auto& pair : m_PairScratch) {
+			const Node& a = m_Nodes[m_BodyLeaves[pair.a]];
+			const Node& b = m_Nodes[m_BodyLeaves[pair.b]];
+			if(!NodesOverlap(a.min, a.max, b.min, b.max))
+				m_Pairs.Erase(pair.a, pair.b);
+			else if(bodies.BoundsOverlap(pair.a, pair.b))
+				pairs.push_back(pair);
+		}
+
+	}
+
+	void DynamicAABBTree::QueryOverlap(const glm::vec3 & min, const glm::vec3 & max, std::vector<uint32_t>& results) const {
+
+		if(m_Root == NULL_NODE)	return;
+
+		float queryMin[3] = { min.x, min.y, min.z };
+		float queryMax[3] = { max.x, max.y, max.z };
+
+		m_Stack.clear();
+		m_Stack.push_back(m_Root);
+
+		while(!m_Stack.empty()) {
+
+			const Node& node = m_Nodes[m_Stack.back()];
+			m_Stack.pop_back();
+
+			if(!NodesOverlap(node.min, node.max, queryMin, queryMax))	continue;
+
+			if(node.IsLeaf()) {
+				results.push_back(node.body);
+			} else {
+				m_Stack.push_back(node.child1);
+				m_Stack.push_back(node.child2);
+			}
+
+		}
+
+	}
+
+	int32_t DynamicAABBTree::RayCast(const BodyStore & bodies, const glm::vec3 & origin, const glm::vec3 & direction, float maxDistance, float & hitDistance) const {
+
+		int32_t hit = -1;
+		hitDistance = maxDistance;
+
+		if(m_Root == NULL_NODE)	return hit;
+
+		//Division by a zero component gives infinity, which the slab test handles
+		glm::vec3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+		m_Stack.clear();
+		m_Stack.push_back(m_Root);
+
+		while(!m_Stack.empty()) {
+
+			const Node& node = m_Nodes[m_Stack.back()];
+			m_Stack.pop_back();
+
+			float tMin = 0.0f, tMax = hitDistance;
+			if(!RayHitsBox(origin, invDir, node.min, node.max, tMin, tMax))	continue;
+
+			if(!node.IsLeaf()) {
+				m_Stack.push_back(node.child1);
+				m_Stack.push_back(node.child2);
+				continue;
+			}
+
+			//Fat bounds were hit, check the body's own bounds
+			uint32_t body = node.body;
+			float bodyMin[3] = { bodies.boundsMin.x[body], bodies.boundsMin.y[body], bodies.boundsMin.z[body] };
+			float bodyMax[3] = { bodies.boundsMax.x[body], bodies.boundsMax.y[body], bodies.boundsMax.z[body] };
+
+			tMin = 0.0f;
+			tMax = hitDistance;
+			if(RayHitsBox(origin, invDir, bodyMin, bodyMax, tMin, tMax)) {
+				hit = (int32_t)body;
+				hitDistance = tMin;
+			}
+
+		}
+
+		return hit;
+
+	}
+
+	int32_t DynamicAABBTree::GetHeight() const {
+		return (m_Root == NULL_NODE) ? 0 : m_Nodes[m_Root].height;
+	}
+
+	int32_t DynamicAABBTree::AllocateNode() {
+
+		int32_t node;
+
+		if(m_FreeList != NULL_NODE) {
+			node = m_FreeList;
+			m_FreeList = m_Nodes[node].parent;
+			m_FreeCount--;
+		} else {
+			node = (int32_t)m_Nodes.size();
+			m_Nodes.push_back(Node());
+		}
+
+		Node& n = m_Nodes[node];
+		n.parent = NULL_NODE;
+		n.child1 = NULL_NODE;
+		n.child2 = NULL_NODE;
+		n.height = 0;
+		n.body = 0;
+		n.moved = false;
+
+		return node;
+
+	}
+
+	void DynamicAABBTree::FreeNode(int32_t node) {
+
+		m_Nodes[node].parent = m_FreeList;
+		m_Nodes[node].height = -1;
+		m_Nodes[node].moved = false;
+		m_FreeList = node;
+		m_FreeCount++;
+
+	}
+
+	void DynamicAABBTree::InsertLeaf(int32_t leaf) {
+
+		if(m_Root == NULL_NODE) {
+			m_Root = leaf;
+			m_Nodes[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		//Walk down picking whichever side grows the least in surface area
+		const float* leafMin = m_Nodes[leaf].min;
+		const float* leafMax = m_Nodes[leaf].max;
+		int32_t index = m_Root;
+
+		while(!m_Nodes[index].IsLeaf()) {
+
+			const Node& node = m_Nodes[index];
+			float area = Area(node);
+			float combinedArea = CombinedArea(node.min, node.max, leafMin, leafMax);
+
+			//Cost of making a new parent for this node and the leaf, and the minimum cost pushed down to the children
+			float cost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			float childCost[2];
+			int32_t children[2] = { node.child1, node.child2 };
+			for(int i = 0; i < 2; i++) {
+				const Node& child = m_Nodes[children[i]];
+				float grown = CombinedArea(child.min, child.max, leafMin, leafMax);
+				childCost[i] = child.IsLeaf() ? grown + inheritanceCost : (grown - Area(child)) + inheritanceCost;
+			}
+
+			if(cost < childCost[0] && cost < childCost[1])	break;
+
+			index = (childCost[0] < childCost[1]) ? children[0] : children[1];
+
+		}
+
+		//Replace the chosen sibling with a new parent holding both
+		int32_t sibling = index;
+		int32_t oldParent = m_Nodes[sibling].parent;
+		int32_t newParent = AllocateNode();
+
+		Node& parent = m_Nodes[newParent];
+		parent.parent = oldParent;
+		parent.child1 = sibling;
+		parent.child2 = leaf;
+		parent.height = m_Nodes[sibling].height + 1;
+
+		if(oldParent != NULL_NODE) {
+			if(m_Nodes[oldParent].child1 == sibling)
+				m_Nodes[oldParent].child1 = newParent;
+			else
+				m_Nodes[oldParent].child2 = newParent;
+		} else {
+			m_Root = newParent;
+		}
+
+		m_Nodes[sibling].parent = newParent;
+		m_Nodes[leaf].parent = newParent;
+
+		Refit(newParent);
+
+	}
+
+	void DynamicAABBTree::RemoveLeaf(int32_t leaf) {
+
+		if(leaf == m_Root) {
+			m_Root = NULL_NODE;
+			return;
+		}
+
+		//The leaf's parent goes away and the sibling takes its place
+		int32_t parent = m_Nodes[leaf].parent;
+		int32_t grandParent = m_Nodes[parent].parent;
+		int32_t sibling = (m_Nodes[parent].child1 == leaf) ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+		if(grandParent != NULL_NODE) {
+			if(m_Nodes[grandParent].child1 == parent)
+				m_Nodes[grandParent].child1 = sibling;
+			else
+				m_Nodes[grandParent].child2 = sibling;
+			m_Nodes[sibling].parent = grandParent;
+			FreeNode(parent);
+			Refit(grandParent);
+		} else {
+			m_Root = sibling;
+			m_Nodes[sibling].parent = NULL_NODE;
+			FreeNode(parent);
+		}
+
+	}
+
+	int32_t DynamicAABBTree::Balance(int32_t a) {
+
+		Node& nodeA = m_Nodes[a];
+		if(nodeA.IsLeaf() || nodeA.height < 2)	return a;
+
+		int32_t b = nodeA.child1;
+		int32_t c = nodeA.child2;
+		int32_t balance = m_Nodes[c].height - m_Nodes[b].height;
+
+		if(balance >= -1 && balance <= 1)	return a;
+
+		//Rotate the taller child up into a's place. a takes the taller child's shorter grandchild
+		//and the taller child keeps the other one
+		int32_t up = (balance > 1) ? c : b;
+		int32_t down = (balance > 1) ? b : c;
+
+		Node& nodeUp = m_Nodes[up];
+		int32_t f = nodeUp.child1;
+		int32_t g = nodeUp.child2;
+
+		nodeUp.child1 = a;
+		nodeUp.parent = nodeA.parent;
+		nodeA.parent = up;
+
+		if(nodeUp.parent != NULL_NODE) {
+			if(m_Nodes[nodeUp.parent].child1 == a)
+				m_Nodes[nodeUp.parent].child1 = up;
+			else
+				m_Nodes[nodeUp.parent].child2 = up;
+		} else {
+			m_Root = up;
+		}
+
+		int32_t keep = (m_Nodes[f].height > m_Nodes[g].height) ? f : g;
+		int32_t give = (keep == f) ? g : f;
+
+		nodeUp.child2 = keep;
+		nodeA.child1 = down;
+		nodeA.child2 = give;
+		m_Nodes[give].parent = a;
+
+		const Node& nodeDown = m_Nodes[down];
+		const Node& nodeGive = m_Nodes[give];
+		for(int axis = 0; axis < 3; axis++) {
+			nodeA.min[axis] = std::min(nodeDown.min[axis], nodeGive.min[axis]);
+			nodeA.max[axis] = std::max(nodeDown.max[axis], nodeGive.max[axis]);
+		}
+		nodeA.height = 1 + std::max(nodeDown.height, nodeGive.height);
+
+		const Node& nodeKeep = m_Nodes[keep];
+		for(int axis = 0; axis < 3; axis++) {
+			nodeUp.min[axis] = std::min(nodeA.min[axis], nodeKeep.min[axis]);
+			nodeUp.max[axis] = std::max(nodeA.max[axis], nodeKeep.max[axis]);
+		}
+		nodeUp.height = 1 + std::max(nodeA.height, nodeKeep.height);
+
+		return up;
+
+	}
+
+	void DynamicAABBTree::Refit(int32_t index) {
+
+		while(index != NULL_NODE) {
+
+			index = Balance(index);
+
+			Node& node = m_Nodes[index];
+			const Node& child1 = m_Nodes[node.child1];
+			const Node& child2 = m_Nodes[node.child2];
+
+			for(int axis = 0; axis < 3; axis++) {
+				node.min[axis] = std::min(child1.min[axis], child2.min[axis]);
+				node.max[axis] = std::max(child1.max[axis], child2.max[axis]);
+			}
+			node.height = 1 + std::max(child1.height, child2.height);
+
+			index = node.parent;
+
+		}
+
+	}
+
+	void DynamicAABBTree::SetFatBounds(const BodyStore & bodies, int32_t leaf) {
+
+		Node& node = m_Nodes[leaf];
+		uint32_t body = node.body;
+
+		node.min[0] = bodies.boundsMin.x[body] - m_Margin;
+		node.min[1] = bodies.boundsMin.y[body] - m_Margin;
+		node.min[2] = bodies.boundsMin.z[body] - m_Margin;
+		node.max[0] = bodies.boundsMax.x[body] + m_Margin;
+		node.max[1] = bodies.boundsMax.y[body] + m_Margin;
+		node.max[2] = bodies.boundsMax.z[body] + m_Margin;
+
+	}
+
+	void DynamicAABBTree::MarkMoved(int32_t leaf) {
+
+		if(m_Nodes[leaf].moved)	return;
+
+		m_Nodes[leaf].moved = true;
+		m_MovedLeaves.push_back(leaf);
+
+	}
+
+	void DynamicAABBTree::QueryPairs(int32_t leaf) {
+
+		const Node& query = m_Nodes[leaf];
+
+		m_Stack.clear();
+		m_Stack.push_back(m_Root);
+
+		while(!m_Stack.empty()) {
+
+			int32_t index = m_Stack.back();
+			m_Stack.pop_back();
+
+			const Node& node = m_Nodes[index];
+			if(index == leaf || !NodesOverlap(node.min, node.max, query.min, query.max))	continue;
+
+			if(node.IsLeaf()) {
+				m_Pairs.Insert(query.body, node.body);
+			} else {
+				m_Stack.push_back(node.child1);
+				m_Stack.push_back(node.child2);
+			}
+
+		}
+
+	}
+
+	float DynamicAABBTree::Area(const Node & node) {
+
+		float dx = node.max[0] - node.min[0];
+		float dy = node.max[1] - node.min[1];
+		float dz = node.max[2] - node.min[2];
+		return 2.0f * (dx * dy + dy * dz + dz * dx);
+
+	}
+
+}
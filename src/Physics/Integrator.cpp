@@ -0,0 +1,304 @@
+#include "Physics/Integrator.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/JobSystem.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+#if PHYSICS_X86
+#include <immintrin.h>
+#endif
+
+namespace Physics {
+
+	//Raw views of the arrays the kernels touch
+	struct IntegratorArrays {
+		float* px; float* py; float* pz;
+		float* vx; float* vy; float* vz;
+		float* ax; float* ay; float* az;
+		const float* mx; const float* my; const float* mz;
+		const float* invMass;
+		const float* friction;
+		const uint8_t* flags;
+		uint8_t* moved;
+	};
+
+	//Bodies with any of these flags are left where they are
+	static const uint8_t FROZEN_FLAGS = BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING;
+
+	//Every path below performs the same operations in the same order so results match bit for bit
+	static void IntegrateScalar(const IntegratorArrays& a, const IntegratorSettings& s, size_t begin, size_t end) {
+
+		const float dt = s.timeStep;
+
+		for(size_t i = begin; i < end; i++) {
+
+			if(a.flags[i] & FROZEN_FLAGS) {
+				a.moved[i] = 0;
+				continue;
+			}
+
+			float invMass = a.invMass[i];
+			float drag = a.friction[i] * invMass;
+
+			float oldX = a.px[i], oldY = a.py[i], oldZ = a.pz[i];
+			float vx = a.vx[i], vy = a.vy[i], vz = a.vz[i];
+
+			//Total acceleration this step
+			float accX = ((a.ax[i] + s.gravity.x) + s.globalForce.x * invMass) - vx * drag;
+			float accY = ((a.ay[i] + s.gravity.y) + s.globalForce.y * invMass) - vy * drag;
+			float accZ = ((a.az[i] + s.gravity.z) + s.globalForce.z * invMass) - vz * drag;
+
+			vx = vx + accX * dt;
+			vy = vy + accY * dt;
+			vz = vz + accZ * dt;
+
+			//Clamp to max velocity
+			vx = (vx > -a.mx[i]) ? vx : -a.mx[i];	vx = (vx < a.mx[i]) ? vx : a.mx[i];
+			vy = (vy > -a.my[i]) ? vy : -a.my[i];	vy = (vy < a.my[i]) ? vy : a.my[i];
+			vz = (vz > -a.mz[i]) ? vz : -a.mz[i];	vz = (vz < a.mz[i]) ? vz : a.mz[i];
+
+			float x = oldX + vx * dt;
+			float y = oldY + vy * dt;
+			float z = oldZ + vz * dt;
+
+			//Temp collision with ground
+			if(y < s.groundHeight) {
+				y = s.groundHeight;
+				vy = -vy;
+			}
+
+			a.px[i] = x;	a.py[i] = y;	a.pz[i] = z;
+			a.vx[i] = vx;	a.vy[i] = vy;	a.vz[i] = vz;
+			a.ax[i] = 0.0f;	a.ay[i] = 0.0f;	a.az[i] = 0.0f;
+
+			float dx = x - oldX, dy = y - oldY, dz = z - oldZ;
+			dx = (dx < 0.0f) ? -dx : dx;
+			dy = (dy < 0.0f) ? -dy : dy;
+			dz = (dz < 0.0f) ? -dz : dz;
+			a.moved[i] = (dx > s.moveThreshold || dy > s.moveThreshold || dz > s.moveThreshold) ? 1 : 0;
+
+		}
+
+	}
+
+#if PHYSICS_X86
+
+	PHYSICS_TARGET_SSE2
+	static inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	//Processes 4 bodies per iteration, returns the first index it did not handle
+	PHYSICS_TARGET_SSE2
+	static size_t IntegrateSSE(const IntegratorArrays& a, const IntegratorSettings& s, size_t begin, size_t end) {
+
+		const __m128 dt = _mm_set1_ps(s.timeStep);
+		const __m128 gravX = _mm_set1_ps(s.gravity.x), gravY = _mm_set1_ps(s.gravity.y), gravZ = _mm_set1_ps(s.gravity.z);
+		const __m128 forceX = _mm_set1_ps(s.globalForce.x), forceY = _mm_set1_ps(s.globalForce.y), forceZ = _mm_set1_ps(s.globalForce.z);
+		const __m128 ground = _mm_set1_ps(s.groundHeight);
+		const __m128 threshold = _mm_set1_ps(s.moveThreshold);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128i frozenBits = _mm_set1_epi32(FROZEN_FLAGS);
+		const __m128i zeroInt = _mm_setzero_si128();
+
+		size_t i = begin;
+		for(; i + 4 <= end; i += 4) {
+
+			//Expand 4 flag bytes to a lane mask of dynamic bodies
+			int32_t flagBytes;
+			memcpy(&flagBytes, a.flags + i, sizeof(flagBytes));
+			__m128i flags = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(flagBytes), zeroInt), zeroInt);
+			__m128 dynamic = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, frozenBits), zeroInt));
+
+			__m128 invMass = _mm_loadu_ps(a.invMass + i);
+			__m128 drag = _mm_mul_ps(_mm_loadu_ps(a.friction + i), invMass);
+
+			__m128 oldX = _mm_loadu_ps(a.px + i), oldY = _mm_loadu_ps(a.py + i), oldZ = _mm_loadu_ps(a.pz + i);
+			__m128 oldVX = _mm_loadu_ps(a.vx + i), oldVY = _mm_loadu_ps(a.vy + i), oldVZ = _mm_loadu_ps(a.vz + i);
+			__m128 oldAX = _mm_loadu_ps(a.ax + i), oldAY = _mm_loadu_ps(a.ay + i), oldAZ = _mm_loadu_ps(a.az + i);
+
+			__m128 accX = _mm_sub_ps(_mm_add_ps(_mm_add_ps(oldAX, gravX), _mm_mul_ps(forceX, invMass)), _mm_mul_ps(oldVX, drag));
+			__m128 accY = _mm_sub_ps(_mm_add_ps(_mm_add_ps(oldAY, gravY), _mm_mul_ps(forceY, invMass)), _mm_mul_ps(oldVY, drag));
+			__m128 accZ = _mm_sub_ps(_mm_add_ps(_mm_add_ps(oldAZ, gravZ), _mm_mul_ps(forceZ, invMass)), _mm_mul_ps(oldVZ, drag));
+
+			__m128 vx = _mm_add_ps(oldVX, _mm_mul_ps(accX, dt));
+			__m128 vy = _mm_add_ps(oldVY, _mm_mul_ps(accY, dt));
+			__m128 vz = _mm_add_ps(oldVZ, _mm_mul_ps(accZ, dt));
+
+			__m128 maxX = _mm_loadu_ps(a.mx + i), maxY = _mm_loadu_ps(a.my + i), maxZ = _mm_loadu_ps(a.mz + i);
+			vx = _mm_min_ps(_mm_max_ps(vx, _mm_xor_ps(maxX, signBit)), maxX);
+			vy = _mm_min_ps(_mm_max_ps(vy, _mm_xor_ps(maxY, signBit)), maxY);
+			vz = _mm_min_ps(_mm_max_ps(vz, _mm_xor_ps(maxZ, signBit)), maxZ);
+
+			__m128 x = _mm_add_ps(oldX, _mm_mul_ps(vx, dt));
+			__m128 y = _mm_add_ps(oldY, _mm_mul_ps(vy, dt));
+			__m128 z = _mm_add_ps(oldZ, _mm_mul_ps(vz, dt));
+
+			__m128 belowGround = _mm_cmplt_ps(y, ground);
+			y = Select(belowGround, ground, y);
+			vy = Select(belowGround, _mm_xor_ps(vy, signBit), vy);
+
+			_mm_storeu_ps(a.px + i, Select(dynamic, x, oldX));
+			_mm_storeu_ps(a.py + i, Select(dynamic, y, oldY));
+			_mm_storeu_ps(a.pz + i, Select(dynamic, z, oldZ));
+			_mm_storeu_ps(a.vx + i, Select(dynamic, vx, oldVX));
+			_mm_storeu_ps(a.vy + i, Select(dynamic, vy, oldVY));
+			_mm_storeu_ps(a.vz + i, Select(dynamic, vz, oldVZ));
+			_mm_storeu_ps(a.ax + i, Select(dynamic, zero, oldAX));
+			_mm_storeu_ps(a.ay + i, Select(dynamic, zero, oldAY));
+			_mm_storeu_ps(a.az + i, Select(dynamic, zero, oldAZ));
+
+			__m128 movedX = _mm_cmpgt_ps(_mm_andnot_ps(signBit, _mm_sub_ps(x, oldX)), threshold);
+			__m128 movedY = _mm_cmpgt_ps(_mm_andnot_ps(signBit, _mm_sub_ps(y, oldY)), threshold);
+			__m128 movedZ = _mm_cmpgt_ps(_mm_andnot_ps(signBit, _mm_sub_ps(z, oldZ)), threshold);
+			int moved = _mm_movemask_ps(_mm_and_ps(dynamic, _mm_or_ps(_mm_or_ps(movedX, movedY), movedZ)));
+
+			for(int lane = 0; lane < 4; lane++)
+				a.moved[i + lane] = (uint8_t)((moved >> lane) & 1);
+
+		}
+
+		return i;
+
+	}
+
+	PHYSICS_TARGET_AVX2
+	static inline __m256 Select(__m256 mask, __m256 a, __m256 b) {
+		return _mm256_blendv_ps(b, a, mask);
+	}
+
+	//Processes 8 bodies per iteration, returns the first index it did not handle
+	PHYSICS_TARGET_AVX2
+	static size_t IntegrateAVX2(const IntegratorArrays& a, const IntegratorSettings& s, size_t begin, size_t end) {
+
+		const __m256 dt = _mm256_set1_ps(s.timeStep);
+		const __m256 gravX = _mm256_set1_ps(s.gravity.x), gravY = _mm256_set1_ps(s.gravity.y), gravZ = _mm256_set1_ps(s.gravity.z);
+		const __m256 forceX = _mm256_set1_ps(s.globalForce.x), forceY = _mm256_set1_ps(s.globalForce.y), forceZ = _mm256_set1_ps(s.globalForce.z);
+		const __m256 ground = _mm256_set1_ps(s.groundHeight);
+		const __m256 threshold = _mm256_set1_ps(s.moveThreshold);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256i frozenBits = _mm256_set1_epi32(FROZEN_FLAGS);
+		const __m256i zeroInt = _mm256_setzero_si256();
+
+		size_t i = begin;
+		for(; i + 8 <= end; i += 8) {
+
+			//Expand 8 flag bytes to a lane mask of dynamic bodies
+			__m256i flags = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(a.flags + i)));
+			__m256 dynamic = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, frozenBits), zeroInt));
+
+			__m256 invMass = _mm256_loadu_ps(a.invMass + i);
+			__m256 drag = _mm256_mul_ps(_mm256_loadu_ps(a.friction + i), invMass);
+
+			__m256 oldX = _mm256_loadu_ps(a.px + i), oldY = _mm256_loadu_ps(a.py + i), oldZ = _mm256_loadu_ps(a.pz + i);
+			__m256 oldVX = _mm256_loadu_ps(a.vx + i), oldVY = _mm256_loadu_ps(a.vy + i), oldVZ = _mm256_loadu_ps(a.vz + i);
+			__m256 oldAX = _mm256_loadu_ps(a.ax + i), oldAY = _mm256_loadu_ps(a.ay + i), oldAZ = _mm256_loadu_ps(a.az + i);
+
+			__m256 accX = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(oldAX, gravX), _mm256_mul_ps(forceX, invMass)), _mm256_mul_ps(oldVX, drag));
+			__m256 accY = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(oldAY, gravY), _mm256_mul_ps(forceY, invMass)), _mm256_mul_ps(oldVY, drag));
+			__m256 accZ = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(oldAZ, gravZ), _mm256_mul_ps(forceZ, invMass)), _mm256_mul_ps(oldVZ, drag));
+
+			__m256 vx = _mm256_add_ps(oldVX, _mm256_mul_ps(accX, dt));
+			__m256 vy = _mm256_add_ps(oldVY, _mm256_mul_ps(accY, dt));
+			__m256 vz = _mm256_add_ps(oldVZ, _mm256_mul_ps(accZ, dt));
+
+			__m256 maxX = _mm256_loadu_ps(a.mx + i), maxY = _mm256_loadu_ps(a.my + i), maxZ = _mm256_loadu_ps(a.mz + i);
+			vx = _mm256_min_ps(_mm256_max_ps(vx, _mm256_xor_ps(maxX, signBit)), maxX);
+			vy = _mm256_min_ps(_mm256_max_ps(vy, _mm256_xor_ps(maxY, signBit)), maxY);
+			vz = _mm256_min_ps(_mm256_max_ps(vz, _mm256_xor_ps(maxZ, signBit)), maxZ);
+
+			__m256 x = _mm256_add_ps(oldX, _mm256_mul_ps(vx, dt));
+			__m256 y = _mm256_add_ps(oldY, _mm256_mul_ps(vy, dt));
+			__m256 z = _mm256_add_ps(oldZ, _mm256_mul_ps(vz, dt));
+
+			__m256 belowGround = _mm256_cmp_ps(y, ground, _CMP_LT_OQ);
+			y = Select(belowGround, ground, y);
+			vy = Select(belowGround, _mm256_xor_ps(vy, signBit), vy);
+
+			_mm256_storeu_ps(a.px + i, Select(dynamic, x, oldX));
+			_mm256_storeu_ps(a.py + i, Select(dynamic, y, oldY));
+			_mm256_storeu_ps(a.pz + i, Select(dynamic, z, oldZ));
+			_mm256_storeu_ps(a.vx + i, Select(dynamic, vx, oldVX));
+			_mm256_storeu_ps(a.vy + i, Select(dynamic, vy, oldVY));
+			_mm256_storeu_ps(a.vz + i, Select(dynamic, vz, oldVZ));
+			_mm256_storeu_ps(a.ax + i, Select(dynamic, zero, oldAX));
+			_mm256_storeu_ps(a.ay + i, Select(dynamic, zero, oldAY));
+			_mm256_storeu_ps(a.az + i, Select(dynamic, zero, oldAZ));
+
+			__m256 movedX = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_sub_ps(x, oldX)), threshold, _CMP_GT_OQ);
+			__m256 movedY = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_sub_ps(y, oldY)), threshold, _CMP_GT_OQ);
+			__m256 movedZ = _mm256_cmp_ps(_mm256_andnot_ps(signBit, _mm256_sub_ps(z, oldZ)), threshold, _CMP_GT_OQ);
+			int moved = _mm256_movemask_ps(_mm256_and_ps(dynamic, _mm256_or_ps(_mm256_or_ps(movedX, movedY), movedZ)));
+
+			for(int lane = 0; lane < 8; lane++)
+				a.moved[i + lane] = (uint8_t)((moved >> lane) & 1);
+
+		}
+
+		return i;
+
+	}
+
+#endif
+
+	Integrator::Integrator() : m_SimdLevel(GetSupportedSimdLevel()) {
+	}
+
+	Integrator::~Integrator() {
+	}
+
+	void Integrator::SetSimdLevel(SimdLevel level) {
+		m_SimdLevel = ((int)level <= (int)GetSupportedSimdLevel()) ? level : GetSupportedSimdLevel();
+	}
+
+	void Integrator::Integrate(BodyStore & bodies, const IntegratorSettings & settings, std::vector<uint8_t>& movedMask, JobSystem* jobs) {
+
+		PHYSICS_ZONE("Integrator::Integrate");
+
+		size_t count = bodies.Size();
+		movedMask.resize(count);
+		if(count == 0)	return;
+
+		IntegratorArrays arrays = {
+			bodies.position.x.data(), bodies.position.y.data(), bodies.position.z.data(),
+			bodies.velocity.x.data(), bodies.velocity.y.data(), bodies.velocity.z.data(),
+			bodies.acceleration.x.data(), bodies.acceleration.y.data(), bodies.acceleration.z.data(),
+			bodies.maxVelocity.x.data(), bodies.maxVelocity.y.data(), bodies.maxVelocity.z.data(),
+			bodies.invMass.data(),
+			bodies.friction.data(),
+			bodies.flags.data(),
+			movedMask.data()
+		};
+
+		uint32_t batchSize = (std::max(settings.batchSize, 1u) + 7) & ~7u;
+		SimdLevel level = m_SimdLevel;
+
+		ParallelFor(jobs, (uint32_t)count, batchSize, [&arrays, &settings, level](uint32_t begin, uint32_t end, uint32_t thread) {
+
+			size_t done = begin;
+
+#if PHYSICS_X86
+			switch(level) {
+				case SimdLevel::AVX2:
+					done = IntegrateAVX2(arrays, settings, begin, end);
+					break;
+				case SimdLevel::SSE:
+					done = IntegrateSSE(arrays, settings, begin, end);
+					break;
+				default:
+					break;
+			}
+#endif
+
+			//Whatever doesn't fill a full vector goes through the scalar path
+			IntegrateScalar(arrays, settings, done, end);
+
+		});
+
+	}
+
+}
@@ -0,0 +1,183 @@
+#include "Physics/IslandManager.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Physics {
+
+	static const uint32_t NO_ISLAND = 0;
+
+	IslandManager::IslandManager() : m_SleepEnabled(true), m_SleepVelocity(0.5f), m_SleepTime(0.5f),
+		m_NextIslandId(1), m_AwakeIslands(0), m_SleepingBodies(0) {
+	}
+
+	IslandManager::~IslandManager() {
+	}
+
+	void IslandManager::Update(BodyStore & bodies, const std::vector<BodyPair>& edges, float timeStep) {
+
+		PHYSICS_ZONE("IslandManager::Update");
+
+		uint32_t count = (uint32_t)bodies.Size();
+		m_AwakeIslands = 0;
+		m_SleepingBodies = 0;
+
+		if(!m_SleepEnabled) {
+			WakeAll(bodies);
+			return;
+		}
+
+		//Advance every awake dynamic body's sleep timer, or restart it if the body is moving
+		float sleepVelocitySq = m_SleepVelocity * m_SleepVelocity;
+		for(uint32_t i = 0; i < count; i++) {
+			if(bodies.flags[i] & (BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING))	continue;
+			float vx = bodies.velocity.x[i], vy = bodies.velocity.y[i], vz = bodies.velocity.z[i];
+			float speedSq = vx * vx + vy * vy + vz * vz;
+			bodies.sleepTime[i] = (speedSq < sleepVelocitySq) ? bodies.sleepTime[i] + timeStep : 0.0f;
+		}
+
+		m_Parent.resize(count);
+		std::iota(m_Parent.begin(), m_Parent.end(), 0);
+
+		for(auto& edge : edges) {
+			if((bodies.flags[edge.a] | bodies.flags[edge.b]) & BodyStore::BODY_RIGID)	continue;
+			Union(edge.a, edge.b);
+		}
+
+		m_IslandSleepTime.assign(count, m_SleepTime);
+		m_IslandAwake.assign(count, 0);
+		m_IslandId.assign(count, NO_ISLAND);
+
+		for(uint32_t i = 0; i < count; i++) {
+			if(bodies.flags[i] & BodyStore::BODY_RIGID)	continue;
+			uint32_t root = Find(i);
+			m_IslandSleepTime[root] = std::min(m_IslandSleepTime[root], bodies.sleepTime[i]);
+			if(!bodies.IsSleeping(i))
+				m_IslandAwake[root] = 1;
+		}
+
+		m_WakeIslands.clear();
+
+		for(uint32_t i = 0; i < count; i++) {
+
+			if(bodies.flags[i] & BodyStore::BODY_RIGID)	continue;
+
+			uint32_t root = Find(i);
+
+			//Islands that are already asleep and weren't touched stay as they are
+			if(!m_IslandAwake[root]) {
+				m_SleepingBodies++;
+				continue;
+			}
+
+			if(m_IslandSleepTime[root] >= m_SleepTime) {
+
+				//Every body in the island has been slow for long enough, including any sleeping bodies it touched
+				if(m_IslandId[root] == NO_ISLAND) {
+					m_IslandId[root] = m_NextIslandId++;
+					if(m_NextIslandId == NO_ISLAND)
+						m_NextIslandId++;
+				}
+
+				bodies.flags[i] |= BodyStore::BODY_SLEEPING;
+				bodies.sleepIsland[i] = m_IslandId[root];
+				bodies.velocity.Set(i, glm::vec3(0));
+				bodies.acceleration.Set(i, glm::vec3(0));
+				m_SleepingBodies++;
+
+			} else {
+
+				//Roots are the lowest index in their island, so this counts each island once
+				if(root == i)
+					m_AwakeIslands++;
+
+				//A sleeping body joined to an awake island takes the rest of its old island with it
+				if(bodies.IsSleeping(i)) {
+					m_WakeIslands.push_back(bodies.sleepIsland[i]);
+					bodies.Wake(i);
+				}
+
+			}
+
+		}
+
+		if(m_WakeIslands.empty())	return;
+
+		std::sort(m_WakeIslands.begin(), m_WakeIslands.end());
+		m_WakeIslands.erase(std::unique(m_WakeIslands.begin(), m_WakeIslands.end()), m_WakeIslands.end());
+
+		for(uint32_t i = 0; i < count; i++) {
+			if(!bodies.IsSleeping(i))	continue;
+			if(std::binary_search(m_WakeIslands.begin(), m_WakeIslands.end(), bodies.sleepIsland[i])) {
+				bodies.Wake(i);
+				m_SleepingBodies--;
+			}
+		}
+
+	}
+
+	void IslandManager::WakeAll(BodyStore & bodies) {
+
+		for(uint32_t i = 0; i < (uint32_t)bodies.Size(); i++)
+			bodies.Wake(i);
+
+	}
+
+	void IslandManager::WakeIsland(BodyStore & bodies, uint32_t body) {
+
+		if(!bodies.IsSleeping(body))	return;
+
+		uint32_t island = bodies.sleepIsland[body];
+		for(uint32_t i = 0; i < (uint32_t)bodies.Size(); i++) {
+			if(bodies.IsSleeping(i) && bodies.sleepIsland[i] == island)
+				bodies.Wake(i);
+		}
+
+	}
+
+	void IslandManager::WakeIslands(BodyStore & bodies, const uint32_t * bodyIndices, size_t count) {
+
+		m_WakeIslands.clear();
+		for(size_t i = 0; i < count; i++) {
+			if(bodies.IsSleeping(bodyIndices[i]))
+				m_WakeIslands.push_back(bodies.sleepIsland[bodyIndices[i]]);
+		}
+
+		if(m_WakeIslands.empty())	return;
+
+		std::sort(m_WakeIslands.begin(), m_WakeIslands.end());
+		m_WakeIslands.erase(std::unique(m_WakeIslands.begin(), m_WakeIslands.end()), m_WakeIslands.end());
+
+		for(uint32_t i = 0; i < (uint32_t)bodies.Size(); i++) {
+			if(bodies.IsSleeping(i) && std::binary_search(m_WakeIslands.begin(), m_WakeIslands.end(), bodies.sleepIsland[i]))
+				bodies.Wake(i);
+		}
+
+	}
+
+	uint32_t IslandManager::Find(uint32_t body) {
+
+		//Path halving, every other node on the way up is pointed at its grandparent
+		while(m_Parent[body] != body) {
+			m_Parent[body] = m_Parent[m_Parent[body]];
+			body = m_Parent[body];
+		}
+		return body;
+
+	}
+
+	void IslandManager::Union(uint32_t a, uint32_t b) {
+
+		a = Find(a);
+		b = Find(b);
+		if(a == b)	return;
+
+		//The lower index becomes the root, so islands don't depend on edge order
+		if(a < b)	m_Parent[b] = a;
+		else		m_Parent[a] = b;
+
+	}
+
+}
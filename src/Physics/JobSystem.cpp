@@ -0,0 +1,318 @@
+#include "Physics/JobSystem.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <algorithm>
+
+namespace Physics {
+
+	//Which pool the current thread works for and its index there
+	static thread_local const JobSystem* t_System = nullptr;
+	static thread_local uint32_t t_Thread = 0;
+
+	//A ParallelFor in progress. Lives on the caller's stack until every helper job has let go of it
+	struct LoopState {
+		const JobSystem::RangeFunc* func;
+		uint32_t count;
+		uint32_t batchSize;
+		std::atomic<uint32_t> nextBatch;
+		//Helper jobs not yet finished
+		std::atomic<uint32_t> helpers;
+
+		void RunBatches(uint32_t thread) {
+			while(true) {
+				uint32_t begin = nextBatch.fetch_add(batchSize);
+				if(begin >= count)	break;
+				uint32_t end = (count - begin > batchSize) ? begin + batchSize : count;
+				(*func)(begin, end, thread);
+			}
+		}
+	};
+
+	//A graph run in progress, along with the pool running it
+	struct GraphRun {
+		JobSystem* jobs;
+		TaskGraph* graph;
+	};
+
+	TaskGraph::TaskGraph() : m_WaitingSize(0), m_Unfinished(0) {
+	}
+
+	TaskGraph::~TaskGraph() {
+	}
+
+	TaskGraph::TaskId TaskGraph::AddTask(const char * name, const TaskFunc & func) {
+
+		m_Tasks.push_back({ name, func, {}, 0 });
+		return (TaskId)m_Tasks.size() - 1;
+
+	}
+
+	void TaskGraph::AddDependency(TaskId before, TaskId after) {
+
+		m_Tasks[before].successors.push_back(after);
+		m_Tasks[after].dependencies++;
+
+	}
+
+	void TaskGraph::Clear() {
+		m_Tasks.clear();
+	}
+
+	void TaskGraph::Prepare() {
+
+		if(m_WaitingSize < m_Tasks.size()) {
+			m_Waiting.reset(new std::atomic<uint32_t>[m_Tasks.size()]);
+			m_WaitingSize = m_Tasks.size();
+		}
+
+		for(size_t i = 0; i < m_Tasks.size(); i++)
+			m_Waiting[i].store(m_Tasks[i].dependencies, std::memory_order_relaxed);
+		m_Unfinished.store((uint32_t)m_Tasks.size(), std::memory_order_release);
+
+	}
+
+	JobSystem::JobSystem(uint32_t threadCount) : m_Queued(0), m_Quit(false), m_SingleThreaded(false) {
+
+		if(threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		m_Queues.reset(new Queue[threadCount]);
+
+		for(uint32_t i = 1; i < threadCount; i++)
+			m_Workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+
+	}
+
+	JobSystem::~JobSystem() {
+
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Quit = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for(auto& worker : m_Workers)
+			worker.join();
+
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const RangeFunc & func) {
+
+		if(count == 0)	return;
+		if(batchSize == 0)	batchSize = 1;
+
+		//Not worth waking anyone for a single batch
+		if(m_Workers.empty() || m_SingleThreaded || count <= batchSize) {
+			RunInline(count, batchSize, func);
+			return;
+		}
+
+		uint32_t thread = GetCurrentThread();
+		std::unique_lock<std::recursive_mutex> callLock(m_CallMutex, std::defer_lock);
+		if(t_System != this)
+			callLock.lock();
+
+		//One helper job per other thread that could usefully join in. Each pulls batches until none are left, so a
+		//thread that is busy elsewhere just finds nothing to do when it gets round to its helper
+		uint32_t batches = (count + batchSize - 1) / batchSize;
+		uint32_t helpers = std::min(batches, GetThreadCount()) - 1;
+
+		LoopState loop;
+		loop.func = &func;
+		loop.count = count;
+		loop.batchSize = batchSize;
+		loop.nextBatch.store(0);
+		loop.helpers.store(helpers);
+
+		for(uint32_t i = 0; i < helpers; i++)
+			Push(thread, { &JobSystem::RunLoopBatches, &loop, 0 });
+		WakeWorkers();
+
+		loop.RunBatches(thread);
+
+		//loop lives on this stack frame, so wait for every helper to let go of it
+		HelpUntilZero(loop.helpers, thread);
+
+	}
+
+	void JobSystem::Run(TaskGraph & graph) {
+
+		if(graph.Size() == 0)	return;
+
+		if(m_Workers.empty() || m_SingleThreaded) {
+			RunInline(graph);
+			return;
+		}
+
+		uint32_t thread = GetCurrentThread();
+		std::unique_lock<std::recursive_mutex> callLock(m_CallMutex, std::defer_lock);
+		if(t_System != this)
+			callLock.lock();
+
+		graph.Prepare();
+		GraphRun run = { this, &graph };
+
+		for(size_t i = 0; i < graph.Size(); i++) {
+			if(graph.m_Tasks[i].dependencies == 0)
+				Push(thread, { &JobSystem::RunGraphTask, &run, (uint32_t)i });
+		}
+		WakeWorkers();
+
+		HelpUntilZero(graph.m_Unfinished, thread);
+
+	}
+
+	void JobSystem::RunInline(uint32_t count, uint32_t batchSize, const RangeFunc & func) {
+
+		if(batchSize == 0)	batchSize = 1;
+
+		for(uint32_t begin = 0; begin < count; begin += batchSize)
+			func(begin, (count - begin > batchSize) ? begin + batchSize : count, 0);
+
+	}
+
+	void JobSystem::RunInline(TaskGraph & graph) {
+
+		std::vector<uint32_t> waiting(graph.Size());
+		std::vector<TaskGraph::TaskId> ready;
+		ready.reserve(graph.Size());
+
+		for(size_t i = 0; i < graph.Size(); i++) {
+			waiting[i] = graph.m_Tasks[i].dependencies;
+			if(waiting[i] == 0)
+				ready.push_back((TaskGraph::TaskId)i);
+		}
+
+		//ready doubles as a FIFO queue, tasks are appended as their last dependency finishes
+		for(size_t i = 0; i < ready.size(); i++) {
+			const TaskGraph::Task& task = graph.m_Tasks[ready[i]];
+			task.func(0);
+			for(auto successor : task.successors) {
+				if(--waiting[successor] == 0)
+					ready.push_back(successor);
+			}
+		}
+
+	}
+
+	void JobSystem::RunLoopBatches(void * data, uint32_t index, uint32_t thread) {
+
+		LoopState* loop = (LoopState*)data;
+		{
+			//Shows which threads joined a loop, the zones inside the batches say what they did
+			PHYSICS_ZONE("Loop batches");
+			loop->RunBatches(thread);
+		}
+		//Last touch of the loop, the caller may return as soon as this lands
+		loop->helpers.fetch_sub(1, std::memory_order_acq_rel);
+
+	}
+
+	void JobSystem::RunGraphTask(void * data, uint32_t index, uint32_t thread) {
+
+		GraphRun* run = (GraphRun*)data;
+		TaskGraph* graph = run->graph;
+		const TaskGraph::Task& task = graph->m_Tasks[index];
+
+		task.func(thread);
+
+		//Successors are queued before this task counts as finished, so the graph can't look done while they wait
+		for(auto successor : task.successors) {
+			if(graph->m_Waiting[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+				run->jobs->Push(thread, { &JobSystem::RunGraphTask, run, successor });
+		}
+		run->jobs->WakeWorkers();
+
+		graph->m_Unfinished.fetch_sub(1, std::memory_order_acq_rel);
+
+	}
+
+	void JobSystem::Push(uint32_t thread, const Job & job) {
+
+		//Counted first so the count never drops below the jobs actually queued
+		m_Queued.fetch_add(1, std::memory_order_release);
+		std::lock_guard<std::mutex> lock(m_Queues[thread].mutex);
+		m_Queues[thread].jobs.push_back(job);
+
+	}
+
+	bool JobSystem::Pop(uint32_t thread, Job & job) {
+
+		if(m_Queued.load(std::memory_order_acquire) == 0)	return false;
+
+		{
+			Queue& own = m_Queues[thread];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if(!own.jobs.empty()) {
+				job = own.jobs.back();
+				own.jobs.pop_back();
+				m_Queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		//Steal, starting with the next thread along so thieves spread out
+		uint32_t threadCount = GetThreadCount();
+		for(uint32_t i = 1; i < threadCount; i++) {
+			Queue& victim = m_Queues[(thread + i) % threadCount];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if(!victim.jobs.empty()) {
+				job = victim.jobs.front();
+				victim.jobs.pop_front();
+				m_Queued.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+
+	}
+
+	void JobSystem::HelpUntilZero(const std::atomic<uint32_t>& counter, uint32_t thread) {
+
+		while(counter.load(std::memory_order_acquire) != 0) {
+			Job job;
+			if(Pop(thread, job))
+				job.run(job.data, job.index, thread);
+			else
+				std::this_thread::yield();
+		}
+
+	}
+
+	void JobSystem::WakeWorkers() {
+
+		//Taking the lock orders this against a worker that has just found nothing queued and is about to sleep
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_all();
+
+	}
+
+	void JobSystem::WorkerLoop(uint32_t thread) {
+
+		t_System = this;
+		t_Thread = thread;
+
+		while(true) {
+
+			Job job;
+			if(Pop(thread, job)) {
+				job.run(job.data, job.index, thread);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_WakeCondition.wait(lock, [this]() { return m_Quit || m_Queued.load(std::memory_order_acquire) != 0; });
+			if(m_Quit)	return;
+
+		}
+
+	}
+
+	uint32_t JobSystem::GetCurrentThread() const {
+		return (t_System == this) ? t_Thread : 0;
+	}
+
+}
@@ -1,372 +1,307 @@
 #include "Physics/OctTree.hpp"
-#include "Physics/PhysicsObject.hpp"
-#include "Physics/AABBCollider.hpp"
-#include "Physics/SphereCollider.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/JobSystem.hpp"
+#include "Physics/Profiler.hpp"
 
-#include <glm/geometric.hpp>
-
-using std::vector;
+#include <algorithm>
 
 namespace Physics {
 
-	bool OctTree::m_treeBuilt = false;
-	bool OctTree::m_treeReady = false;
-	std::vector<Object*> OctTree::m_pendingInsertion;
-
-	OctTree::OctTree() : m_parent(nullptr) {
-	}
+	const uint32_t OctTree::MORTON_BITS;
 
-	OctTree::OctTree(const glm::vec3 & regionMin, const glm::vec3 & regionMax) : m_regionMin(regionMin), m_regionMax(regionMax), m_parent(nullptr) {
-	}
+	//Bodies per batch when work is split across threads
+	static const uint32_t BATCH_SIZE = 4096;
+	//Radix sort digit size. Two passes cover the 30 bit codes and a pass's counts still fit in cache
+	static const uint32_t RADIX_BITS = 15;
 
-	OctTree::OctTree(const glm::vec3 & regionMin, const glm::vec3 & regionMax, const std::vector<Object*>& objects) : m_regionMin(regionMin), m_regionMax(regionMax), m_objects(objects), m_parent(nullptr) {
+	OctTree::OctTree() : m_LeafSize(8) {
 	}
 
 	OctTree::~OctTree() {
-
-		//Clean up child nodes
-		for(auto child : m_children)
-			delete child;
-		m_children.clear();
-
 	}
 
-	void OctTree::Update() {
+	void OctTree::Update(const BodyStore & bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs) {
 
-		if(!m_treeReady)
-			UpdateTree();
+		PHYSICS_ZONE("OctTree::Update");
 
-		//Start a countdown timer for leaf nodes with no objects
-		//If the timer reaches zero then trim the leaf. However if we reuse the leaf before death then the lifespan should be doubled
-		//This gives us a "frequency" effect and lets us avoid inefficient memory allocating and deallocating
-		if(m_objects.size() == 0) {
-			if(!m_hasChildren) {
-				if(m_curLife == -1)
-					m_curLife = m_maxLifespan;
-				else if(m_curLife > 0)
-					m_curLife--;
-			}
+		m_Nodes.clear();
+		if(bodies.Size() == 0)	return;
 
-		} else {
-			if(m_curLife != -1) {
-				if(m_maxLifespan <= 64)
-					m_maxLifespan *= 2;
-				m_curLife = -1;
-			}
-		}
-			
-		std::vector<Object*> movedObjects;
+		ComputeKeys(bodies);
+		SortKeys();
+		GatherEntries(bodies);
+		EmitNodes();
+		FitNodes();
+		FindPairs(pairs);
 
-		//Update all objects in the current node
-		for(auto obj : m_objects) {
-			if(obj->FixedUpdate())
-				movedObjects.push_back(obj);
-		}
+	}
 
-		//Recursively update any child nodes
-		for(int flags = m_activeNodes, i = 0; flags > 0; flags >>= 1, i++) {
-			if((flags & 1) == 1)
-				m_children[i]->Update();
-		}
+	void OctTree::ComputeKeys(const BodyStore & bodies) {
 
-		//If an object moved, move it up to the closest containing parent and then work our way back down
-		for(auto obj : movedObjects) {
+		uint32_t count = (uint32_t)bodies.Size();
+		m_Keys.resize(count);
 
-			OctTree* current = this;
+		//Range of body centres, the octree's root cell spans this box
+		float sceneMin[3] = { bodies.boundsMin.x[0], bodies.boundsMin.y[0], bodies.boundsMin.z[0] };
+		float sceneMax[3] = { sceneMin[0], sceneMin[1], sceneMin[2] };
+		const std::vector<float>* mins[3] = { &bodies.boundsMin.x, &bodies.boundsMin.y, &bodies.boundsMin.z };
+		const std::vector<float>* maxs[3] = { &bodies.boundsMax.x, &bodies.boundsMax.y, &bodies.boundsMax.z };
 
-			//Determine how far up the tree we must traverse to reinsert the object
-			while(!current->Contains(obj, m_regionMin, m_regionMax)) {
-				if(current->m_parent != nullptr)
-					current = current->m_parent;
-				else break;
+		for(int axis = 0; axis < 3; axis++) {
+			const std::vector<float>& min = *mins[axis];
+			const std::vector<float>& max = *maxs[axis];
+			for(uint32_t i = 0; i < count; i++) {
+				float centre = (min[i] + max[i]) * 0.5f;
+				sceneMin[axis] = std::min(sceneMin[axis], centre);
+				sceneMax[axis] = std::max(sceneMax[axis], centre);
 			}
-				
-			auto find = std::find(m_objects.begin(), m_objects.end(), obj);
-			if(find != m_objects.end()) {
-				m_objects.erase(find);
-				current->DoInsert(obj);
-			}
-
 		}
 
-		//Trim any dead branches
-		for(int flags = m_activeNodes, i = 0; flags > 0; flags >>= 1, i++) {
-			if((flags & 1) == 1 && m_children[i]->m_curLife == 0) {
-				delete m_children[i];
-				m_children[i] = nullptr;
-				m_activeNodes ^= (unsigned char)(1 << i);
+		//Quantise each axis to MORTON_BITS. The largest axis sets the scale so cells stay cubes
+		float extent = std::max(sceneMax[0] - sceneMin[0], std::max(sceneMax[1] - sceneMin[1], sceneMax[2] - sceneMin[2]));
+		float maxCell = (float)((1u << MORTON_BITS) - 1);
+		float scale = (extent > 0.0f) ? maxCell / extent : 0.0f;
+
+		std::vector<uint64_t>& keys = m_Keys;
+		ParallelFor(m_Jobs, count, BATCH_SIZE, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			for(uint32_t i = begin; i < end; i++) {
+				uint32_t cell[3];
+				for(int axis = 0; axis < 3; axis++) {
+					float centre = ((*mins[axis])[i] + (*maxs[axis])[i]) * 0.5f;
+					float q = (centre - sceneMin[axis]) * scale;
+					//Clamping also catches NaN, which fails both comparisons
+					cell[axis] = (q > 0.0f) ? (uint32_t)std::min(q, maxCell) : 0;
+				}
+				uint32_t code = (SpreadBits(cell[0]) << 2) | (SpreadBits(cell[1]) << 1) | SpreadBits(cell[2]);
+				keys[i] = ((uint64_t)code << 32) | i;
 			}
-		}
+		});
 
 	}
 
-	void OctTree::Insert(Object* obj) {
-		m_pendingInsertion.push_back(obj);
-		m_treeReady = false;
-	}
-
-	void OctTree::BuildTree() {
+	void OctTree::SortKeys() {
 
-		//Terminate recursion if we're a leaf node
-		if(m_objects.size() <= 1)	return;
+		//Least significant digit first radix sort on the code, stable so equal codes keep body order.
+		//Both digit histograms are counted in a single read of the keys
+		uint32_t count = (uint32_t)m_Keys.size();
+		m_SortScratch.resize(count);
 
-		glm::vec3 dimensions = m_regionMax - m_regionMin;
+		const uint32_t buckets = 1u << RADIX_BITS;
+		const uint32_t passes = (3 * MORTON_BITS + RADIX_BITS - 1) / RADIX_BITS;
+		m_RadixOffsets.assign(buckets * passes, 0);
 
-		if(dimensions == glm::vec3()) {
-			FindEnclosingCube();
-			dimensions = m_regionMax - m_regionMin;
+		for(auto key : m_Keys) {
+			for(uint32_t pass = 0; pass < passes; pass++)
+				m_RadixOffsets[pass * buckets + ((key >> (32 + pass * RADIX_BITS)) & (buckets - 1))]++;
 		}
 
-		//Check to see if dimensions are required size
-		if(dimensions.x <= MIN_SIZE && dimensions.y <= MIN_SIZE && dimensions.z <= MIN_SIZE)
-			return;
+		std::vector<uint64_t>* from = &m_Keys;
+		std::vector<uint64_t>* to = &m_SortScratch;
 
-		this->m_hasChildren = true;
+		for(uint32_t pass = 0; pass < passes; pass++) {
 
-		glm::vec3 half = dimensions / 2.0f;
-		glm::vec3 center = m_regionMin + half;
+			uint32_t* offsets = &m_RadixOffsets[pass * buckets];
+			uint32_t shift = 32 + pass * RADIX_BITS;
 
-		//Create sub-divided regions for each octant
-		glm::vec3 octantMin[8] = {
-			{ m_regionMin.x, m_regionMin.y, m_regionMin.z }, { center.x, m_regionMin.y, m_regionMin.z},
-			{ center.x, m_regionMin.y, center.z }, { m_regionMin.x, m_regionMin.y, center.z }, 
-			{ m_regionMin.x, center.y, m_regionMin.z }, { center.x, center.y, m_regionMin.z },
-			{ center.x, center.y, center.z }, { m_regionMin.x, center.y, center.z }
-		};
-		glm::vec3 octantMax[8] = {
-			{ center.x, center.y, center.z }, { m_regionMax.x, center.y, center.z },
-			{ m_regionMax.x, center.y, m_regionMax.z }, { center.x, center.y, m_regionMax.z },
-			{ center.x, m_regionMax.y, center.z }, { m_regionMax.x, m_regionMax.y, center.z },
-			{ m_regionMax.x, m_regionMax.y, m_regionMax.z }, { center.x, m_regionMax.y, m_regionMax.z }
-		};
+			//Every key landing in one bucket means this digit is already sorted
+			if(offsets[((*from)[0] >> shift) & (buckets - 1)] == count)	continue;
 
-		//This list contains objects that will be passed down to child nodes should they fit
-		vector<Object*>octList[8];
-		//Objects that will be removed from parent if they fit
-		vector<Object*>delist;
-
-		for(auto iter : m_objects) {
-			for(int region = 0; region < 8; region++) {
-				if(Contains(iter, octantMin[region], octantMax[region])) {
-					octList[region].push_back(iter);
-					delist.push_back(iter);
-					break;
-				}
+			uint32_t start = 0;
+			for(uint32_t i = 0; i < buckets; i++) {
+				uint32_t size = offsets[i];
+				offsets[i] = start;
+				start += size;
 			}
-		}
-		
-		//Remove objects if they are marked for delisting
-		for(auto iter : delist) {
-			auto find = std::find(m_objects.begin(), m_objects.end(), iter);
-			if(find != m_objects.end())
-				m_objects.erase(find);
-		}
 
-		//Create child nodes where there are items contained in the bounding region
-		for(unsigned int i = 0; i < 8; i++) {
-			m_children.push_back(CreateNode(octantMin[i], octantMax[i], octList[i]));
-			m_activeNodes |= (unsigned char)(1 << i);
-			m_children.back()->BuildTree();
+			for(auto key : *from)
+				(*to)[offsets[(key >> shift) & (buckets - 1)]++] = key;
+
+			std::swap(from, to);
+
 		}
 
-		m_treeReady = true;
-		m_treeBuilt = true;
+		//An odd number of passes leaves the result in the scratch buffer
+		if(from != &m_Keys)
+			m_Keys.swap(m_SortScratch);
 
 	}
 
-	void OctTree::UpdateTree() {
+	void OctTree::GatherEntries(const BodyStore & bodies) {
 
-		if(!m_treeBuilt) {
-			while(!m_pendingInsertion.empty()) {
-				m_objects.push_back(m_pendingInsertion.back());
-				m_pendingInsertion.pop_back();
-			}
-			BuildTree();
+		uint32_t count = (uint32_t)m_Keys.size();
+		m_Entries.resize(count);
 
-		} else {
-			while(!m_pendingInsertion.empty()) {
-				DoInsert(m_pendingInsertion.back());
-				m_pendingInsertion.pop_back();
+		ParallelFor(m_Jobs, count, BATCH_SIZE, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+			for(uint32_t s = begin; s < end; s++) {
+				uint32_t body = (uint32_t)m_Keys[s];
+				Entry& entry = m_Entries[s];
+				entry.min[0] = bodies.boundsMin.x[body];	entry.min[1] = bodies.boundsMin.y[body];	entry.min[2] = bodies.boundsMin.z[body];
+				entry.max[0] = bodies.boundsMax.x[body];	entry.max[1] = bodies.boundsMax.y[body];	entry.max[2] = bodies.boundsMax.z[body];
+				entry.body = body;
 			}
-		}
+		});
 
-		m_treeReady = true;
 	}
 
-	void OctTree::DoInsert(Object* obj) {
-
-		//Make sure we don't have to insert an object deeper than it needs to go
-		if(m_objects.size() <= 1 && m_activeNodes == 0) {
-			m_objects.push_back(obj);
-			return;
-		}
-
-		glm::vec3 dimensions = m_regionMax - m_regionMin;
+	void OctTree::EmitNodes() {
 
-		//Check to see if dimensions are required size
-		if(dimensions.x <= MIN_SIZE && dimensions.y <= MIN_SIZE && dimensions.z <= MIN_SIZE) {
-			m_objects.push_back(obj);
-			return;
-		}
-		
-		glm::vec3 half = dimensions / 2.0f;
-		glm::vec3 center = m_regionMin + half;
-
-		//Create sub-divided regions for each octant
-		glm::vec3 octantMin[8] = {
-			{ m_regionMin.x, m_regionMin.y, m_regionMin.z },{ center.x, m_regionMin.y, m_regionMin.z },
-			{ center.x, m_regionMin.y, center.z },{ m_regionMin.x, m_regionMin.y, center.z },
-			{ m_regionMin.x, center.y, m_regionMin.z },{ center.x, center.y, m_regionMin.z },
-			{ center.x, center.y, center.z },{ m_regionMin.x, center.y, center.z }
-		};
-		glm::vec3 octantMax[8] = {
-			{ center.x, center.y, center.z },{ m_regionMax.x, center.y, center.z },
-			{ m_regionMax.x, center.y, m_regionMax.z },{ center.x, center.y, m_regionMax.z },
-			{ center.x, m_regionMax.y, center.z },{ m_regionMax.x, m_regionMax.y, center.z },
-			{ m_regionMax.x, m_regionMax.y, m_regionMax.z },{ center.x, m_regionMax.y, m_regionMax.z }
+		struct Pending {
+			uint32_t node;
+			uint32_t level;
 		};
 
-		if(!m_children.empty()) {
-			for(unsigned int i = 0; i < m_children.size(); i++) {
-				if(m_children[i] == nullptr)	continue;
-				octantMin[i] = m_children[i]->m_regionMin;
-				octantMax[i] = m_children[i]->m_regionMax;
-			}
-		}
+		Node root;
+		root.begin = 0;
+		root.end = (uint32_t)m_Keys.size();
+		root.firstChild = 0;
+		root.childCount = 0;
+		m_Nodes.push_back(root);
 
-		if(Contains(obj, m_regionMin, m_regionMax)) {
-			bool found = false;
-			for(int i = 0; i < 8; i++) {
-				if(Contains(obj, octantMin[i], octantMax[i])) {
-					if(m_children[i] != nullptr)
-						m_children[i]->Insert(obj);
-					else {
-						m_children[i] = CreateNode(octantMin[i], octantMax[i], obj);
-						m_activeNodes |= (unsigned char)(1 << i);
-					}
-					found = true;
-					break;
-				}
-			}
-			if(!found)
-				m_objects.push_back(obj);
-		} else {
-			FindEnclosingCube();
-			BuildTree();
-		}
-		
+		//Depth first, so the stack never holds more than the 7 siblings left at each level plus the node being split
+		Pending stack[7 * MORTON_BITS + 8];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, 0 };
 
-	}
+		while(stackSize > 0) {
 
-	void OctTree::FindEnclosingCube() {
+			Pending pending = stack[--stackSize];
 
-		glm::vec3 offset = glm::vec3(0) - m_regionMin;
-		m_regionMin += offset;
-		m_regionMax += offset;
+			uint32_t begin = m_Nodes[pending.node].begin;
+			uint32_t end = m_Nodes[pending.node].end;
+			if(end - begin <= m_LeafSize || pending.level == MORTON_BITS)	continue;
 
-		int highX = (int)glm::ceil(glm::max(glm::max(m_regionMax.x, m_regionMax.y), m_regionMax.z));
+			//Keys in this cell share their top 3 * level bits, the next 3 pick the child.
+			//Only children that hold bodies become nodes, and they are stored side by side
+			uint32_t shift = 32 + 3 * (MORTON_BITS - 1 - pending.level);
+			uint32_t firstChild = (uint32_t)m_Nodes.size();
 
-		//See if our cube dimension is already at a power of 2. If it is, we don't have to do any work.
-		for(int bit = 0; bit < 32; bit++) {
-			if(highX == 1 << 2) {
-				m_regionMax = glm::vec3(highX, highX, highX);
+			for(uint32_t digit = 0; digit < 8 && begin < end; digit++) {
 
-				m_regionMin -= offset;
-				m_regionMax -= offset;
-				return;
-			}
-		}
+				uint32_t childEnd = (uint32_t)(std::partition_point(m_Keys.begin() + begin, m_Keys.begin() + end,
+					[shift, digit](uint64_t key) { return ((key >> shift) & 7) <= digit; }) - m_Keys.begin());
 
-		//We have a cube with non-power of 2 dimensions so find the next highest value of 2
-		auto upperPowerOfTwo = [](int numToPow)->int {
-			numToPow--;
-			numToPow |= numToPow >> 1;
-			numToPow |= numToPow >> 2;
-			numToPow |= numToPow >> 4;
-			numToPow |= numToPow >> 8;
-			numToPow |= numToPow >> 16;
-			numToPow++;
-			return numToPow;
-		};
+				if(childEnd == begin)	continue;
 
-		int x = upperPowerOfTwo(highX);
+				Node child;
+				child.begin = begin;
+				child.end = childEnd;
+				child.firstChild = 0;
+				child.childCount = 0;
+				m_Nodes.push_back(child);
+				stack[stackSize++] = { (uint32_t)m_Nodes.size() - 1, pending.level + 1 };
 
-		m_regionMax = glm::vec3(x);
-		m_regionMin -= offset;
-		m_regionMax -= offset;
+				begin = childEnd;
 
-	}
+			}
 
-	bool OctTree::Contains(Object * obj, const glm::vec3 & minRegion, const glm::vec3 & maxRegion) {
+			m_Nodes[pending.node].firstChild = firstChild;
+			m_Nodes[pending.node].childCount = (uint32_t)m_Nodes.size() - firstChild;
 
-		switch(obj->GetCollider()->GetType()) {
-			case Collider::ColliderType::AABB: {
-				//Cast to AABB collider
-				AABBCollider* ac = (AABBCollider*)obj->GetCollider();
-				
-				//Cache AABB values
-				auto& boxCenter = ac->GetCentre();
-				auto& boxExtents = ac->GetExtents();
+		}
 
-				//Calculate min and max of AABB
-				glm::vec3 boxMin = boxCenter - boxExtents;
-				glm::vec3 boxMax = boxCenter + boxExtents;
+	}
 
-				return(boxMin.x > minRegion.x && boxMax.x < maxRegion.x) &&
-					  (boxMin.y > minRegion.y && boxMax.y < maxRegion.y) &&
-					  (boxMin.z > minRegion.z && boxMin.z < maxRegion.z);
+	void OctTree::FitNodes() {
 
-			}
-			case Collider::ColliderType::SPHERE: {
-				//Cast to Sphere collider
-				SphereCollider* sc = (SphereCollider*)obj->GetCollider();
+		//Children always come after their parent, so walking backwards fits every child before its parent
+		for(size_t i = m_Nodes.size(); i-- > 0;) {
 
-				//Cache sphere values
-				auto& spherePos = sc->GetPosition();
-				float sphereRadius = sc->GetRadius();
+			Node& node = m_Nodes[i];
 
-				return(spherePos.x - sphereRadius > minRegion.x && spherePos.x + sphereRadius < maxRegion.x)&&
-					  (spherePos.y - sphereRadius > minRegion.y && spherePos.y + sphereRadius < maxRegion.y)&&
-					  (spherePos.z - sphereRadius > minRegion.z && spherePos.z + sphereRadius < maxRegion.z);
+			const float* firstMin;
+			const float* firstMax;
+			if(node.childCount == 0) {
+				firstMin = m_Entries[node.begin].min;
+				firstMax = m_Entries[node.begin].max;
+			} else {
+				firstMin = m_Nodes[node.firstChild].min;
+				firstMax = m_Nodes[node.firstChild].max;
+			}
+			for(int axis = 0; axis < 3; axis++) {
+				node.min[axis] = firstMin[axis];
+				node.max[axis] = firstMax[axis];
+			}
 
+			uint32_t first = (node.childCount == 0) ? node.begin : node.firstChild;
+			uint32_t last = (node.childCount == 0) ? node.end : node.firstChild + node.childCount;
+			for(uint32_t j = first + 1; j < last; j++) {
+				const float* min = (node.childCount == 0) ? m_Entries[j].min : m_Nodes[j].min;
+				const float* max = (node.childCount == 0) ? m_Entries[j].max : m_Nodes[j].max;
+				for(int axis = 0; axis < 3; axis++) {
+					node.min[axis] = std::min(node.min[axis], min[axis]);
+					node.max[axis] = std::max(node.max[axis], max[axis]);
+				}
 			}
-				
+
 		}
 
-		return false;
 	}
 
-	OctTree * OctTree::CreateNode(const glm::vec3 & regionMin, const glm::vec3 & regionMax, std::vector<Object*>& objs) {
+	void OctTree::FindPairs(std::vector<BodyPair>& pairs) {
 
-		OctTree* node = new OctTree(regionMin, regionMax, objs);
-		node->m_parent = this;
+		uint32_t count = (uint32_t)m_Entries.size();
+		uint32_t batches = (count + BATCH_SIZE - 1) / BATCH_SIZE;
+		if(m_BatchPairs.size() < batches)
+			m_BatchPairs.resize(batches);
 
-		return node;
+		ParallelFor(m_Jobs, count, BATCH_SIZE, [&](uint32_t begin, uint32_t end, uint32_t thread) {
 
-	}
+			std::vector<BodyPair>& out = m_BatchPairs[begin / BATCH_SIZE];
+			out.clear();
 
-	OctTree * OctTree::CreateNode(const glm::vec3 & regionMin, const glm::vec3 & regionMax, Object * obj) {
-		vector<Object*> temp = { obj };
+			uint32_t stack[8 * MORTON_BITS + 1];
 
-		OctTree* node = new OctTree(regionMin, regionMax, temp);
-		node->m_parent = this;
+			for(uint32_t s = begin; s < end; s++) {
 
-		return node;
+				const Entry& entry = m_Entries[s];
+				uint32_t top = 0;
+				stack[top++] = 0;
 
-	}
+				while(top > 0) {
+
+					const Node& node = m_Nodes[stack[--top]];
 
-	void OctTree::DetectCollisions(std::vector<Object*>* parentObjs) {
+					//Each pair is reported by its earlier entry, so cells holding nothing past s can be skipped
+					if(node.end <= s + 1)	continue;
+					if(entry.min[0] > node.max[0] || entry.max[0] < node.min[0] ||
+					   entry.min[1] > node.max[1] || entry.max[1] < node.min[1] ||
+					   entry.min[2] > node.max[2] || entry.max[2] < node.min[2])
+						continue;
 
-		//TODO: Implement detection algorithm
+					if(node.childCount > 0) {
+						for(uint32_t c = 0; c < node.childCount; c++)
+							stack[top++] = node.firstChild + c;
+						continue;
+					}
 
-		if(parentObjs != nullptr) {
-			for(auto parent : *parentObjs) {
-				for(auto obj : m_objects) {
+					for(uint32_t k = std::max(node.begin, s + 1); k < node.end; k++) {
+						const Entry& other = m_Entries[k];
+						if(entry.min[0] <= other.max[0] && entry.max[0] >= other.min[0] &&
+						   entry.min[1] <= other.max[1] && entry.max[1] >= other.min[1] &&
+						   entry.min[2] <= other.max[2] && entry.max[2] >= other.min[2])
+							out.push_back({ entry.body, other.body });
+					}
 
 				}
+
 			}
-		}
+
+		});
+
+		for(uint32_t b = 0; b < batches; b++)
+			pairs.insert(pairs.end(), m_BatchPairs[b].begin(), m_BatchPairs[b].end());
+
+	}
+
+	uint32_t OctTree::SpreadBits(uint32_t v) {
+
+		v &= 0x3ff;
+		v = (v | (v << 16)) & 0x030000ff;
+		v = (v | (v << 8)) & 0x0300f00f;
+		v = (v | (v << 4)) & 0x030c30c3;
+		v = (v | (v << 2)) & 0x09249249;
+		return v;
 
 	}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,220 @@
+#include "Physics/PairSet.hpp"
+#include "Physics/CpuFeatures.hpp"
+
+#include <algorithm>
+
+#if PHYSICS_X86
+#include <xmmintrin.h>
+#endif
+
+namespace Physics {
+
+	const uint64_t PairSet::EMPTY;
+
+	//Pairs ahead of the one being inserted whose slot is loaded early
+	static const size_t PREFETCH_DISTANCE = 8;
+
+	PairSet::PairSet() : m_Slots(64, EMPTY), m_Count(0) {
+	}
+
+	PairSet::~PairSet() {
+	}
+
+	bool PairSet::Insert(uint32_t a, uint32_t b) {
+
+		if(!InsertKey(MakeKey(a, b)))	return false;
+
+		AddPartner(a, b);
+		AddPartner(b, a);
+		return true;
+
+	}
+
+	void PairSet::InsertPairs(const BodyPair * pairs, size_t count) {
+
+		//Sized for every pair being new, so nothing moves while inserting
+		if((m_Count + count) * 2 > m_Slots.size())
+			Grow(m_Count + count);
+
+		//Count each body's new partners so every list grows once
+		uint32_t highest = 0;
+		for(size_t i = 0; i < count; i++)
+			highest = std::max(highest, std::max(pairs[i].a, pairs[i].b));
+		if(count > 0 && m_Partners.size() <= highest)
+			m_Partners.resize((size_t)highest + 1);
+
+		std::vector<uint32_t> added(m_Partners.size(), 0);
+		for(size_t i = 0; i < count; i++) {
+			added[pairs[i].a]++;
+			added[pairs[i].b]++;
+		}
+		for(size_t body = 0; body < m_Partners.size(); body++) {
+			if(added[body] > 0)
+				m_Partners[body].reserve(m_Partners[body].size() + added[body]);
+		}
+
+		size_t mask = m_Slots.size() - 1;
+		for(size_t i = 0; i < count; i++) {
+
+			//Slots are scattered over the table, so start loading a few ahead
+#if PHYSICS_X86
+			if(i + PREFETCH_DISTANCE < count)
+				_mm_prefetch((const char*)&m_Slots[HashKey(MakeKey(pairs[i + PREFETCH_DISTANCE].a, pairs[i + PREFETCH_DISTANCE].b)) & mask], _MM_HINT_T0);
+#endif
+
+			uint32_t a = pairs[i].a, b = pairs[i].b;
+			uint64_t key = MakeKey(a, b);
+			size_t slot = FindSlot(key);
+			if(m_Slots[slot] == key)	continue;
+
+			m_Slots[slot] = key;
+			m_Count++;
+			m_Partners[a].push_back(b);
+			m_Partners[b].push_back(a);
+
+		}
+
+	}
+
+	bool PairSet::Erase(uint32_t a, uint32_t b) {
+
+		if(!EraseKey(MakeKey(a, b)))	return false;
+
+		DropPartner(a, b);
+		DropPartner(b, a);
+		return true;
+
+	}
+
+	bool PairSet::Contains(uint32_t a, uint32_t b) const {
+		uint64_t key = MakeKey(a, b);
+		return m_Slots[FindSlot(key)] == key;
+	}
+
+	void PairSet::Clear() {
+		for(auto& slot : m_Slots)
+			slot = EMPTY;
+		m_Count = 0;
+		//Lists keep their capacity so a rebuilt set doesn't allocate them again
+		for(auto& partners : m_Partners)
+			partners.clear();
+	}
+
+	void PairSet::GetPairs(std::vector<BodyPair>& pairs) const {
+
+		for(auto key : m_Slots) {
+			if(key == EMPTY)	continue;
+			pairs.push_back({ (uint32_t)(key >> 32), (uint32_t)key });
+		}
+
+	}
+
+	void PairSet::RemoveBody(uint32_t index, uint32_t from) {
+
+		if(index < m_Partners.size()) {
+			for(auto partner : m_Partners[index]) {
+				EraseKey(MakeKey(index, partner));
+				DropPartner(partner, index);
+			}
+			m_Partners[index].clear();
+		}
+
+		if(index == from || from >= m_Partners.size())	return;
+
+		//Keys change with the index, so each of from's pairs goes in again under the new one
+		for(auto partner : m_Partners[from]) {
+			EraseKey(MakeKey(from, partner));
+			InsertKey(MakeKey(index, partner));
+			std::vector<uint32_t>& partners = m_Partners[partner];
+			*std::find(partners.begin(), partners.end(), from) = index;
+		}
+		m_Partners[index].swap(m_Partners[from]);
+
+	}
+
+	bool PairSet::InsertKey(uint64_t key) {
+
+		//Keep the load factor under a half so probe runs stay short
+		if((m_Count + 1) * 2 > m_Slots.size())
+			Grow();
+
+		size_t slot = FindSlot(key);
+		if(m_Slots[slot] == key)	return false;
+
+		m_Slots[slot] = key;
+		m_Count++;
+		return true;
+
+	}
+
+	bool PairSet::EraseKey(uint64_t key) {
+
+		size_t mask = m_Slots.size() - 1;
+		size_t slot = FindSlot(key);
+		if(m_Slots[slot] == EMPTY)	return false;
+
+		//Shift back any entry in the probe run that could sit in the freed slot
+		size_t next = slot;
+		for(;;) {
+			next = (next + 1) & mask;
+			if(m_Slots[next] == EMPTY)	break;
+
+			size_t home = HashKey(m_Slots[next]) & mask;
+			bool canMove = (slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next);
+			if(canMove) {
+				m_Slots[slot] = m_Slots[next];
+				slot = next;
+			}
+		}
+
+		m_Slots[slot] = EMPTY;
+		m_Count--;
+		return true;
+
+	}
+
+	size_t PairSet::FindSlot(uint64_t key) const {
+
+		size_t mask = m_Slots.size() - 1;
+		size_t slot = HashKey(key) & mask;
+		while(m_Slots[slot] != EMPTY && m_Slots[slot] != key)
+			slot = (slot + 1) & mask;
+		return slot;
+
+	}
+
+	void PairSet::Grow(size_t count) {
+
+		size_t capacity = m_Slots.size() * 2;
+		while(count * 2 > capacity)
+			capacity *= 2;
+
+		std::vector<uint64_t> old;
+		old.swap(m_Slots);
+		m_Slots.assign(capacity, EMPTY);
+
+		for(auto key : old) {
+			if(key == EMPTY)	continue;
+			m_Slots[FindSlot(key)] = key;
+		}
+
+	}
+
+	void PairSet::AddPartner(uint32_t body, uint32_t partner) {
+
+		if(m_Partners.size() <= body)
+			m_Partners.resize(body + 1);
+		m_Partners[body].push_back(partner);
+
+	}
+
+	void PairSet::DropPartner(uint32_t body, uint32_t partner) {
+
+		std::vector<uint32_t>& partners = m_Partners[body];
+		auto iter = std::find(partners.begin(), partners.end(), partner);
+		*iter = partners.back();
+		partners.pop_back();
+
+	}
+
+}
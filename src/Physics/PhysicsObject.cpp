@@ -1,38 +1,40 @@
 #include "Physics/PhysicsObject.hpp"
 #include "Physics/Collider.hpp"
-
-#include <glm/geometric.hpp>
+#include "Physics/Pool.hpp"
 
 namespace Physics {
 
-	Object::Object() : m_Mass(1.0f), m_Friction(1.0f), m_Bounciness(1.0f), m_Collider(nullptr), m_MaxVelocity(glm::vec3(20, 30, 20)) {
+	Object::Object() : m_Store(nullptr), m_Index(0), m_Position(glm::vec3(0)), m_Velocity(glm::vec3(0)), m_MaxVelocity(glm::vec3(20, 30, 20)),
+		m_Acceleration(glm::vec3(0)), m_Mass(1.0f), m_Friction(1.0f), m_Bounciness(1.0f), m_Collider(nullptr), m_Pool(nullptr) {
 	}
 
 	Object::~Object() {
-		delete m_Collider;
+		Collider::Destroy(m_Collider);
 	}
 
-	bool Object::FixedUpdate() {
-
-		glm::vec3 posOld = m_Position;
-
-		float fixedTime = 1.0f / 60.0f;
+	void Object::Destroy(Object * obj) {
 
-		ApplyForce(-m_Velocity * m_Friction);
+		if(obj == nullptr)	return;
 
-		m_Velocity += m_Acceleration * fixedTime;		
-		m_Position += m_Velocity * fixedTime;
-		m_Acceleration = glm::vec3();
-		UpdateTransform();
-
-		glm::vec3 movementDiff = glm::abs(m_Position - posOld);
+		BlockPool* pool = obj->m_Pool;
+		if(pool == nullptr) {
+			delete obj;
+			return;
+		}
 
-		return(movementDiff.x > 0.1f || movementDiff.y > 0.1f || movementDiff.z > 0.1f);
+		obj->~Object();
+		pool->Free(obj);
 
 	}
 
 	void Object::ApplyForce(const glm::vec3 & a_Force) {
 
+		if(m_Store != nullptr) {
+			m_Store->acceleration.Set(m_Index, m_Store->acceleration.Get(m_Index) + a_Force * m_Store->invMass[m_Index]);
+			m_Store->Wake(m_Index);
+			return;
+		}
+
 		m_Acceleration += a_Force / m_Mass;
 
 	}
@@ -46,18 +48,85 @@ namespace Physics {
 	}
 
 	void Object::SetPosition(const glm::vec3 & a_Pos) {
-		m_Position = a_Pos;
-		UpdateTransform();
+		if(m_Store == nullptr) {
+			m_Position = a_Pos;
+			return;
+		}
+
+		//Moved, not simulated, so there's nothing to interpolate from
+		m_Store->position.Set(m_Index, a_Pos);
+		m_Store->previousPosition.Set(m_Index, a_Pos);
+		m_Store->Wake(m_Index);
 	}
 
-	void Object::SetCollider(Collider * coll) {
-		delete m_Collider;
-		m_Collider = coll;
+	void Object::SetVelocity(const glm::vec3 & a_Vel) {
+		if(m_Store == nullptr) {
+			m_Velocity = a_Vel;
+			return;
+		}
+
+		m_Store->velocity.Set(m_Index, a_Vel);
+		m_Store->Wake(m_Index);
+	}
+
+	void Object::SetMaxVelocity(const glm::vec3 & a_MaxVel) {
+		if(m_Store != nullptr)	m_Store->maxVelocity.Set(m_Index, a_MaxVel);
+		else					m_MaxVelocity = a_MaxVel;
+	}
+
+	void Object::SetAcceleration(const glm::vec3 & a_Acc) {
+		if(m_Store != nullptr)	m_Store->acceleration.Set(m_Index, a_Acc);
+		else					m_Acceleration = a_Acc;
 	}
 
-	void Object::UpdateTransform() {
+	void Object::SetMass(float a_Mass) {
+		if(m_Store != nullptr) {
+			m_Store->mass[m_Index] = a_Mass;
+			m_Store->invMass[m_Index] = 1.0f / a_Mass;
+		} else {
+			m_Mass = a_Mass;
+		}
+	}
+
+	void Object::SetFriction(float a_Fric) {
+		if(m_Store != nullptr)	m_Store->friction[m_Index] = a_Fric;
+		else					m_Friction = a_Fric;
+	}
+
+	void Object::SetBounciness(float a_Bounce) {
+		if(m_Store != nullptr)	m_Store->bounciness[m_Index] = a_Bounce;
+		else					m_Bounciness = a_Bounce;
+	}
+
+	void Object::SetRigid(bool a_Rigid) {
+		if(m_Store == nullptr) {
+			m_Rigid = a_Rigid;
+			return;
+		}
+
+		//Rigid bodies never sleep
+		m_Store->Wake(m_Index);
+		if(a_Rigid)		m_Store->flags[m_Index] |= BodyStore::BODY_RIGID;
+		else			m_Store->flags[m_Index] &= ~BodyStore::BODY_RIGID;
+	}
+
+	void Object::SetContinuous(bool a_Continuous) {
+		if(m_Store == nullptr) {
+			m_Continuous = a_Continuous;
+			return;
+		}
+
+		if(a_Continuous)	m_Store->flags[m_Index] |= BodyStore::BODY_CONTINUOUS;
+		else				m_Store->flags[m_Index] &= ~BodyStore::BODY_CONTINUOUS;
+	}
+
+	void Object::SetCollider(Collider * coll) {
+		Collider::Destroy(m_Collider);
+		m_Collider = coll;
 		if(m_Collider != nullptr)
-			m_Collider->Transform(this);
+			m_Collider->SetOwner(this);
+		if(m_Store != nullptr)
+			m_Store->SetCollider(m_Index, coll);
 	}
 
-}
\ No newline at end of file
+}
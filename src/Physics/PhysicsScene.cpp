@@ -3,231 +3,727 @@
 #include "Physics/Collider.hpp"
 #include "Physics/Spring.hpp"
 #include "Physics/AABBCollider.hpp"
-#include "Physics/Tree.hpp"
+#include "Physics/SphereCollider.hpp"
+#include "Physics/DynamicAABBTree.hpp"
+#include "Physics/SweepAndPrune.hpp"
+#include "Physics/SpatialHashGrid.hpp"
+#include "Physics/OctTree.hpp"
+#include "Physics/JobSystem.hpp"
+#include "Physics/ProfileSink.hpp"
+#include "Physics/Profiler.hpp"
+#include "Physics/SceneListener.hpp"
+#include "Physics/Constraint.hpp"
 
 #include <glm/geometric.hpp>
-#include <imgui.h>
-#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
 
 namespace Physics {
 
-	Scene::Scene() {
+	//Pairs ahead of the current one whose contact cache slot is prefetched
+	static const uint32_t PREFETCH_DISTANCE = 8;
+
+	//Batches adding or removing more than this fraction of the scene rebuild the broadphase instead of updating it
+	//body by body
+	static const size_t BULK_BUILD_DIVISOR = 4;
+
+	//Items per parallel batch for each phase that splits its work
+	static const uint32_t DEFAULT_GRAIN_SIZES[(int)ProfilePhase::COUNT] = {
+		4096,		//CONSTRAINTS, springs within a colour
+		4096,		//INTEGRATE, bodies
+		1,			//BROADPHASE, each broadphase picks its own
+		1,			//CCD, serial
+		1024,		//NARROWPHASE, candidate pairs
+		256,		//SOLVE, contacts within a colour
+		1			//ISLANDS, serial
+	};
+
+	//Sleeping and rigid bodies don't move on their own
+	static inline bool IsResting(const Object* obj) {
+		return obj == nullptr || obj->IsSleeping() || obj->GetRigid();
+	}
+
+	Scene::Scene() : m_SpringsStale(false), m_ReusedContactCount(0), m_GlobalForce(glm::vec3(0)), m_Gravity(glm::vec3(0)), m_FixedTimeStep(1.0f / 60.0f),
+		m_Accumulator(0.0f), m_MaxStepsPerCall(4), m_Substeps(1), m_MaxSubsteps(8), m_AdaptiveSubsteps(false), m_CourantNumber(0.5f), m_LastSubstepCount(1),
+		m_SubstepTime(0.0f), m_JobSystem(nullptr), m_OwnsJobSystem(true), m_Broadphase(nullptr), m_BroadphaseType(BroadphaseType::DYNAMIC_TREE), m_BroadphaseStale(false),
+		m_ObjectPool(sizeof(Object)), m_SpherePool(sizeof(SphereCollider)), m_AABBPool(sizeof(AABBCollider)), m_ProfileSink(nullptr), m_Listener(nullptr) {
+
+		std::copy(DEFAULT_GRAIN_SIZES, DEFAULT_GRAIN_SIZES + (int)ProfilePhase::COUNT, m_GrainSizes);
+
+		m_JobSystem = new JobSystem();
 
-		m_tree = new Tree();
+		m_Broadphase = CreateBroadphase(m_BroadphaseType);
+		m_Broadphase->SetJobSystem(m_JobSystem);
+		m_Broadphase->SetScratch(&m_Scratch);
+
+		BuildStepGraph();
 
 	}
 
 	Scene::~Scene() {
 
-		//Clean up tree
-		delete m_tree;
+		//Clean up broadphase
+		delete m_Broadphase;
 
-		//Clean up objects
-		for(auto iter : m_Objects)
-			delete iter;
-		m_Objects.clear();
+		//Clean up objects, detaching them first so they don't write back into the store
+		while(m_Bodies.Size() > 0) {
+			Object* obj = m_Bodies.objects.back();
+			m_Bodies.Remove((uint32_t)m_Bodies.Size() - 1);
+			Object::Destroy(obj);
+		}
 
 		//Clean up constraints
 		for(auto iter : m_Constraints)
 			delete iter;
 		m_Constraints.clear();
 
+		if(m_OwnsJobSystem)
+			delete m_JobSystem;
+
+	}
+
+	uint32_t Scene::Step(float dt) {
+
+		m_Accumulator += dt;
+
+		//Drop whatever can't be caught up on in one call rather than falling further behind every frame
+		float maxTime = m_FixedTimeStep * m_MaxStepsPerCall;
+		if(m_Accumulator > maxTime)
+			m_Accumulator = maxTime;
+
+		uint32_t steps = 0;
+		while(m_Accumulator >= m_FixedTimeStep) {
+			FixedUpdate();
+			m_Accumulator -= m_FixedTimeStep;
+			steps++;
+		}
+
+		return steps;
+
 	}
 
 	void Scene::FixedUpdate() {
 
-		m_CollisionPairs.clear();
-		m_InCollisionLookup.clear();
+		PHYSICS_ZONE("Scene::FixedUpdate");
 
-		//Update Constraints
-		for(auto iter : m_Constraints) {
-			iter->FixedUpdate();
+		//Nothing from the last step is still using it
+		m_Scratch.Reset();
+
+		//Bulk attaches and removes left the broadphase to be built in one go
+		if(m_BroadphaseStale) {
+			PHYSICS_ZONE("Broadphase build");
+			ScopedPhaseTimer broadphaseTimer(m_ProfileSink, ProfilePhase::BROADPHASE);
+			m_Broadphase->Build(m_Bodies);
+			m_BroadphaseStale = false;
 		}
 
-		//Update Tree
-		m_tree->Update(this);
-
-		//Update all objects
-		//for(auto iter : m_Objects) {
-		//
-		//	glm::vec3 currAccel = iter->GetAcceleration();
-		//
-		//	iter->SetAcceleration(currAccel + m_Gravity);
-		//	iter->ApplyForce(m_GlobalForce);
-		//	iter->FixedUpdate();
-		//
-		//	//Temp collision with ground
-		//	auto& pos = iter->GetPosition();
-		//	if(pos.y < 0.5f) {
-		//		auto& vel = iter->GetVelocity();
-		//		iter->SetPosition(glm::vec3(pos.x, 0.5f, pos.z));
-		//		iter->SetVelocity(glm::vec3(vel.x, -vel.y, vel.z));
-		//	}
-		//
-		//}
-
-		m_GlobalForce = glm::vec3();
-
-		//ImGui::Begin("Performance");
-		//
-		//std::chrono::steady_clock::time_point detectStart = std::chrono::steady_clock::now();
-		//DetectCollisions();
-		//std::chrono::steady_clock::time_point detectEnd = std::chrono::steady_clock::now();
-		//std::chrono::duration<double> detectionLength = std::chrono::duration_cast<std::chrono::duration<double>>(detectEnd - detectStart);
-		//
-		//ImGui::Text("Detection time: %fms.", detectionLength.count() * 1000);
-		//
-		//std::chrono::steady_clock::time_point resolveStart = std::chrono::steady_clock::now();
-		//ResolveCollisions();
-		//std::chrono::steady_clock::time_point resolveEnd = std::chrono::steady_clock::now();
-		//std::chrono::duration<double> resolveLength = std::chrono::duration_cast<std::chrono::duration<double>>(resolveEnd - resolveStart);
-		//
-		//ImGui::Text("Resolve time: %fms", resolveLength.count() * 1000);
-		//
-		//ImGui::End();
+		//Where bodies were before this step, for interpolation
+		m_Bodies.previousPosition.x = m_Bodies.position.x;
+		m_Bodies.previousPosition.y = m_Bodies.position.y;
+		m_Bodies.previousPosition.z = m_Bodies.position.z;
+
+		m_LastSubstepCount = ChooseSubstepCount();
+
+		float timeStep = m_FixedTimeStep / m_LastSubstepCount;
+		for(uint32_t i = 0; i < m_LastSubstepCount; i++)
+			Substep(timeStep);
+
+		m_CollisionEvents.EndStep(m_ObjectSlots, m_Bodies);
+
+		//The global force lasts the whole step, every substep feels it
+		m_GlobalForce = glm::vec3(0);
+
+	}
+
+	uint32_t Scene::ChooseSubstepCount() const {
+
+		if(!m_AdaptiveSubsteps || m_Bodies.Size() == 0)	return m_Substeps;
+
+		//Fastest awake body
+		float maxSpeedSq = 0.0f;
+		for(size_t i = 0; i < m_Bodies.Size(); i++) {
+			if(m_Bodies.flags[i] & (BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING))	continue;
+			float vx = m_Bodies.velocity.x[i], vy = m_Bodies.velocity.y[i], vz = m_Bodies.velocity.z[i];
+			maxSpeedSq = std::max(maxSpeedSq, vx * vx + vy * vy + vz * vz);
+		}
+
+		//Smallest collider, as a diameter or a box's shortest side
+		float minSize = FLT_MAX;
+		for(auto radius : m_Bodies.spheres.radius)
+			minSize = std::min(minSize, radius * 2.0f);
+		for(size_t i = 0; i < m_Bodies.boxes.body.size(); i++) {
+			glm::vec3 extents = m_Bodies.boxes.extents.Get(i);
+			minSize = std::min(minSize, std::min(extents.x, std::min(extents.y, extents.z)) * 2.0f);
+		}
+
+		if(maxSpeedSq == 0.0f || minSize == FLT_MAX || minSize <= 0.0f)	return m_Substeps;
+
+		float substeps = std::ceil(std::sqrt(maxSpeedSq) * m_FixedTimeStep / (m_CourantNumber * minSize));
+		if(substeps >= (float)m_MaxSubsteps)	return std::max(m_MaxSubsteps, m_Substeps);
+		return std::max((uint32_t)substeps, m_Substeps);
+
+	}
+
+	glm::vec3 Scene::GetInterpolatedPosition(const Object * obj) const {
+
+		if(obj == nullptr || !obj->IsAttached())	return (obj != nullptr) ? obj->GetPosition() : glm::vec3(0);
+
+		uint32_t index = obj->GetIndex();
+		if(index >= m_Bodies.Size() || m_Bodies.objects[index] != obj)	return obj->GetPosition();
+
+		float alpha = GetInterpolationAlpha();
+		return m_Bodies.previousPosition.Get(index) * (1.0f - alpha) + m_Bodies.position.Get(index) * alpha;
+
+	}
+
+	void Scene::Substep(float timeStep) {
+
+		PHYSICS_ZONE("Substep");
+		m_SubstepTime = timeStep;
+		m_JobSystem->Run(m_StepGraph);
+
+	}
+
+	void Scene::BuildStepGraph() {
+
+		typedef TaskGraph::TaskId TaskId;
+
+		//Nothing else this substep reads last substep's pairs or contacts, so they're cleared alongside the constraints
+		TaskId reset = m_StepGraph.AddTask("Reset", [this](uint32_t thread) {
+			PHYSICS_ZONE("Reset");
+			m_CandidatePairs.clear();
+			m_Contacts.clear();
+			//Resting pairs aren't tested, so sleeping bodies keep the count they fell asleep with
+			for(uint32_t i = 0; i < (uint32_t)m_Bodies.Size(); i++) {
+				if(!m_Bodies.IsSleeping(i))
+					m_Bodies.contactCount[i] = 0;
+			}
+		});
+
+		TaskId constraints = m_StepGraph.AddTask("Constraints", [this](uint32_t thread) {
+			PHYSICS_ZONE("Constraints");
+			ScopedPhaseTimer constraintTimer(m_ProfileSink, ProfilePhase::CONSTRAINTS);
+			if(m_SpringsStale) {
+				m_SpringSolver.Build(m_Bodies, m_Constraints, m_LooseConstraints);
+				m_SpringsStale = false;
+			}
+			m_SpringSettings.timeStep = m_SubstepTime;
+			m_SpringSettings.batchSize = m_GrainSizes[(int)ProfilePhase::CONSTRAINTS];
+			m_SpringSolver.Apply(m_Bodies, m_SpringSettings, m_JobSystem);
+
+			//Everything else writes forces through its objects, so runs one at a time
+			for(auto iter : m_LooseConstraints) {
+				//Constraints between resting bodies would only wake them
+				Object* objA;
+				Object* objB;
+				iter->GetConnections(&objA, &objB);
+				if(IsResting(objA) && IsResting(objB))	continue;
+				iter->FixedUpdate();
+			}
+		});
+
+		TaskId integrate = m_StepGraph.AddTask("Integrate", [this](uint32_t thread) {
+			PHYSICS_ZONE("Integrate");
+			m_Continuous.BeginStep(m_Bodies);
+
+			ScopedPhaseTimer integrateTimer(m_ProfileSink, ProfilePhase::INTEGRATE);
+			IntegratorSettings settings;
+			settings.gravity = m_Gravity;
+			settings.globalForce = m_GlobalForce;
+			settings.timeStep = m_SubstepTime;
+			settings.batchSize = m_GrainSizes[(int)ProfilePhase::INTEGRATE];
+			m_Integrator.Integrate(m_Bodies, settings, m_MovedMask, m_JobSystem);
+		});
+
+		//Gather candidate pairs
+		TaskId broadphase = m_StepGraph.AddTask("Broadphase", [this](uint32_t thread) {
+			PHYSICS_ZONE("Broadphase");
+			ScopedPhaseTimer broadphaseTimer(m_ProfileSink, ProfilePhase::BROADPHASE);
+			m_Bodies.UpdateBounds();
+			m_Continuous.SweepBounds(m_Bodies, m_MovedMask);
+			m_Broadphase->Update(m_Bodies, m_MovedMask, m_CandidatePairs);
+		});
+
+		//Pull fast bodies back to whatever they passed through on the way
+		TaskId ccd = m_StepGraph.AddTask("CCD", [this](uint32_t thread) {
+			PHYSICS_ZONE("CCD");
+			ScopedPhaseTimer ccdTimer(m_ProfileSink, ProfilePhase::CCD);
+			m_Continuous.Resolve(m_Bodies, m_CandidatePairs);
+		});
+
+		TaskId narrowphase = m_StepGraph.AddTask("Narrowphase", [this](uint32_t thread) {
+			PHYSICS_ZONE("Narrowphase");
+			ScopedPhaseTimer detectTimer(m_ProfileSink, ProfilePhase::NARROWPHASE);
+			DetectCollisions();
+		});
+
+		TaskId solve = m_StepGraph.AddTask("Solve", [this](uint32_t thread) {
+			PHYSICS_ZONE("Solve");
+			ScopedPhaseTimer resolveTimer(m_ProfileSink, ProfilePhase::SOLVE);
+			ResolveCollisions(m_SubstepTime);
+			m_ContactCache.EndStep();
+			m_CollisionEvents.AddContacts(m_ObjectSlots, m_Contacts, m_ContactImpulses);
+		});
+
+		TaskId islands = m_StepGraph.AddTask("Islands", [this](uint32_t thread) {
+			PHYSICS_ZONE("Islands");
+			ScopedPhaseTimer islandTimer(m_ProfileSink, ProfilePhase::ISLANDS);
+			UpdateIslands(m_SubstepTime);
+		});
+
+		//Each phase reads what the one before wrote, so past the reset the phases form a chain. The parallelism is
+		//inside each phase
+		m_StepGraph.AddDependency(constraints, integrate);
+		//Springs can wake bodies, which decides whose contact counts are reset
+		m_StepGraph.AddDependency(constraints, reset);
+		m_StepGraph.AddDependency(integrate, broadphase);
+		m_StepGraph.AddDependency(reset, broadphase);
+		m_StepGraph.AddDependency(broadphase, ccd);
+		m_StepGraph.AddDependency(ccd, narrowphase);
+		m_StepGraph.AddDependency(narrowphase, solve);
+		m_StepGraph.AddDependency(solve, islands);
+
+	}
+
+	void Scene::ApplyGlobalForce(const glm::vec3 & force) {
+
+		m_GlobalForce += force;
+		if(force != glm::vec3(0))
+			m_Islands.WakeAll(m_Bodies);
+
+	}
+
+	void Scene::SetBroadphase(BroadphaseType type) {
+
+		if(type == m_BroadphaseType)	return;
+
+		delete m_Broadphase;
+		m_BroadphaseType = type;
+		m_Broadphase = CreateBroadphase(type);
+		m_Broadphase->SetJobSystem(m_JobSystem);
+		m_Broadphase->SetScratch(&m_Scratch);
+
+		//Move existing bodies over
+		m_Bodies.UpdateBounds();
+		m_Broadphase->Build(m_Bodies);
+		m_BroadphaseStale = false;
+
+	}
+
+	void Scene::SetThreadCount(uint32_t count) {
+
+		bool singleThreaded = m_JobSystem->GetSingleThreaded();
+
+		if(m_OwnsJobSystem)
+			delete m_JobSystem;
+		m_JobSystem = new JobSystem(count);
+		m_JobSystem->SetSingleThreaded(singleThreaded);
+		m_OwnsJobSystem = true;
+		m_Broadphase->SetJobSystem(m_JobSystem);
+
+	}
+
+	void Scene::SetJobSystem(JobSystem * jobs) {
+
+		if(jobs == nullptr)	return;
+
+		if(m_OwnsJobSystem)
+			delete m_JobSystem;
+		m_JobSystem = jobs;
+		m_OwnsJobSystem = false;
+		m_Broadphase->SetJobSystem(m_JobSystem);
+
+	}
+
+	Object * Scene::CreateObject() {
+
+		Object* obj = new(m_ObjectPool.Allocate()) Object();
+		obj->m_Pool = &m_ObjectPool;
+		return obj;
+
+	}
+
+	Collider * Scene::CreateSphereCollider(float radius) {
+
+		Collider* coll = new(m_SpherePool.Allocate()) SphereCollider(radius);
+		coll->m_Pool = &m_SpherePool;
+		return coll;
+
+	}
+
+	Collider * Scene::CreateAABBCollider(const glm::vec3 & extents) {
+
+		Collider* coll = new(m_AABBPool.Allocate()) AABBCollider(extents);
+		coll->m_Pool = &m_AABBPool;
+		return coll;
 
 	}
 
 	void Scene::AttachObject(Object * obj) {
 
-		auto find = std::find(m_Objects.begin(), m_Objects.end(), obj);
-		if(find != m_Objects.end())		return;
-		
-		m_Objects.push_back(obj);
+		//Objects already attached, here or to another scene, are ignored
+		if(obj->IsAttached())	return;
+
+		uint32_t index = m_Bodies.Add(obj);
+		obj->m_Handle = m_ObjectSlots.Insert();
+
+		//Springs waiting on this end can be packed now
+		if(!obj->m_Constraints.empty())
+			m_SpringsStale = true;
+
+		//A stale broadphase picks the body up when it is built
+		if(!m_BroadphaseStale)
+			m_Broadphase->Insert(m_Bodies, index);
 
-		m_tree->Insert(obj);
+	}
+
+	void Scene::AttachObjects(Object * const * objs, size_t count) {
+
+		//Small batches relative to the scene are cheaper to insert one at a time
+		if(count * BULK_BUILD_DIVISOR > m_Bodies.Size())
+			m_BroadphaseStale = true;
+
+		m_Bodies.Reserve(m_Bodies.Size() + count);
+		for(size_t i = 0; i < count; i++)
+			AttachObject(objs[i]);
 
 	}
 
 	void Scene::RemoveObject(Object * obj) {
 
-		auto find = std::find(m_Objects.begin(), m_Objects.end(), obj);
-		if(find == m_Objects.end())		return;
+		if(!IsInStore(obj))	return;
+
+		//Whatever was resting on it has to fall
+		m_Islands.WakeIsland(m_Bodies, obj->GetIndex());
+		m_ContactCache.RemoveBody(obj->GetIndex(), (uint32_t)m_Bodies.Size() - 1);
+
+		DetachBody(obj);
 
-		delete (*find);
-		m_Objects.erase(find);
+	}
+
+	void Scene::RemoveObjects(Object * const * objs, size_t count) {
+
+		//Objects are destroyed as they go, so each one is looked at while they're all still alive. A repeat of one
+		//already removed then has a stale handle instead of a dangling pointer
+		std::vector<Handle> handles;
+		std::vector<uint32_t> indices;
+		handles.reserve(count);
+		indices.reserve(count);
+		for(size_t i = 0; i < count; i++) {
+			if(IsInStore(objs[i])) {
+				handles.push_back(objs[i]->GetHandle());
+				indices.push_back(objs[i]->GetIndex());
+			}
+		}
+
+		if(handles.size() * BULK_BUILD_DIVISOR <= m_Bodies.Size()) {
+			for(auto handle : handles)
+				RemoveObject(handle);
+			return;
+		}
+
+		//Wake every island losing a body in one pass, and drop the contact cache rather than renumbering it once per
+		//body. It only costs a step of warm starting
+		m_Islands.WakeIslands(m_Bodies, indices.data(), indices.size());
+		m_ContactCache.Clear();
+		m_BroadphaseStale = true;
+
+		for(auto handle : handles) {
+			Object* obj = FindObject(handle);
+			if(obj != nullptr)
+				DetachBody(obj);
+		}
+
+	}
+
+	bool Scene::IsInStore(const Object * obj) const {
+
+		if(obj == nullptr || !obj->IsAttached())	return false;
+
+		//An object attached to another scene can have any index
+		uint32_t index = obj->GetIndex();
+		return index < m_Bodies.Size() && m_Bodies.objects[index] == obj;
+
+	}
+
+	void Scene::DetachBody(Object * obj) {
+
+		//Constraints can't outlive either end
+		while(!obj->m_Constraints.empty())
+			RemoveConstraint(obj->m_Constraints.back());
+
+		if(m_Listener != nullptr)
+			m_Listener->OnObjectRemoved(obj);
+
+		if(!m_BroadphaseStale)
+			m_Broadphase->Remove(m_Bodies, obj->GetIndex());
+		//The last body moves into the hole, its springs have to be packed with its new index
+		if(!m_Bodies.objects.back()->m_Constraints.empty())
+			m_SpringsStale = true;
+
+		m_ObjectSlots.Remove(obj->m_Handle);
+		m_Bodies.Remove(obj->GetIndex());
+		Object::Destroy(obj);
+
+	}
+
+	bool Scene::RemoveObject(Handle handle) {
+
+		Object* obj = FindObject(handle);
+		if(obj == nullptr)	return false;
+
+		RemoveObject(obj);
+		return true;
+
+	}
+
+	Object * Scene::FindObject(Handle handle) const {
+		return m_ObjectSlots.IsValid(handle) ? m_Bodies.objects[m_ObjectSlots.GetIndex(handle)] : nullptr;
+	}
+
+	Constraint * Scene::FindConstraint(Handle handle) const {
+		return m_ConstraintSlots.IsValid(handle) ? m_Constraints[m_ConstraintSlots.GetIndex(handle)] : nullptr;
+	}
+
+	uint32_t Scene::GetContactCount(const Object * obj) const {
+
+		if(obj == nullptr || !obj->IsAttached())	return 0;
+
+		uint32_t index = obj->GetIndex();
+		if(index >= m_Bodies.Size() || m_Bodies.objects[index] != obj)	return 0;
+
+		return m_Bodies.contactCount[index];
 
 	}
 
 	void Scene::AttachConstraint(Constraint * con) {
 
-		auto find = std::find(m_Constraints.begin(), m_Constraints.end(), con);
-		if(find != m_Constraints.end())		return;
+		//Constraints already attached, here or to another scene, are ignored
+		if(con->m_Scene != nullptr)	return;
 
+		con->m_Scene = this;
+		con->m_Handle = m_ConstraintSlots.Insert();
 		m_Constraints.push_back(con);
+		m_SpringsStale = true;
+
+		//Objects list their constraints so removing one takes its constraints with it
+		if(con->m_ObjA != nullptr)
+			con->m_ObjA->m_Constraints.push_back(con);
+		if(con->m_ObjB != nullptr && con->m_ObjB != con->m_ObjA)
+			con->m_ObjB->m_Constraints.push_back(con);
+
+	}
+
+	//Swap-removes con from an object's constraint list. Objects have few constraints so the search is short
+	static void UnlinkConstraint(std::vector<Constraint*>& constraints, Constraint* con) {
+
+		auto find = std::find(constraints.begin(), constraints.end(), con);
+		if(find == constraints.end())	return;
+
+		*find = constraints.back();
+		constraints.pop_back();
 
 	}
 
 	void Scene::RemoveConstraint(Constraint * con) {
 
-		auto find = std::find(m_Constraints.begin(), m_Constraints.end(), con);
-		if(find == m_Constraints.end())	return;
-
-		delete (*find);
-		m_Constraints.erase(find);
-
-	}
-
-	//void Scene::DetectCollisions() {
-	//
-	//	m_CollisionPairs.clear();
-	//	m_InCollisionLookup.clear();
-	//
-	//	//Brute force collision detection
-	//	//TODO: Replace with OctTree
-	//	for(auto iterA = m_Objects.begin(); iterA != m_Objects.end(); iterA++) {
-	//		//Grab A's collider
-	//		Collider* colliderA = (*iterA)->GetCollider();
-	//		for(auto iterB = iterA + 1; iterB != m_Objects.end(); iterB++) {
-	//			//Grab B's collider
-	//			Collider* colliderB = (*iterB)->GetCollider();
-	//			CollisionInfo info;
-	//			//Check for intersection
-	//			if(colliderA->Intersects(colliderB, &info.intersection)) {
-	//				info.objA = (*iterA);
-	//				info.objB = (*iterB);
-	//
-	//				m_CollisionPairs.push_back(info);
-	//				m_InCollisionLookup[(*iterA)] = true;
-	//				m_InCollisionLookup[(*iterB)] = true;
-	//			}
-	//		}
-	//	}
-	//
-	//}
-	//
-	//void Scene::ResolveCollisions() {
-	//
-	//	//Loop through all collision pairs
-	//	for(auto iter : m_CollisionPairs) {
-	//
-	//		//Get data from collision
-	//
-	//		//find out if objects are able to be moved
-	//		const bool objAStatic = iter.objA->GetRigid();
-	//		const bool objBStatic = iter.objB->GetRigid();
-	//
-	//		//If neither object can be moved then continue
-	//		if(objAStatic && objBStatic)	continue;
-	//
-	//		//Collision normal (direction of collision and overlap)
-	//		glm::vec3 colNorm = glm::normalize(iter.intersection.collisionVector);
-	//
-	//		//Mass of both objects
-	//		float massA = iter.objA->GetMass();
-	//		float massB = iter.objB->GetMass();
-	//
-	//		//Velocities of both objects (we might use relative velocity)
-	//		glm::vec3 velA = iter.objA->GetVelocity();
-	//		glm::vec3 velB = iter.objB->GetVelocity();
-	//
-	//		//Relative velocity
-	//		glm::vec3 relVel = velA - velB;
-	//
-	//		//Find out how much velocity each object had in the collision normal direction
-	//		//In fact, since we have the relative velocity, we can just find out once
-	//		//how much total velocity there is in the collision normal direction
-	//		glm::vec3 colVector = colNorm * (glm::dot(relVel, colNorm));
-	//
-	//		//Find the bounciness of the collision
-	//		float bounciness = glm::min(iter.objA->GetBounciness(), iter.objB->GetBounciness());
-	//
-	//		//Calculate the impulse force (vector of force and direction)
-	//		glm::vec3 impulse = (1.0f + bounciness) * colVector / (1.0f / massA + 1.0f / massB);
-	//
-	//		//Move the objects so that they're not overlapping
-	//		glm::vec3 separate = iter.intersection.collisionVector * 0.5f;
-	//
-	//		if(objAStatic) {
-	//
-	//			//Calculate force to be reflected back to the non-static object
-	//			glm::vec3 reflectForce = -1 * massB * colNorm * glm::dot(colNorm, velB);
-	//
-	//			iter.objB->SetVelocity(reflectForce);
-	//
-	//			iter.objB->SetPosition(iter.objB->GetPosition() + (separate * 2.0f));
-	//
-	//			continue;
-	//		}
-	//		if(objBStatic) {
-	//
-	//			//Calculate force to be reflected back to the non-static object
-	//			glm::vec3 reflectForce = -1 * massA * colNorm * glm::dot(colNorm, velA);
-	//
-	//			iter.objA->SetVelocity(reflectForce);
-	//
-	//			iter.objA->SetPosition(iter.objA->GetPosition() - (separate * 2.0f));
-	//			continue;
-	//		}
-	//
-	//		//Apply that force to both objects (each one in an opposite direction)
-	//		iter.objA->SetVelocity(velA - impulse * (1.0f / massA));
-	//		iter.objB->SetVelocity(velB + impulse * (1.0f / massB));
-	//
-	//		iter.objB->SetPosition(iter.objB->GetPosition() + separate);
-	//		iter.objA->SetPosition(iter.objA->GetPosition() - separate);			
-	//
-	//	}
-	//
-	//}
-}
\ No newline at end of file
+		if(con->m_Scene != this)	return;
+
+		if(m_Listener != nullptr)
+			m_Listener->OnConstraintRemoved(con);
+
+		//Mirror the slot map's swap-remove in the dense list
+		uint32_t index = m_ConstraintSlots.GetIndex(con->m_Handle);
+		m_ConstraintSlots.Remove(con->m_Handle);
+		m_Constraints[index] = m_Constraints.back();
+		m_Constraints.pop_back();
+		m_SpringsStale = true;
+
+		if(con->m_ObjA != nullptr)
+			UnlinkConstraint(con->m_ObjA->m_Constraints, con);
+		if(con->m_ObjB != nullptr)
+			UnlinkConstraint(con->m_ObjB->m_Constraints, con);
+
+		delete con;
+
+	}
+
+	bool Scene::RemoveConstraint(Handle handle) {
+
+		Constraint* con = FindConstraint(handle);
+		if(con == nullptr)	return false;
+
+		RemoveConstraint(con);
+		return true;
+
+	}
+
+	Broadphase * Scene::CreateBroadphase(BroadphaseType type) {
+
+		switch(type) {
+			case BroadphaseType::SWEEP_AND_PRUNE:	return new SweepAndPrune();
+			case BroadphaseType::SPATIAL_HASH:		return new SpatialHashGrid();
+			case BroadphaseType::OCTREE:			return new OctTree();
+			case BroadphaseType::DYNAMIC_TREE:
+			default:								return new DynamicAABBTree();
+		}
+
+	}
+
+	void Scene::DetectCollisions() {
+
+		m_ContactCache.BeginStep();
+
+		uint32_t batchSize = m_GrainSizes[(int)ProfilePhase::NARROWPHASE];
+
+		uint32_t candidateCount = (uint32_t)m_CandidatePairs.size();
+		uint32_t candidateBatches = (candidateCount + batchSize - 1) / batchSize;
+		if(m_BatchReused.size() < candidateBatches) {
+			m_BatchReused.resize(candidateBatches);
+			m_BatchFresh.resize(candidateBatches);
+		}
+
+		//Pairs that were touching last step and have barely moved relative to each other keep last step's contact,
+		//the rest go through the narrowphase. Resting pairs are dropped here as they would be by the dispatcher
+		ParallelFor(m_JobSystem, candidateCount, batchSize, [this, batchSize](uint32_t begin, uint32_t end, uint32_t thread) {
+
+			PHYSICS_ZONE("Contact reuse");
+
+			std::vector<Contact>& reused = m_BatchReused[begin / batchSize];
+			std::vector<BodyPair>& fresh = m_BatchFresh[begin / batchSize];
+			reused.clear();
+			fresh.clear();
+
+			for(uint32_t i = begin; i < end; i++) {
+
+				//Lookups are scattered over the table, so start loading a few ahead
+				if(i + PREFETCH_DISTANCE < end)
+					m_ContactCache.Prefetch(m_CandidatePairs[i + PREFETCH_DISTANCE].a, m_CandidatePairs[i + PREFETCH_DISTANCE].b);
+
+				const BodyPair& pair = m_CandidatePairs[i];
+				if(m_Bodies.IsRestingPair(pair.a, pair.b))	continue;
+
+				size_t slot = m_ContactCache.Find(pair.a, pair.b);
+				if(slot == ContactCache::NOT_FOUND) {
+					fresh.push_back(pair);
+					continue;
+				}
+
+				const ContactCache::Entry& entry = m_ContactCache.GetEntry(slot);
+				if(m_ContactCache.CanReuse(slot, m_Bodies.position.Get(entry.b) - m_Bodies.position.Get(entry.a))) {
+					Contact contact;
+					contact.a = entry.a;
+					contact.b = entry.b;
+					contact.intersection = entry.intersection;
+					reused.push_back(contact);
+				} else {
+					fresh.push_back(pair);
+				}
+
+			}
+
+		});
+
+		m_FreshPairs.clear();
+		m_ReusedContactCount = 0;
+		for(uint32_t b = 0; b < candidateBatches; b++) {
+			m_FreshPairs.insert(m_FreshPairs.end(), m_BatchFresh[b].begin(), m_BatchFresh[b].end());
+			m_ReusedContactCount += m_BatchReused[b].size();
+		}
+
+		//Group the rest by collider types, then test them in parallel batches, each writing only to its own
+		//contact buffer. A batch that spans two groups runs both kernels over its part of each
+		m_Dispatcher.Sort(m_Bodies, m_FreshPairs);
+
+		uint32_t pairCount = m_Dispatcher.GetSortedCount();
+		uint32_t batches = (pairCount + batchSize - 1) / batchSize;
+		if(m_BatchContacts.size() < batches)
+			m_BatchContacts.resize(batches);
+
+		ParallelFor(m_JobSystem, pairCount, batchSize, [this, batchSize](uint32_t begin, uint32_t end, uint32_t thread) {
+
+			PHYSICS_ZONE("Narrowphase kernels");
+			std::vector<Contact>& contacts = m_BatchContacts[begin / batchSize];
+			contacts.clear();
+			m_Dispatcher.Run(m_Bodies, begin, end, contacts);
+
+		});
+
+		//Merge in batch order so the contact list is the same whatever the thread count.
+		//Room is made up front so cache slots don't move while contacts are being added
+		size_t newContacts = m_ReusedContactCount;
+		for(uint32_t b = 0; b < batches; b++)
+			newContacts += m_BatchContacts[b].size();
+		m_ContactCache.Reserve(newContacts);
+		m_ContactSlots.clear();
+		m_ContactImpulses.clear();
+
+		PHYSICS_ZONE("Merge contacts");
+		for(uint32_t b = 0; b < batches; b++)
+			MergeContacts(m_BatchContacts[b], true);
+		for(uint32_t b = 0; b < candidateBatches; b++)
+			MergeContacts(m_BatchReused[b], false);
+
+	}
+
+	void Scene::MergeContacts(const std::vector<Contact>& contacts, bool regenerated) {
+
+		for(size_t i = 0; i < contacts.size(); i++) {
+
+			if(i + PREFETCH_DISTANCE < contacts.size())
+				m_ContactCache.Prefetch(contacts[i + PREFETCH_DISTANCE].a, contacts[i + PREFETCH_DISTANCE].b);
+
+			const Contact& contact = contacts[i];
+
+			//Refreshes the cache entry and picks up the impulse the pair built up last step
+			glm::vec3 relPosition = m_Bodies.position.Get(contact.b) - m_Bodies.position.Get(contact.a);
+			size_t slot = m_ContactCache.Touch(contact.a, contact.b, relPosition, contact.intersection, regenerated);
+
+			m_Contacts.push_back(contact);
+			m_ContactSlots.push_back(slot);
+			m_ContactImpulses.push_back(m_ContactCache.GetEntry(slot).normalImpulse);
+			if(!m_Bodies.IsSleeping(contact.a))	m_Bodies.contactCount[contact.a]++;
+			if(!m_Bodies.IsSleeping(contact.b))	m_Bodies.contactCount[contact.b]++;
+
+		}
+
+	}
+
+	void Scene::UpdateIslands(float timeStep) {
+
+		m_IslandEdges.clear();
+
+		for(auto& contact : m_Contacts)
+			m_IslandEdges.push_back({ contact.a, contact.b });
+
+		//Packed springs already know their bodies
+		const std::vector<uint32_t>& springA = m_SpringSolver.GetBodiesA();
+		const std::vector<uint32_t>& springB = m_SpringSolver.GetBodiesB();
+		for(size_t i = 0; i < springA.size(); i++)
+			m_IslandEdges.push_back({ springA[i], springB[i] });
+
+		for(auto con : m_LooseConstraints) {
+			Object* objA;
+			Object* objB;
+			con->GetConnections(&objA, &objB);
+			if(!IsInStore(objA) || !IsInStore(objB))	continue;
+			m_IslandEdges.push_back({ objA->GetIndex(), objB->GetIndex() });
+		}
+
+		m_Islands.Update(m_Bodies, m_IslandEdges, timeStep);
+
+	}
+
+	void Scene::ResolveCollisions(float timeStep) {
+
+		m_SolverSettings.timeStep = timeStep;
+		m_Solver.Solve(m_Bodies, m_Contacts, m_ContactImpulses, m_SolverSettings, m_JobSystem);
+
+		//Kept in the cache so each pair starts from it next step
+		for(size_t c = 0; c < m_Contacts.size(); c++)
+			m_ContactCache.SetImpulse(m_ContactSlots[c], m_ContactImpulses[c]);
+
+	}
+
+}
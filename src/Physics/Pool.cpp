@@ -0,0 +1,135 @@
+#include "Physics/Pool.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+namespace Physics {
+
+	static inline size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	BlockPool::BlockPool(size_t blockSize, size_t blocksPerChunk) : m_BlockSize(0), m_BlocksPerChunk(std::max<size_t>(blocksPerChunk, 1)),
+		m_FreeList(nullptr), m_Live(0), m_Peak(0) {
+
+		//Every block has to be able to hold the free list link and keep the next block aligned
+		m_BlockSize = AlignUp(std::max(blockSize, sizeof(void*)), alignof(std::max_align_t));
+
+	}
+
+	BlockPool::~BlockPool() {
+
+		for(auto chunk : m_Chunks)
+			std::free(chunk);
+
+	}
+
+	void* BlockPool::Allocate() {
+
+		if(m_FreeList == nullptr)
+			AddChunk();
+
+		void* block = m_FreeList;
+		m_FreeList = *(void**)block;
+
+		m_Live++;
+		m_Peak = std::max(m_Peak, m_Live);
+		return block;
+
+	}
+
+	void BlockPool::Free(void * block) {
+
+		if(block == nullptr)	return;
+
+		*(void**)block = m_FreeList;
+		m_FreeList = block;
+		m_Live--;
+
+	}
+
+	void BlockPool::AddChunk() {
+
+		char* chunk = (char*)std::malloc(m_BlockSize * m_BlocksPerChunk);
+		if(chunk == nullptr)	throw std::bad_alloc();
+		m_Chunks.push_back(chunk);
+
+		//Link the blocks front to back so they are handed out in address order
+		for(size_t i = m_BlocksPerChunk; i > 0; i--) {
+			void* block = chunk + (i - 1) * m_BlockSize;
+			*(void**)block = m_FreeList;
+			m_FreeList = block;
+		}
+
+	}
+
+	ScratchArena::ScratchArena(size_t blockSize) : m_BlockSize(blockSize), m_Current(0), m_Offset(0), m_Used(0), m_Peak(0), m_Capacity(0) {
+	}
+
+	ScratchArena::~ScratchArena() {
+
+		for(auto& block : m_Blocks)
+			std::free(block.data);
+
+	}
+
+	void * ScratchArena::Allocate(size_t bytes, size_t alignment) {
+
+		//Move on to the next block, or add one, until the allocation fits
+		for(;;) {
+
+			if(m_Current < m_Blocks.size()) {
+				Block& block = m_Blocks[m_Current];
+				size_t start = AlignUp((size_t)block.data + m_Offset, alignment) - (size_t)block.data;
+				if(start + bytes <= block.size) {
+					m_Used += start + bytes - m_Offset;
+					m_Peak = std::max(m_Peak, m_Used);
+					m_Offset = start + bytes;
+					return block.data + start;
+				}
+				if(m_Current + 1 < m_Blocks.size()) {
+					m_Current++;
+					m_Offset = 0;
+					continue;
+				}
+			}
+
+			AddBlock(bytes + alignment);
+			m_Current = m_Blocks.size() - 1;
+			m_Offset = 0;
+
+		}
+
+	}
+
+	void ScratchArena::Reset() {
+
+		//The step spilled past the first block, swap them all for one that holds the lot
+		if(m_Blocks.size() > 1) {
+			size_t size = m_Capacity;
+			for(auto& block : m_Blocks)
+				std::free(block.data);
+			m_Blocks.clear();
+			m_Capacity = 0;
+			AddBlock(size);
+		}
+
+		m_Current = 0;
+		m_Offset = 0;
+		m_Used = 0;
+
+	}
+
+	void ScratchArena::AddBlock(size_t minSize) {
+
+		size_t size = std::max(minSize, m_BlockSize);
+		char* data = (char*)std::malloc(size);
+		if(data == nullptr)	throw std::bad_alloc();
+
+		m_Blocks.push_back({ data, size });
+		m_Capacity += size;
+
+	}
+
+}
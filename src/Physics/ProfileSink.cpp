@@ -0,0 +1,20 @@
+#include "Physics/ProfileSink.hpp"
+
+namespace Physics {
+
+	const char* GetPhaseName(ProfilePhase phase) {
+
+		switch(phase) {
+			case ProfilePhase::CONSTRAINTS:		return "Constraints";
+			case ProfilePhase::INTEGRATE:		return "Integrate";
+			case ProfilePhase::BROADPHASE:		return "Broadphase";
+			case ProfilePhase::CCD:				return "CCD";
+			case ProfilePhase::NARROWPHASE:		return "Narrowphase";
+			case ProfilePhase::SOLVE:			return "Solve";
+			case ProfilePhase::ISLANDS:			return "Islands";
+			default:							return "Unknown";
+		}
+
+	}
+
+}
@@ -0,0 +1,112 @@
+#include "Physics/Profiler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+namespace Physics {
+
+	std::atomic<bool> Profiler::s_Enabled(false);
+	std::mutex Profiler::s_RingMutex;
+	std::vector<std::unique_ptr<Profiler::Ring>> Profiler::s_Rings;
+
+	//The calling thread's ring once it has recorded a zone
+	static thread_local void* t_Ring = nullptr;
+
+	uint64_t Profiler::Now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Profiler::Record(const char * name, uint64_t start, uint64_t end) {
+
+		Ring* ring = GetRing();
+
+		//Only this thread writes the ring, the release hands the entry over to a reader that sees the new count
+		uint64_t written = ring->written.load(std::memory_order_relaxed);
+		ring->events[written % RING_SIZE] = { name, start, end };
+		ring->written.store(written + 1, std::memory_order_release);
+
+	}
+
+	void Profiler::Clear() {
+
+		std::lock_guard<std::mutex> lock(s_RingMutex);
+		for(auto& ring : s_Rings)
+			ring->written.store(0, std::memory_order_relaxed);
+
+	}
+
+	uint64_t Profiler::GetRecordedCount() {
+
+		std::lock_guard<std::mutex> lock(s_RingMutex);
+		uint64_t total = 0;
+		for(auto& ring : s_Rings)
+			total += ring->written.load(std::memory_order_acquire);
+		return total;
+
+	}
+
+	void Profiler::Collect(std::vector<ProfileEvent>& events, std::vector<uint32_t>& threads) {
+
+		std::lock_guard<std::mutex> lock(s_RingMutex);
+
+		for(auto& ring : s_Rings) {
+			uint64_t written = ring->written.load(std::memory_order_acquire);
+			uint64_t first = (written > RING_SIZE) ? written - RING_SIZE : 0;
+			for(uint64_t i = first; i < written; i++) {
+				events.push_back(ring->events[i % RING_SIZE]);
+				threads.push_back(ring->thread);
+			}
+		}
+
+	}
+
+	bool Profiler::WriteChromeTrace(const char * path) {
+
+		std::vector<ProfileEvent> events;
+		std::vector<uint32_t> threads;
+		Collect(events, threads);
+
+		FILE* out = fopen(path, "w");
+		if(out == nullptr)	return false;
+
+		//Timestamps are microseconds from the earliest zone so the trace opens at zero
+		uint64_t origin = UINT64_MAX;
+		uint32_t threadCount = 0;
+		for(size_t i = 0; i < events.size(); i++) {
+			origin = std::min(origin, events[i].start);
+			threadCount = std::max(threadCount, threads[i] + 1);
+		}
+
+		fprintf(out, "{\"traceEvents\":[\n");
+		fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Physics\"}}");
+		for(uint32_t t = 0; t < threadCount; t++)
+			fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", t, t);
+		for(size_t i = 0; i < events.size(); i++) {
+			const ProfileEvent& event = events[i];
+			fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"physics\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				event.name, threads[i], (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+		}
+		fprintf(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+		return fclose(out) == 0;
+
+	}
+
+	Profiler::Ring* Profiler::GetRing() {
+
+		if(t_Ring != nullptr)	return (Ring*)t_Ring;
+
+		std::lock_guard<std::mutex> lock(s_RingMutex);
+		std::unique_ptr<Ring> ring(new Ring());
+		ring->thread = (uint32_t)s_Rings.size();
+		ring->events.reset(new ProfileEvent[RING_SIZE]);
+		ring->written.store(0, std::memory_order_relaxed);
+		t_Ring = ring.get();
+		s_Rings.push_back(std::move(ring));
+
+		return (Ring*)t_Ring;
+
+	}
+
+}
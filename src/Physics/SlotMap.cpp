@@ -0,0 +1,63 @@
+#include "Physics/SlotMap.hpp"
+
+namespace Physics {
+
+	SlotMap::SlotMap() : m_FreeHead(FREE) {
+	}
+
+	SlotMap::~SlotMap() {
+	}
+
+	Handle SlotMap::Insert() {
+
+		uint32_t slot;
+		if(m_FreeHead != FREE) {
+			slot = m_FreeHead;
+			m_FreeHead = m_Slots[slot].nextFree;
+		} else {
+			slot = (uint32_t)m_Slots.size();
+			m_Slots.push_back({ FREE, 0, FREE });
+		}
+
+		m_Slots[slot].dense = (uint32_t)m_DenseToSlot.size();
+		m_DenseToSlot.push_back(slot);
+
+		return { slot, m_Slots[slot].generation };
+
+	}
+
+	void SlotMap::Remove(Handle handle) {
+
+		Slot& removed = m_Slots[handle.slot];
+		uint32_t dense = removed.dense;
+
+		//Last entry takes over the hole
+		uint32_t lastSlot = m_DenseToSlot.back();
+		m_DenseToSlot[dense] = lastSlot;
+		m_Slots[lastSlot].dense = dense;
+		m_DenseToSlot.pop_back();
+
+		//Bumping the generation is what invalidates outstanding handles
+		removed.dense = FREE;
+		removed.generation++;
+		removed.nextFree = m_FreeHead;
+		m_FreeHead = handle.slot;
+
+	}
+
+	void SlotMap::Clear() {
+
+		//Slots are kept so their generations keep counting up, old handles stay invalid
+		m_FreeHead = FREE;
+		for(uint32_t i = (uint32_t)m_Slots.size(); i > 0; i--) {
+			Slot& slot = m_Slots[i - 1];
+			if(slot.dense != FREE)	slot.generation++;
+			slot.dense = FREE;
+			slot.nextFree = m_FreeHead;
+			m_FreeHead = i - 1;
+		}
+		m_DenseToSlot.clear();
+
+	}
+
+}
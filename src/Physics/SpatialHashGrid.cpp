@@ -0,0 +1,368 @@
+#include "Physics/SpatialHashGrid.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Physics {
+
+	const uint64_t SpatialHashGrid::OVERSIZED;
+
+	static const int32_t CELL_BITS = 21;
+	static const int32_t CELL_BIAS = 1 << (CELL_BITS - 1);
+	static const uint64_t CELL_MASK = (1ull << CELL_BITS) - 1;
+
+	//Derived cell sizes are padded slightly so bounds a rounding error wider than the largest still fit in a cell
+	static const float CELL_SIZE_MARGIN = 1.001f;
+	//Colliders more than this many times the average size don't stretch the cells, they're tested as oversized
+	static const float CELL_SIZE_OUTLIER = 4.0f;
+
+	static inline int32_t ToCell(float value, float invCellSize) {
+		//Clamp before converting so far away or invalid positions still land in a valid cell
+		float cell = std::floor(value * invCellSize);
+		if(!(cell > (float)(1 - CELL_BIAS)))	cell = (float)(1 - CELL_BIAS);
+		if(cell > (float)(CELL_BIAS - 2))		cell = (float)(CELL_BIAS - 2);
+		return (int32_t)cell;
+	}
+
+	static inline const std::vector<float>& GetAxis(const Vec3Array& arr, int axis) {
+		return (axis == 0) ? arr.x : (axis == 1) ? arr.y : arr.z;
+	}
+
+	static inline int32_t UnpackAxis(uint64_t key, int axis) {
+		return (int32_t)((key >> (CELL_BITS * (2 - axis))) & CELL_MASK) - CELL_BIAS;
+	}
+
+	SpatialHashGrid::SpatialHashGrid() : m_CellSize(1.0f), m_FixedCellSize(0.0f), m_Dense(false), m_TableMask(0), m_SweepAxis(0) {
+	}
+
+	SpatialHashGrid::~SpatialHashGrid() {
+	}
+
+	void SpatialHashGrid::Update(const BodyStore & bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs) {
+
+		PHYSICS_ZONE("SpatialHashGrid::Update");
+
+		m_CellSize = (m_FixedCellSize > 0.0f) ? m_FixedCellSize : ChooseCellSize(bodies);
+
+		BuildCells(bodies);
+		FindPairs(bodies, pairs);
+
+	}
+
+	float SpatialHashGrid::ChooseCellSize(const BodyStore & bodies) const {
+
+		//Largest sphere diameter, so every ball fits in a cell and only needs the 27 cell scan. Oversized bodies are
+		//tested against every body, so sizing to the average would send every ball above it there. Outliers far
+		//past the average are left out, or a single huge ball would put the whole pit in a few cells
+		const std::vector<float>& radii = bodies.spheres.radius;
+		if(!radii.empty()) {
+			double total = 0.0;
+			float largest = 0.0f;
+			for(auto radius : radii) {
+				total += radius;
+				largest = std::max(largest, radius);
+			}
+			float average = (float)(total / radii.size());
+			return 2.0f * std::min(largest, average * CELL_SIZE_OUTLIER) * CELL_SIZE_MARGIN;
+		}
+
+		//No spheres, the same from each box's longest side
+		const Vec3Array& extents = bodies.boxes.extents;
+		if(extents.Size() > 0) {
+			double total = 0.0;
+			float largest = 0.0f;
+			for(size_t i = 0; i < extents.Size(); i++) {
+				float extent = std::max(extents.x[i], std::max(extents.y[i], extents.z[i]));
+				total += extent;
+				largest = std::max(largest, extent);
+			}
+			float average = (float)(total / extents.Size());
+			return 2.0f * std::min(largest, average * CELL_SIZE_OUTLIER) * CELL_SIZE_MARGIN;
+		}
+
+		return 1.0f;
+
+	}
+
+	void SpatialHashGrid::BuildCells(const BodyStore & bodies) {
+
+		uint32_t count = (uint32_t)bodies.Size();
+		float invCellSize = 1.0f / m_CellSize;
+
+		m_BodyKeys.resize(count);
+		m_Oversized.clear();
+
+		//Key every body by the cell its centre falls in, tracking the range of occupied cells
+		uint32_t cellMin[3] = { ~0u, ~0u, ~0u };
+		uint32_t cellMax[3] = { 0, 0, 0 };
+
+		for(uint32_t i = 0; i < count; i++) {
+
+			float minX = bodies.boundsMin.x[i], minY = bodies.boundsMin.y[i], minZ = bodies.boundsMin.z[i];
+			float maxX = bodies.boundsMax.x[i], maxY = bodies.boundsMax.y[i], maxZ = bodies.boundsMax.z[i];
+
+			if(maxX - minX > m_CellSize || maxY - minY > m_CellSize || maxZ - minZ > m_CellSize) {
+				m_BodyKeys[i] = OVERSIZED;
+				m_Oversized.push_back(i);
+				continue;
+			}
+
+			uint64_t key = PackCell(ToCell((minX + maxX) * 0.5f, invCellSize),
+									ToCell((minY + maxY) * 0.5f, invCellSize),
+									ToCell((minZ + maxZ) * 0.5f, invCellSize));
+			m_BodyKeys[i] = key;
+
+			for(int axis = 0; axis < 3; axis++) {
+				uint32_t cell = (uint32_t)(UnpackAxis(key, axis) + CELL_BIAS);
+				cellMin[axis] = std::min(cellMin[axis], cell);
+				cellMax[axis] = std::max(cellMax[axis], cell);
+			}
+
+		}
+
+		//Roughly a bucket per body. Occupied cells are fewer than bodies, so most buckets hold a single cell
+		uint32_t tableSize = 64;
+		while(tableSize < count)
+			tableSize <<= 1;
+
+		//Pad the occupied box by a cell each side so every neighbour of an occupied cell is inside it too
+		uint64_t volume = 1;
+		for(int axis = 0; axis < 3; axis++) {
+			m_Origin[axis] = (cellMin[axis] <= cellMax[axis]) ? cellMin[axis] - 1 : 0;
+			m_Dims[axis] = (cellMin[axis] <= cellMax[axis]) ? cellMax[axis] - cellMin[axis] + 3 : 1;
+			volume *= m_Dims[axis];
+		}
+
+		m_Dense = volume <= (uint64_t)tableSize * 4;
+		if(m_Dense) {
+			while(tableSize < volume)
+				tableSize <<= 1;
+		}
+		m_TableMask = tableSize - 1;
+
+		for(int axis = 0; axis < 3; axis++) {
+			m_CellMin[axis] = (int32_t)cellMin[axis] - CELL_BIAS;
+			m_CellMax[axis] = (int32_t)cellMax[axis] - CELL_BIAS;
+		}
+
+		SortOversized(bodies);
+
+		m_CellCount.assign(tableSize, 0);
+		m_CellStart.resize(tableSize + 1);
+
+		for(uint32_t i = 0; i < count; i++) {
+			if(m_BodyKeys[i] != OVERSIZED)
+				m_CellCount[HashCell(m_BodyKeys[i])]++;
+		}
+
+		//Prefix sum gives each bucket its first slot
+		uint32_t start = 0;
+		for(uint32_t i = 0; i < tableSize; i++) {
+			m_CellStart[i] = start;
+			start += m_CellCount[i];
+		}
+		m_CellStart[tableSize] = start;
+
+		//Scatter, using the start array as a cursor and then walking it back
+		m_Entries.resize(start);
+		for(uint32_t i = 0; i < count; i++) {
+
+			uint64_t key = m_BodyKeys[i];
+			if(key == OVERSIZED)	continue;
+
+			Entry& entry = m_Entries[m_CellStart[HashCell(key)]++];
+			entry.key = key;
+			entry.body = i;
+			entry.min[0] = bodies.boundsMin.x[i];	entry.min[1] = bodies.boundsMin.y[i];	entry.min[2] = bodies.boundsMin.z[i];
+			entry.max[0] = bodies.boundsMax.x[i];	entry.max[1] = bodies.boundsMax.y[i];	entry.max[2] = bodies.boundsMax.z[i];
+
+		}
+		for(uint32_t i = 0; i < tableSize; i++)
+			m_CellStart[i] -= m_CellCount[i];
+
+	}
+
+	void SpatialHashGrid::FindPairs(const BodyStore & bodies, std::vector<BodyPair>& pairs) const {
+
+		//Walk entries in bucket order so neighbouring bodies hit the same buckets back to back
+		uint32_t entryCount = (uint32_t)m_Entries.size();
+		for(uint32_t s = 0; s < entryCount; s++) {
+
+			uint64_t key = m_Entries[s].key;
+			int32_t cx = UnpackAxis(key, 0), cy = UnpackAxis(key, 1), cz = UnpackAxis(key, 2);
+
+			//The hash keeps z neighbours in consecutive buckets, so each of the 9 rows of the 27 cell
+			//neighbourhood is one contiguous range unless it wraps around the end of the table.
+			//In dense mode buckets follow cell order, so rows before this one only hold earlier slots and are skipped
+			for(int32_t x = cx - 1; x <= cx + 1; x++) {
+				for(int32_t y = cy - 1; y <= cy + 1; y++) {
+
+					if(m_Dense && (x < cx || (x == cx && y < cy)))	continue;
+
+					uint64_t rowFirst = PackCell(x, y, cz - 1);
+					uint32_t bucket = HashCell(rowFirst);
+
+					if(bucket + 2 <= m_TableMask) {
+						ScanRange(s, m_CellStart[bucket], m_CellStart[bucket + 3], rowFirst, pairs);
+					} else {
+						for(uint32_t i = 0; i < 3; i++) {
+							uint32_t wrapped = (bucket + i) & m_TableMask;
+							ScanRange(s, m_CellStart[wrapped], m_CellStart[wrapped + 1], rowFirst, pairs);
+						}
+					}
+
+				}
+			}
+
+		}
+
+		//Oversized bodies against the cells they cover, then against each other with a sweep along the sorted axis
+		for(size_t i = 0; i < m_Oversized.size(); i++) {
+
+			uint32_t big = m_Oversized[i];
+			QueryOversized(bodies, big, pairs);
+
+			const std::vector<float>& mins = GetAxis(bodies.boundsMin, m_SweepAxis);
+			float reach = GetAxis(bodies.boundsMax, m_SweepAxis)[big];
+			for(size_t j = i + 1; j < m_Oversized.size() && mins[m_Oversized[j]] <= reach; j++) {
+				if(bodies.BoundsOverlap(big, m_Oversized[j]))
+					pairs.push_back({ big, m_Oversized[j] });
+			}
+
+		}
+
+	}
+
+	void SpatialHashGrid::QueryOversized(const BodyStore & bodies, uint32_t big, std::vector<BodyPair>& pairs) const {
+
+		if(m_Entries.empty())	return;
+
+		float min[3] = { bodies.boundsMin.x[big], bodies.boundsMin.y[big], bodies.boundsMin.z[big] };
+		float max[3] = { bodies.boundsMax.x[big], bodies.boundsMax.y[big], bodies.boundsMax.z[big] };
+
+		//Bodies in cells are at most a cell across, so any that overlap have their centre within half a cell of the
+		//bounds. Only occupied cells are worth looking in
+		float invCellSize = 1.0f / m_CellSize;
+		float half = m_CellSize * 0.5f;
+		int32_t first[3], last[3];
+		for(int axis = 0; axis < 3; axis++) {
+			first[axis] = std::max(ToCell(min[axis] - half, invCellSize), m_CellMin[axis]);
+			last[axis] = std::min(ToCell(max[axis] + half, invCellSize), m_CellMax[axis]);
+			if(first[axis] > last[axis])	return;
+		}
+
+		//Walls and the like cover more rows than there are entries, reading every entry once is cheaper then
+		uint64_t rows = (uint64_t)(last[0] - first[0] + 1) * (uint64_t)(last[1] - first[1] + 1);
+		uint32_t rowLength = (uint32_t)(last[2] - first[2] + 1);
+		if(rows >= m_Entries.size() || rowLength > m_TableMask) {
+			ScanOversized(big, min, max, 0, (uint32_t)m_Entries.size(), 0, OVERSIZED, pairs);
+			return;
+		}
+
+		//Each z row of cells is a run of consecutive buckets, like the rows of the 27 cell scan
+		for(int32_t x = first[0]; x <= last[0]; x++) {
+			for(int32_t y = first[1]; y <= last[1]; y++) {
+
+				uint64_t rowFirst = PackCell(x, y, first[2]);
+				uint64_t rowLast = PackCell(x, y, last[2]);
+				uint32_t bucket = HashCell(rowFirst);
+
+				if(bucket + rowLength - 1 <= m_TableMask) {
+					ScanOversized(big, min, max, m_CellStart[bucket], m_CellStart[bucket + rowLength], rowFirst, rowLast, pairs);
+				} else {
+					uint32_t wrapped = bucket + rowLength - 1 - m_TableMask;
+					ScanOversized(big, min, max, m_CellStart[bucket], m_CellStart[m_TableMask + 1], rowFirst, rowLast, pairs);
+					ScanOversized(big, min, max, 0, m_CellStart[wrapped], rowFirst, rowLast, pairs);
+				}
+
+			}
+		}
+
+	}
+
+	inline void SpatialHashGrid::ScanOversized(uint32_t big, const float* min, const float* max, uint32_t begin, uint32_t end,
+											   uint64_t keyFirst, uint64_t keyLast, std::vector<BodyPair>& pairs) const {
+
+		for(uint32_t k = begin; k < end; k++) {
+			const Entry& b = m_Entries[k];
+			if(b.key < keyFirst || b.key > keyLast)	continue;
+			if(min[0] <= b.max[0] && max[0] >= b.min[0] &&
+			   min[1] <= b.max[1] && max[1] >= b.min[1] &&
+			   min[2] <= b.max[2] && max[2] >= b.min[2])
+				pairs.push_back({ big, b.body });
+		}
+
+	}
+
+	void SpatialHashGrid::SortOversized(const BodyStore & bodies) {
+
+		if(m_Oversized.size() < 2)	return;
+
+		//Sweep along the axis where the bodies are spread furthest compared to their size, so the fewest overlap on it
+		float best = -1.0f;
+		m_SweepAxis = 0;
+		for(int axis = 0; axis < 3; axis++) {
+			const std::vector<float>& mins = GetAxis(bodies.boundsMin, axis);
+			const std::vector<float>& maxs = GetAxis(bodies.boundsMax, axis);
+			float low = mins[m_Oversized[0]], high = maxs[m_Oversized[0]];
+			double size = 0.0;
+			for(auto big : m_Oversized) {
+				low = std::min(low, mins[big]);
+				high = std::max(high, maxs[big]);
+				size += maxs[big] - mins[big];
+			}
+			float spread = (high - low) / (float)(size / m_Oversized.size() + 1e-6);
+			if(spread > best) {
+				best = spread;
+				m_SweepAxis = axis;
+			}
+		}
+
+		const std::vector<float>& mins = GetAxis(bodies.boundsMin, m_SweepAxis);
+		std::sort(m_Oversized.begin(), m_Oversized.end(), [&mins](uint32_t a, uint32_t b) {
+			return mins[a] < mins[b] || (mins[a] == mins[b] && a < b);
+		});
+
+	}
+
+	inline void SpatialHashGrid::ScanRange(uint32_t slot, uint32_t begin, uint32_t end, uint64_t rowFirst, std::vector<BodyPair>& pairs) const {
+
+		//Buckets can hold other cells that hashed the same way, the key check skips them. Each body sits in exactly
+		//one cell so only reporting pairs with a later slot finds every pair once
+		const Entry& a = m_Entries[slot];
+		uint64_t rowLast = rowFirst + 2;
+
+		for(uint32_t k = (begin > slot) ? begin : slot + 1; k < end; k++) {
+			const Entry& b = m_Entries[k];
+			if(b.key < rowFirst || b.key > rowLast)	continue;
+			if(a.min[0] <= b.max[0] && a.max[0] >= b.min[0] &&
+			   a.min[1] <= b.max[1] && a.max[1] >= b.min[1] &&
+			   a.min[2] <= b.max[2] && a.max[2] >= b.min[2])
+				pairs.push_back({ a.body, b.body });
+		}
+
+	}
+
+	uint64_t SpatialHashGrid::PackCell(int32_t x, int32_t y, int32_t z) {
+
+		return ((uint64_t)(x + CELL_BIAS) << (CELL_BITS * 2)) | ((uint64_t)(y + CELL_BIAS) << CELL_BITS) | (uint64_t)(z + CELL_BIAS);
+
+	}
+
+	inline uint32_t SpatialHashGrid::HashCell(uint64_t key) const {
+
+		uint32_t x = (uint32_t)(key >> (CELL_BITS * 2));
+		uint32_t y = (uint32_t)(key >> CELL_BITS) & (uint32_t)CELL_MASK;
+		uint32_t z = (uint32_t)key & (uint32_t)CELL_MASK;
+
+		if(m_Dense)
+			return ((x - m_Origin[0]) * m_Dims[1] + (y - m_Origin[1])) * m_Dims[2] + (z - m_Origin[2]);
+
+		//x and y are scattered by large primes while z is added as is, so cells along z still land in consecutive buckets
+		return (x * 73856093u + y * 19349663u + z) & m_TableMask;
+
+	}
+
+}
@@ -12,8 +12,8 @@ namespace Physics {
 	SphereCollider::~SphereCollider() {
 	}
 
-	void SphereCollider::Transform(Object * obj) {
-		m_Position = obj->GetPosition();
+	glm::vec3 SphereCollider::GetPosition() const {
+		return (m_Owner != nullptr) ? m_Owner->GetPosition() : glm::vec3(0);
 	}
 
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "Physics/SphereKernel.hpp"
+#include "Physics/BodyStore.hpp"
+
+#include <cmath>
+
+#if PHYSICS_X86
+#include <immintrin.h>
+#endif
+
+namespace Physics {
+
+	static_assert(sizeof(BodyPair) == 2 * sizeof(uint32_t), "Pairs are loaded as packed index pairs");
+
+	//Raw views of the arrays the kernels read
+	struct SphereArrays {
+		const float* px; const float* py; const float* pz;
+		const float* radius;
+		const uint32_t* colliderIndex;
+	};
+
+	//Appends the contact for a pair that overlaps. Every path finishes its hits here, from the same inputs, so the
+	//only arithmetic that has to match across paths is the squared distance, sqrt and division
+	static inline void PushContact(uint32_t a, uint32_t b, float dx, float dy, float dz, float dist, float minDist, std::vector<Contact>& contacts) {
+
+		Contact contact;
+		contact.a = a;
+		contact.b = b;
+
+		//Coincident centres have no direction between them, so pick one instead of dividing by zero
+		float nx = 0.0f, ny = 1.0f, nz = 0.0f;
+		if(dist > 0.0f) {
+			nx = dx / dist;
+			ny = dy / dist;
+			nz = dz / dist;
+		}
+
+		float overlap = minDist - dist;
+		contact.intersection.collisionVector = glm::vec3(nx * overlap, ny * overlap, nz * overlap);
+		contact.intersection.intersectionType = CollisionType::SPHERE2SPHERE;
+		contacts.push_back(contact);
+
+	}
+
+	static void SphereSphereScalar(const SphereArrays& s, const BodyPair* pairs, uint32_t begin, uint32_t end, std::vector<Contact>& contacts) {
+
+		for(uint32_t i = begin; i < end; i++) {
+
+			uint32_t a = pairs[i].a;
+			uint32_t b = pairs[i].b;
+
+			float dx = s.px[b] - s.px[a];
+			float dy = s.py[b] - s.py[a];
+			float dz = s.pz[b] - s.pz[a];
+			float distSq = (dx * dx + dy * dy) + dz * dz;
+			float minDist = s.radius[s.colliderIndex[a]] + s.radius[s.colliderIndex[b]];
+
+			if(!(distSq < minDist * minDist))	continue;
+
+			PushContact(a, b, dx, dy, dz, std::sqrt(distSq), minDist, contacts);
+
+		}
+
+	}
+
+#if PHYSICS_X86
+
+	//Tests 4 pairs per iteration, returns the first pair it did not handle
+	PHYSICS_TARGET_SSE2
+	static uint32_t SphereSphereSSE(const SphereArrays& s, const BodyPair* pairs, uint32_t begin, uint32_t end, std::vector<Contact>& contacts) {
+
+		uint32_t i = begin;
+		for(; i + 4 <= end; i += 4) {
+
+			const BodyPair* p = pairs + i;
+
+			//No gathers before AVX2, so lanes are filled one at a time
+			__m128 ax = _mm_setr_ps(s.px[p[0].a], s.px[p[1].a], s.px[p[2].a], s.px[p[3].a]);
+			__m128 ay = _mm_setr_ps(s.py[p[0].a], s.py[p[1].a], s.py[p[2].a], s.py[p[3].a]);
+			__m128 az = _mm_setr_ps(s.pz[p[0].a], s.pz[p[1].a], s.pz[p[2].a], s.pz[p[3].a]);
+			__m128 bx = _mm_setr_ps(s.px[p[0].b], s.px[p[1].b], s.px[p[2].b], s.px[p[3].b]);
+			__m128 by = _mm_setr_ps(s.py[p[0].b], s.py[p[1].b], s.py[p[2].b], s.py[p[3].b]);
+			__m128 bz = _mm_setr_ps(s.pz[p[0].b], s.pz[p[1].b], s.pz[p[2].b], s.pz[p[3].b]);
+			__m128 ra = _mm_setr_ps(s.radius[s.colliderIndex[p[0].a]], s.radius[s.colliderIndex[p[1].a]],
+									s.radius[s.colliderIndex[p[2].a]], s.radius[s.colliderIndex[p[3].a]]);
+			__m128 rb = _mm_setr_ps(s.radius[s.colliderIndex[p[0].b]], s.radius[s.colliderIndex[p[1].b]],
+									s.radius[s.colliderIndex[p[2].b]], s.radius[s.colliderIndex[p[3].b]]);
+
+			__m128 dx = _mm_sub_ps(bx, ax);
+			__m128 dy = _mm_sub_ps(by, ay);
+			__m128 dz = _mm_sub_ps(bz, az);
+			__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 minDist = _mm_add_ps(ra, rb);
+
+			int hits = _mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_mul_ps(minDist, minDist)));
+			if(hits == 0)	continue;
+
+			alignas(16) float dxs[4], dys[4], dzs[4], dists[4], minDists[4];
+			_mm_store_ps(dxs, dx);
+			_mm_store_ps(dys, dy);
+			_mm_store_ps(dzs, dz);
+			_mm_store_ps(dists, _mm_sqrt_ps(distSq));
+			_mm_store_ps(minDists, minDist);
+
+			for(int lane = 0; lane < 4; lane++) {
+				if(hits & (1 << lane))
+					PushContact(p[lane].a, p[lane].b, dxs[lane], dys[lane], dzs[lane], dists[lane], minDists[lane], contacts);
+			}
+
+		}
+
+		return i;
+
+	}
+
+	//Tests 8 pairs per iteration, returns the first pair it did not handle
+	PHYSICS_TARGET_AVX2
+	static uint32_t SphereSphereAVX2(const SphereArrays& s, const BodyPair* pairs, uint32_t begin, uint32_t end, std::vector<Contact>& contacts) {
+
+		//Pairs arrive as a0 b0 a1 b1 ..., this order puts the a indices in the low half and the b indices in the high
+		const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+		const int* colliderIndex = (const int*)s.colliderIndex;
+
+		uint32_t i = begin;
+		for(; i + 8 <= end; i += 8) {
+
+			__m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(pairs + i)), split);
+			__m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(pairs + i + 4)), split);
+			__m256i ia = _mm256_permute2x128_si256(lo, hi, 0x20);
+			__m256i ib = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+			__m256 ax = _mm256_i32gather_ps(s.px, ia, 4);
+			__m256 ay = _mm256_i32gather_ps(s.py, ia, 4);
+			__m256 az = _mm256_i32gather_ps(s.pz, ia, 4);
+			__m256 bx = _mm256_i32gather_ps(s.px, ib, 4);
+			__m256 by = _mm256_i32gather_ps(s.py, ib, 4);
+			__m256 bz = _mm256_i32gather_ps(s.pz, ib, 4);
+			__m256 ra = _mm256_i32gather_ps(s.radius, _mm256_i32gather_epi32(colliderIndex, ia, 4), 4);
+			__m256 rb = _mm256_i32gather_ps(s.radius, _mm256_i32gather_epi32(colliderIndex, ib, 4), 4);
+
+			__m256 dx = _mm256_sub_ps(bx, ax);
+			__m256 dy = _mm256_sub_ps(by, ay);
+			__m256 dz = _mm256_sub_ps(bz, az);
+			__m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+			__m256 minDist = _mm256_add_ps(ra, rb);
+
+			int hits = _mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_mul_ps(minDist, minDist), _CMP_LT_OQ));
+			if(hits == 0)	continue;
+
+			alignas(32) float dxs[8], dys[8], dzs[8], dists[8], minDists[8];
+			_mm256_store_ps(dxs, dx);
+			_mm256_store_ps(dys, dy);
+			_mm256_store_ps(dzs, dz);
+			_mm256_store_ps(dists, _mm256_sqrt_ps(distSq));
+			_mm256_store_ps(minDists, minDist);
+
+			for(int lane = 0; lane < 8; lane++) {
+				if(hits & (1 << lane))
+					PushContact(pairs[i + lane].a, pairs[i + lane].b, dxs[lane], dys[lane], dzs[lane], dists[lane], minDists[lane], contacts);
+			}
+
+		}
+
+		return i;
+
+	}
+
+#endif
+
+	void SphereSphereBatch(SimdLevel level, const BodyStore & bodies, const BodyPair * pairs, uint32_t count, std::vector<Contact>& contacts) {
+
+		if(count == 0)	return;
+
+		SphereArrays arrays = {
+			bodies.position.x.data(), bodies.position.y.data(), bodies.position.z.data(),
+			bodies.spheres.radius.data(),
+			bodies.colliderIndex.data()
+		};
+
+		if((int)level > (int)GetSupportedSimdLevel())
+			level = GetSupportedSimdLevel();
+
+		uint32_t done = 0;
+
+#if PHYSICS_X86
+		switch(level) {
+			case SimdLevel::AVX2:
+				done = SphereSphereAVX2(arrays, pairs, 0, count, contacts);
+				break;
+			case SimdLevel::SSE:
+				done = SphereSphereSSE(arrays, pairs, 0, count, contacts);
+				break;
+			default:
+				break;
+		}
+#endif
+
+		//Whatever doesn't fill a full vector goes through the scalar path
+		SphereSphereScalar(arrays, pairs, done, count, contacts);
+
+	}
+
+}
@@ -7,12 +7,13 @@
 namespace Physics {
 
 	Spring::Spring(Object * objA, Object * objB) : Constraint(objA, objB, ConstraintType::SPRING),
-	m_Length(5.0f), m_Stiffness(100.0f), m_Friction(1.0f) {
+	m_Length(5.0f), m_Stiffness(100.0f), m_Friction(1.0f), m_Solver(nullptr), m_Index(0) {
 
 	}
 
 	Spring::Spring(Object * objA, Object * objB, float length, float stiffness, float friction) : 
-	Constraint(objA, objB, ConstraintType::SPRING), m_Length(length), m_Stiffness(stiffness), m_Friction(friction) {
+	Constraint(objA, objB, ConstraintType::SPRING), m_Length(length), m_Stiffness(stiffness), m_Friction(friction),
+	m_Solver(nullptr), m_Index(0) {
 	
 	}
 
@@ -0,0 +1,735 @@
+#include "Physics/SpringSolver.hpp"
+#include "Physics/Spring.hpp"
+#include "Physics/PhysicsObject.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/JobSystem.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <glm/geometric.hpp>
+
+#if PHYSICS_X86
+#include <immintrin.h>
+#endif
+
+namespace Physics {
+
+	//One bit per colour in a body's mask, springs that find them all taken go to the overflow
+	static const uint32_t MAX_COLOURS = 64;
+
+	//A spring between two of these could only wake them, so it is skipped
+	static const uint8_t RESTING_FLAGS = BodyStore::BODY_RIGID | BodyStore::BODY_SLEEPING;
+
+	static const uint32_t NO_NODE = ~0u;
+
+	//Sums each SumBatches batch can produce
+	static const uint32_t PARTIAL_SUMS = 3;
+
+	//Raw views of the arrays the kernels read
+	struct SpringArrays {
+		const uint32_t* bodyA;
+		const uint32_t* bodyB;
+		const float* length;
+		const float* stiffness;
+		const float* friction;
+		const float* px; const float* py; const float* pz;
+		const float* vx; const float* vy; const float* vz;
+	};
+
+	//Pushes a spring's force into its ends. No other spring of the colour touches either body, so nothing here races
+	static inline void Accumulate(BodyStore& bodies, uint32_t a, uint32_t b, float fx, float fy, float fz) {
+
+		if((bodies.flags[a] & RESTING_FLAGS) && (bodies.flags[b] & RESTING_FLAGS))	return;
+
+		if((bodies.flags[a] & BodyStore::BODY_RIGID) == 0) {
+			float invMass = bodies.invMass[a];
+			bodies.acceleration.x[a] += fx * invMass;
+			bodies.acceleration.y[a] += fy * invMass;
+			bodies.acceleration.z[a] += fz * invMass;
+			bodies.Wake(a);
+		}
+
+		if((bodies.flags[b] & BodyStore::BODY_RIGID) == 0) {
+			float invMass = bodies.invMass[b];
+			bodies.acceleration.x[b] -= fx * invMass;
+			bodies.acceleration.y[b] -= fy * invMass;
+			bodies.acceleration.z[b] -= fz * invMass;
+			bodies.Wake(b);
+		}
+
+	}
+
+	//Every path below performs the same operations in the same order so forces match bit for bit. Returns false for
+	//springs at their rest length, or with both ends in one place and so no direction to push in
+	static inline bool SpringForce(const SpringArrays& s, size_t i, float& fx, float& fy, float& fz) {
+
+		uint32_t a = s.bodyA[i];
+		uint32_t b = s.bodyB[i];
+
+		float dx = s.px[b] - s.px[a];
+		float dy = s.py[b] - s.py[a];
+		float dz = s.pz[b] - s.pz[a];
+		float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+		if(!(dist > 0.0f) || dist == s.length[i])	return false;
+
+		//Stretch along the spring, plus friction on the speed the ends are parting at
+		float rvx = s.vx[b] - s.vx[a];
+		float rvy = s.vy[b] - s.vy[a];
+		float rvz = s.vz[b] - s.vz[a];
+		float along = rvx * dx + rvy * dy + rvz * dz;
+		float scale = ((dist - s.length[i]) * s.stiffness[i] + along * s.friction[i]) / dist;
+
+		fx = dx * scale;
+		fy = dy * scale;
+		fz = dz * scale;
+		return true;
+
+	}
+
+#if PHYSICS_X86
+
+	PHYSICS_TARGET_SSE2
+	static inline __m128 Gather(const float* base, const uint32_t* index) {
+		return _mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]]);
+	}
+
+	//Computes 4 springs per iteration and accumulates them one lane at a time, returns the first index it did not handle
+	PHYSICS_TARGET_SSE2
+	static size_t ApplySSE(const SpringArrays& s, BodyStore& bodies, size_t begin, size_t end) {
+
+		const __m128 zero = _mm_setzero_ps();
+
+		size_t i = begin;
+		for(; i + 4 <= end; i += 4) {
+
+			const uint32_t* a = s.bodyA + i;
+			const uint32_t* b = s.bodyB + i;
+
+			__m128 dx = _mm_sub_ps(Gather(s.px, b), Gather(s.px, a));
+			__m128 dy = _mm_sub_ps(Gather(s.py, b), Gather(s.py, a));
+			__m128 dz = _mm_sub_ps(Gather(s.pz, b), Gather(s.pz, a));
+			__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+
+			__m128 rvx = _mm_sub_ps(Gather(s.vx, b), Gather(s.vx, a));
+			__m128 rvy = _mm_sub_ps(Gather(s.vy, b), Gather(s.vy, a));
+			__m128 rvz = _mm_sub_ps(Gather(s.vz, b), Gather(s.vz, a));
+			__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rvx, dx), _mm_mul_ps(rvy, dy)), _mm_mul_ps(rvz, dz));
+
+			__m128 length = _mm_loadu_ps(s.length + i);
+			__m128 scale = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(dist, length), _mm_loadu_ps(s.stiffness + i)),
+												 _mm_mul_ps(along, _mm_loadu_ps(s.friction + i))), dist);
+			int active = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(dist, zero), _mm_cmpneq_ps(dist, length)));
+			if(active == 0)	continue;
+
+			alignas(16) float fx[4], fy[4], fz[4];
+			_mm_store_ps(fx, _mm_mul_ps(dx, scale));
+			_mm_store_ps(fy, _mm_mul_ps(dy, scale));
+			_mm_store_ps(fz, _mm_mul_ps(dz, scale));
+
+			for(int lane = 0; lane < 4; lane++) {
+				if(active & (1 << lane))
+					Accumulate(bodies, a[lane], b[lane], fx[lane], fy[lane], fz[lane]);
+			}
+
+		}
+
+		return i;
+
+	}
+
+	//Computes 8 springs per iteration and accumulates them one lane at a time, returns the first index it did not handle
+	PHYSICS_TARGET_AVX2
+	static size_t ApplyAVX2(const SpringArrays& s, BodyStore& bodies, size_t begin, size_t end) {
+
+		const __m256 zero = _mm256_setzero_ps();
+
+		size_t i = begin;
+		for(; i + 8 <= end; i += 8) {
+
+			const uint32_t* a = s.bodyA + i;
+			const uint32_t* b = s.bodyB + i;
+			__m256i indexA = _mm256_loadu_si256((const __m256i*)a);
+			__m256i indexB = _mm256_loadu_si256((const __m256i*)b);
+
+			__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(s.px, indexB, 4), _mm256_i32gather_ps(s.px, indexA, 4));
+			__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(s.py, indexB, 4), _mm256_i32gather_ps(s.py, indexA, 4));
+			__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(s.pz, indexB, 4), _mm256_i32gather_ps(s.pz, indexA, 4));
+			__m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+
+			__m256 rvx = _mm256_sub_ps(_mm256_i32gather_ps(s.vx, indexB, 4), _mm256_i32gather_ps(s.vx, indexA, 4));
+			__m256 rvy = _mm256_sub_ps(_mm256_i32gather_ps(s.vy, indexB, 4), _mm256_i32gather_ps(s.vy, indexA, 4));
+			__m256 rvz = _mm256_sub_ps(_mm256_i32gather_ps(s.vz, indexB, 4), _mm256_i32gather_ps(s.vz, indexA, 4));
+			__m256 along = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rvx, dx), _mm256_mul_ps(rvy, dy)), _mm256_mul_ps(rvz, dz));
+
+			__m256 length = _mm256_loadu_ps(s.length + i);
+			__m256 scale = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(dist, length), _mm256_loadu_ps(s.stiffness + i)),
+													   _mm256_mul_ps(along, _mm256_loadu_ps(s.friction + i))), dist);
+			int active = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(dist, zero, _CMP_GT_OQ), _mm256_cmp_ps(dist, length, _CMP_NEQ_UQ)));
+			if(active == 0)	continue;
+
+			alignas(32) float fx[8], fy[8], fz[8];
+			_mm256_store_ps(fx, _mm256_mul_ps(dx, scale));
+			_mm256_store_ps(fy, _mm256_mul_ps(dy, scale));
+			_mm256_store_ps(fz, _mm256_mul_ps(dz, scale));
+
+			for(int lane = 0; lane < 8; lane++) {
+				if(active & (1 << lane))
+					Accumulate(bodies, a[lane], b[lane], fx[lane], fy[lane], fz[lane]);
+			}
+
+		}
+
+		return i;
+
+	}
+
+#endif
+
+	//Whether obj is the body at its index in bodies, rather than detached or attached elsewhere
+	static inline bool IsBody(const BodyStore& bodies, const Object* obj) {
+		return obj != nullptr && obj->IsAttached() && obj->GetIndex() < bodies.Size() && bodies.objects[obj->GetIndex()] == obj;
+	}
+
+	//Adds sign * (k * n * n^T + iso * I), for unit direction n
+	static inline void AddAxial(SymmetricBlock& block, float k, const glm::vec3& n, float iso, float sign) {
+		block.xx += sign * (k * n.x * n.x + iso);
+		block.xy += sign * (k * n.x * n.y);
+		block.xz += sign * (k * n.x * n.z);
+		block.yy += sign * (k * n.y * n.y + iso);
+		block.yz += sign * (k * n.y * n.z);
+		block.zz += sign * (k * n.z * n.z + iso);
+	}
+
+	static inline glm::vec3 MultiplyBlock(const SymmetricBlock& block, const glm::vec3& v) {
+		return glm::vec3(block.xx * v.x + block.xy * v.y + block.xz * v.z,
+						 block.xy * v.x + block.yy * v.y + block.yz * v.z,
+						 block.xz * v.x + block.yz * v.y + block.zz * v.z);
+	}
+
+	//Inverse by cofactors. The inverse of a symmetric matrix is symmetric
+	static inline SymmetricBlock Inverse(const SymmetricBlock& m) {
+
+		float cxx = m.yy * m.zz - m.yz * m.yz;
+		float cxy = m.xz * m.yz - m.xy * m.zz;
+		float cxz = m.xy * m.yz - m.xz * m.yy;
+		float det = m.xx * cxx + m.xy * cxy + m.xz * cxz;
+		if(det == 0.0f)	return SymmetricBlock();
+
+		float inv = 1.0f / det;
+		SymmetricBlock out;
+		out.xx = cxx * inv;
+		out.xy = cxy * inv;
+		out.xz = cxz * inv;
+		out.yy = (m.xx * m.zz - m.xz * m.xz) * inv;
+		out.yz = (m.xy * m.xz - m.xx * m.yz) * inv;
+		out.zz = (m.xx * m.yy - m.xy * m.xy) * inv;
+		return out;
+
+	}
+
+	SpringSolver::SpringSolver() : m_ColourStart(1, 0), m_SystemStale(true), m_LinksStale(true), m_LastIterations(0), m_LastResidual(0.0f),
+		m_SimdLevel(GetSupportedSimdLevel()) {
+	}
+
+	SpringSolver::~SpringSolver() {
+	}
+
+	void SpringSolver::SetSimdLevel(SimdLevel level) {
+		m_SimdLevel = ((int)level <= (int)GetSupportedSimdLevel()) ? level : GetSupportedSimdLevel();
+	}
+
+	void SpringSolver::Build(const BodyStore & bodies, const std::vector<Constraint*>& constraints, std::vector<Constraint*>& loose) {
+
+		PHYSICS_ZONE("SpringSolver::Build");
+
+		loose.clear();
+		m_Packing.clear();
+		m_PackingA.clear();
+		m_PackingB.clear();
+
+		for(auto con : constraints) {
+
+			if(con->GetType() != Constraint::ConstraintType::SPRING) {
+				loose.push_back(con);
+				continue;
+			}
+
+			Spring* spring = (Spring*)con;
+			spring->m_Solver = nullptr;
+
+			Object* objA;
+			Object* objB;
+			spring->GetConnections(&objA, &objB);
+			if(!IsBody(bodies, objA) || !IsBody(bodies, objB) || objA == objB) {
+				loose.push_back(con);
+				continue;
+			}
+
+			m_Packing.push_back(spring);
+			m_PackingA.push_back(objA->GetIndex());
+			m_PackingB.push_back(objB->GetIndex());
+
+		}
+
+		//Greedy colouring in constraint order, so the same springs always get the same colours. Rigid ends are never
+		//written, but whether a body is rigid can change between builds, so every end counts
+		m_BodyColours.assign(bodies.Size(), 0);
+		m_PackingColour.resize(m_Packing.size());
+
+		uint32_t colourCount = 0;
+		uint32_t counts[MAX_COLOURS + 1] = {};
+
+		for(size_t i = 0; i < m_Packing.size(); i++) {
+
+			uint32_t a = m_PackingA[i];
+			uint32_t b = m_PackingB[i];
+
+			uint64_t used = m_BodyColours[a] | m_BodyColours[b];
+			uint32_t colour = MAX_COLOURS;
+			for(uint32_t k = 0; k < MAX_COLOURS; k++) {
+				if((used & (1ull << k)) == 0) {
+					colour = k;
+					break;
+				}
+			}
+
+			if(colour < MAX_COLOURS) {
+				m_BodyColours[a] |= 1ull << colour;
+				m_BodyColours[b] |= 1ull << colour;
+				colourCount = std::max(colourCount, colour + 1);
+			}
+
+			m_PackingColour[i] = colour;
+			counts[colour]++;
+
+		}
+
+		//Colours in use, then the overflow
+		m_ColourStart.assign(colourCount + 2, 0);
+		for(uint32_t k = 0; k < colourCount; k++)
+			m_ColourStart[k + 1] = m_ColourStart[k] + counts[k];
+		m_ColourStart[colourCount + 1] = m_ColourStart[colourCount] + counts[MAX_COLOURS];
+
+		size_t total = m_Packing.size();
+		m_BodyA.resize(total);
+		m_BodyB.resize(total);
+		m_Length.resize(total);
+		m_Stiffness.resize(total);
+		m_Friction.resize(total);
+
+		uint32_t cursor[MAX_COLOURS + 1];
+		for(uint32_t k = 0; k < colourCount; k++)
+			cursor[k] = m_ColourStart[k];
+		cursor[MAX_COLOURS] = m_ColourStart[colourCount];
+
+		for(size_t i = 0; i < total; i++) {
+
+			Spring* spring = m_Packing[i];
+			uint32_t slot = cursor[m_PackingColour[i]]++;
+
+			m_BodyA[slot] = m_PackingA[i];
+			m_BodyB[slot] = m_PackingB[i];
+			m_Length[slot] = spring->GetLength();
+			m_Stiffness[slot] = spring->GetStiffness();
+			m_Friction[slot] = spring->GetFriction();
+
+			spring->m_Solver = this;
+			spring->m_Index = slot;
+
+		}
+
+		m_SystemStale = true;
+
+	}
+
+	void SpringSolver::Apply(BodyStore & bodies, const SpringSolverSettings & settings, JobSystem * jobs) {
+
+		PHYSICS_ZONE("SpringSolver::Apply");
+
+		if(m_BodyA.empty())	return;
+
+		if(settings.integration == SpringIntegration::IMPLICIT) {
+			ApplyImplicit(bodies, settings, jobs);
+			return;
+		}
+
+		ForEachColour(jobs, settings.batchSize, [this, &bodies](uint32_t begin, uint32_t end) { ApplyRange(bodies, begin, end); });
+
+	}
+
+	template<typename Func>
+	void SpringSolver::ForEachColour(JobSystem * jobs, uint32_t batchSize, const Func & func) {
+
+		uint32_t colours = GetColourCount();
+
+		for(uint32_t k = 0; k < colours; k++) {
+
+			uint32_t begin = m_ColourStart[k];
+			uint32_t count = m_ColourStart[k + 1] - begin;
+			if(count == 0)	continue;
+
+			//The overflow has springs sharing bodies, so it stays on this thread
+			if(k + 1 == colours) {
+				func(begin, begin + count);
+				continue;
+			}
+
+			ParallelFor(jobs, count, batchSize, [&func, begin](uint32_t first, uint32_t last, uint32_t thread) {
+				func(begin + first, begin + last);
+			});
+
+		}
+
+	}
+
+	template<typename Func>
+	void SpringSolver::SumBatches(JobSystem * jobs, uint32_t count, uint32_t batchSize, const Func & func, double * sums) {
+
+		if(batchSize == 0)	batchSize = 1;
+		uint32_t batches = (count + batchSize - 1) / batchSize;
+		m_Partials.assign(batches * PARTIAL_SUMS, 0.0);
+
+		ParallelFor(jobs, count, batchSize, [this, &func, batchSize](uint32_t begin, uint32_t end, uint32_t thread) {
+			func(begin, end, &m_Partials[(begin / batchSize) * PARTIAL_SUMS]);
+		});
+
+		for(uint32_t k = 0; k < PARTIAL_SUMS; k++)
+			sums[k] = 0.0;
+		for(uint32_t b = 0; b < batches; b++) {
+			for(uint32_t k = 0; k < PARTIAL_SUMS; k++)
+				sums[k] += m_Partials[b * PARTIAL_SUMS + k];
+		}
+
+	}
+
+	void SpringSolver::BuildSystem(size_t bodyCount) {
+
+		PHYSICS_ZONE("SpringSolver::BuildSystem");
+
+		//Nodes for every body a spring touches, in body order so the solve walks the body arrays forwards
+		m_BodyNode.assign(bodyCount, NO_NODE);
+		for(size_t i = 0; i < m_BodyA.size(); i++) {
+			m_BodyNode[m_BodyA[i]] = 0;
+			m_BodyNode[m_BodyB[i]] = 0;
+		}
+
+		m_NodeBody.clear();
+		for(size_t body = 0; body < bodyCount; body++) {
+			if(m_BodyNode[body] == NO_NODE)	continue;
+			m_BodyNode[body] = (uint32_t)m_NodeBody.size();
+			m_NodeBody.push_back((uint32_t)body);
+		}
+
+		uint32_t nodes = (uint32_t)m_NodeBody.size();
+		uint32_t springs = (uint32_t)m_BodyA.size();
+
+		//A link at each end of every spring
+		m_LinkStart.assign(nodes + 1, 0);
+		for(uint32_t i = 0; i < springs; i++) {
+			m_LinkStart[m_BodyNode[m_BodyA[i]] + 1]++;
+			m_LinkStart[m_BodyNode[m_BodyB[i]] + 1]++;
+		}
+		for(uint32_t n = 0; n < nodes; n++)
+			m_LinkStart[n + 1] += m_LinkStart[n];
+
+		m_LinkNode.resize(m_LinkStart[nodes]);
+		m_LinkSpring.resize(m_LinkStart[nodes]);
+		std::vector<uint32_t> cursor(m_LinkStart.begin(), m_LinkStart.end() - 1);
+		for(uint32_t i = 0; i < springs; i++) {
+			uint32_t a = m_BodyNode[m_BodyA[i]];
+			uint32_t b = m_BodyNode[m_BodyB[i]];
+			m_LinkNode[cursor[a]] = b;
+			m_LinkSpring[cursor[a]++] = i;
+			m_LinkNode[cursor[b]] = a;
+			m_LinkSpring[cursor[b]++] = i;
+		}
+
+		//A block for the diagonal and each neighbour. Springs joining the same two bodies share one
+		m_RowStart.assign(nodes + 1, 0);
+		m_Column.clear();
+		m_Column.reserve(m_LinkNode.size() + nodes);
+		for(uint32_t n = 0; n < nodes; n++) {
+			size_t first = m_Column.size();
+			m_Column.push_back(n);
+			m_Column.insert(m_Column.end(), m_LinkNode.begin() + m_LinkStart[n], m_LinkNode.begin() + m_LinkStart[n + 1]);
+			std::sort(m_Column.begin() + first, m_Column.end());
+			m_Column.erase(std::unique(m_Column.begin() + first, m_Column.end()), m_Column.end());
+			m_RowStart[n + 1] = (uint32_t)m_Column.size();
+		}
+		m_Blocks.resize(m_Column.size());
+
+		auto findBlock = [this](uint32_t row, uint32_t column) {
+			return (uint32_t)(std::lower_bound(m_Column.begin() + m_RowStart[row], m_Column.begin() + m_RowStart[row + 1], column) - m_Column.begin());
+		};
+
+		m_Diagonal.resize(nodes);
+		m_LinkBlock.resize(m_LinkNode.size());
+		for(uint32_t n = 0; n < nodes; n++) {
+			m_Diagonal[n] = findBlock(n, n);
+			for(uint32_t e = m_LinkStart[n]; e < m_LinkStart[n + 1]; e++)
+				m_LinkBlock[e] = findBlock(n, m_LinkNode[e]);
+		}
+
+		RefreshLinks();
+
+		m_Rhs.resize(nodes);
+		m_DeltaV.assign(nodes, glm::vec3(0));
+		m_Residual.resize(nodes);
+		m_Search.resize(nodes);
+		m_Product.resize(nodes);
+		m_Preconditioned.resize(nodes);
+		m_InvDiagonal.resize(nodes);
+		m_Fixed.resize(nodes);
+		m_Pulled.resize(nodes);
+
+		m_SystemStale = false;
+
+	}
+
+	void SpringSolver::RefreshLinks() {
+
+		size_t links = m_LinkSpring.size();
+		m_LinkLength.resize(links);
+		m_LinkStiffness.resize(links);
+		m_LinkFriction.resize(links);
+
+		for(size_t e = 0; e < links; e++) {
+			uint32_t spring = m_LinkSpring[e];
+			m_LinkLength[e] = m_Length[spring];
+			m_LinkStiffness[e] = m_Stiffness[spring];
+			m_LinkFriction[e] = m_Friction[spring];
+		}
+
+		m_LinksStale = false;
+
+	}
+
+	void SpringSolver::ApplyImplicit(BodyStore & bodies, const SpringSolverSettings & settings, JobSystem * jobs) {
+
+		if(m_SystemStale)
+			BuildSystem(bodies.Size());
+
+		uint32_t nodes = (uint32_t)m_NodeBody.size();
+		uint32_t batchSize = std::max(settings.batchSize, 1u);
+		const float h = settings.timeStep;
+
+		if(m_LinksStale)
+			RefreshLinks();
+
+		//Backward Euler for a velocity change dv: (M - h * df/dv - h^2 * df/dx) dv = h * (f + h * df/dx * v).
+		//Rows only write themselves and only read flags, so they need no colouring
+		ParallelFor(jobs, nodes, batchSize, [this, &bodies, h](uint32_t begin, uint32_t end, uint32_t thread) {
+			PHYSICS_ZONE("Assemble springs");
+			AssembleRows(bodies, h, begin, end);
+		});
+
+		//Sleeping bodies pulled by an awake one are woken, then whatever is still resting is filtered out
+		ParallelFor(jobs, nodes, batchSize, [this, &bodies](uint32_t begin, uint32_t end, uint32_t thread) {
+			for(uint32_t n = begin; n < end; n++) {
+				uint32_t body = m_NodeBody[n];
+				if(m_Pulled[n] && (bodies.flags[body] & BodyStore::BODY_RIGID) == 0)
+					bodies.Wake(body);
+				m_Fixed[n] = (bodies.flags[body] & RESTING_FLAGS) ? 1 : 0;
+				m_InvDiagonal[n] = Inverse(m_Blocks[m_Diagonal[n]]);
+				if(m_Fixed[n])
+					m_DeltaV[n] = glm::vec3(0);
+			}
+		});
+
+		//Preconditioned conjugate gradient, starting from last step's dv
+		PHYSICS_ZONE("Conjugate gradient");
+		ParallelFor(jobs, nodes, batchSize, [this](uint32_t begin, uint32_t end, uint32_t thread) {
+			Multiply(m_DeltaV, m_Product, begin, end);
+		});
+
+		double sums[PARTIAL_SUMS];
+		SumBatches(jobs, nodes, batchSize, [this](uint32_t begin, uint32_t end, double* partial) {
+			for(uint32_t n = begin; n < end; n++) {
+				if(m_Fixed[n]) {
+					m_Residual[n] = glm::vec3(0);
+					m_Preconditioned[n] = glm::vec3(0);
+					m_Search[n] = glm::vec3(0);
+					continue;
+				}
+				m_Residual[n] = m_Rhs[n] - m_Product[n];
+				m_Preconditioned[n] = MultiplyBlock(m_InvDiagonal[n], m_Residual[n]);
+				m_Search[n] = m_Preconditioned[n];
+				partial[0] += glm::dot(m_Residual[n], m_Preconditioned[n]);
+				partial[1] += glm::dot(m_Residual[n], m_Residual[n]);
+				partial[2] += glm::dot(m_Rhs[n], m_Rhs[n]);
+			}
+		}, sums);
+
+		double rz = sums[0];
+		double rr = sums[1];
+		double bb = sums[2];
+		double target = (double)settings.tolerance * settings.tolerance * bb;
+
+		uint32_t iteration = 0;
+		for(; iteration < settings.maxIterations && rr > target; iteration++) {
+
+			SumBatches(jobs, nodes, batchSize, [this](uint32_t begin, uint32_t end, double* partial) {
+				Multiply(m_Search, m_Product, begin, end);
+				for(uint32_t n = begin; n < end; n++)
+					partial[0] += glm::dot(m_Search[n], m_Product[n]);
+			}, sums);
+
+			//The system is positive definite, anything else is round off at convergence
+			if(!(sums[0] > 0.0))	break;
+			float alpha = (float)(rz / sums[0]);
+
+			SumBatches(jobs, nodes, batchSize, [this, alpha](uint32_t begin, uint32_t end, double* partial) {
+				for(uint32_t n = begin; n < end; n++) {
+					m_DeltaV[n] += m_Search[n] * alpha;
+					m_Residual[n] -= m_Product[n] * alpha;
+					m_Preconditioned[n] = MultiplyBlock(m_InvDiagonal[n], m_Residual[n]);
+					partial[0] += glm::dot(m_Residual[n], m_Preconditioned[n]);
+					partial[1] += glm::dot(m_Residual[n], m_Residual[n]);
+				}
+			}, sums);
+
+			float beta = (float)(sums[0] / rz);
+			rz = sums[0];
+			rr = sums[1];
+
+			ParallelFor(jobs, nodes, batchSize, [this, beta](uint32_t begin, uint32_t end, uint32_t thread) {
+				for(uint32_t n = begin; n < end; n++)
+					m_Search[n] = m_Preconditioned[n] + m_Search[n] * beta;
+			});
+
+		}
+
+		m_LastIterations = iteration;
+		m_LastResidual = (bb > 0.0) ? (float)std::sqrt(rr / bb) : 0.0f;
+
+		//The integrator turns acceleration into velocity over the same step, so dv / h gives exactly dv
+		const float invStep = 1.0f / h;
+		ParallelFor(jobs, nodes, batchSize, [this, &bodies, invStep](uint32_t begin, uint32_t end, uint32_t thread) {
+			for(uint32_t n = begin; n < end; n++) {
+				if(m_Fixed[n])	continue;
+				uint32_t body = m_NodeBody[n];
+				bodies.acceleration.x[body] += m_DeltaV[n].x * invStep;
+				bodies.acceleration.y[body] += m_DeltaV[n].y * invStep;
+				bodies.acceleration.z[body] += m_DeltaV[n].z * invStep;
+			}
+		});
+
+	}
+
+	void SpringSolver::AssembleRows(const BodyStore & bodies, float timeStep, uint32_t begin, uint32_t end) {
+
+		const float h = timeStep;
+
+		for(uint32_t row = begin; row < end; row++) {
+
+			std::fill(m_Blocks.begin() + m_RowStart[row], m_Blocks.begin() + m_RowStart[row + 1], SymmetricBlock());
+
+			//The diagonal is summed locally, it can't alias the neighbour blocks written alongside it
+			uint32_t body = m_NodeBody[row];
+			SymmetricBlock diagonal = SymmetricBlock();
+			diagonal.xx = bodies.mass[body];
+			diagonal.yy = bodies.mass[body];
+			diagonal.zz = bodies.mass[body];
+
+			glm::vec3 position = bodies.position.Get(body);
+			glm::vec3 velocity = bodies.velocity.Get(body);
+			bool resting = (bodies.flags[body] & RESTING_FLAGS) != 0;
+			glm::vec3 rhs(0);
+			uint8_t pulled = 0;
+
+			for(uint32_t e = m_LinkStart[row]; e < m_LinkStart[row + 1]; e++) {
+
+				uint32_t other = m_NodeBody[m_LinkNode[e]];
+				if(resting && (bodies.flags[other] & RESTING_FLAGS))	continue;
+				pulled = 1;
+
+				glm::vec3 d = bodies.position.Get(other) - position;
+				float dist = glm::length(d);
+				if(!(dist > 0.0f))	continue;
+
+				glm::vec3 n = d / dist;
+				glm::vec3 relVelocity = bodies.velocity.Get(other) - velocity;
+				float length = m_LinkLength[e];
+				float stiffness = m_LinkStiffness[e];
+				float friction = m_LinkFriction[e];
+
+				//Force on this end, the same as the explicit path
+				glm::vec3 force = d * (((dist - length) * stiffness + glm::dot(relVelocity, d) * friction) / dist);
+
+				//df/dx is stiffness * (s * I + (1 - s) * n * n^T) with s = 1 - length / dist. A compressed spring would
+				//make the system indefinite, so s is clamped at 0 and it only resists along its axis
+				float s = std::max(1.0f - length / dist, 0.0f);
+				//df/dv is friction * dist * n * n^T
+				float axial = h * friction * dist + h * h * stiffness * (1.0f - s);
+				float iso = h * h * stiffness * s;
+
+				AddAxial(diagonal, axial, n, iso, 1.0f);
+				AddAxial(m_Blocks[m_LinkBlock[e]], axial, n, iso, -1.0f);
+
+				glm::vec3 stiffVelocity = (relVelocity * s + n * (glm::dot(n, relVelocity) * (1.0f - s))) * stiffness;
+				rhs += (force + stiffVelocity * h) * h;
+
+			}
+
+			m_Blocks[m_Diagonal[row]] = diagonal;
+			m_Rhs[row] = rhs;
+			m_Pulled[row] = pulled;
+
+		}
+
+	}
+
+	void SpringSolver::Multiply(const std::vector<glm::vec3>& in, std::vector<glm::vec3>& out, uint32_t begin, uint32_t end) const {
+
+		for(uint32_t n = begin; n < end; n++) {
+
+			if(m_Fixed[n]) {
+				out[n] = glm::vec3(0);
+				continue;
+			}
+
+			//Fixed nodes have nothing in in, so their columns add nothing
+			glm::vec3 sum(0);
+			for(uint32_t k = m_RowStart[n]; k < m_RowStart[n + 1]; k++)
+				sum += MultiplyBlock(m_Blocks[k], in[m_Column[k]]);
+			out[n] = sum;
+
+		}
+
+	}
+
+	void SpringSolver::ApplyRange(BodyStore & bodies, uint32_t begin, uint32_t end) const {
+
+		SpringArrays arrays = {
+			m_BodyA.data(), m_BodyB.data(),
+			m_Length.data(), m_Stiffness.data(), m_Friction.data(),
+			bodies.position.x.data(), bodies.position.y.data(), bodies.position.z.data(),
+			bodies.velocity.x.data(), bodies.velocity.y.data(), bodies.velocity.z.data()
+		};
+
+		size_t done = begin;
+
+#if PHYSICS_X86
+		switch(m_SimdLevel) {
+			case SimdLevel::AVX2:
+				done = ApplyAVX2(arrays, bodies, begin, end);
+				break;
+			case SimdLevel::SSE:
+				done = ApplySSE(arrays, bodies, begin, end);
+				break;
+			default:
+				break;
+		}
+#endif
+
+		//Whatever doesn't fill a full vector goes through the scalar path
+		for(size_t i = done; i < end; i++) {
+			float fx, fy, fz;
+			if(SpringForce(arrays, i, fx, fy, fz))
+				Accumulate(bodies, arrays.bodyA[i], arrays.bodyB[i], fx, fy, fz);
+		}
+
+	}
+
+}
@@ -0,0 +1,194 @@
+#include "Physics/SweepAndPrune.hpp"
+#include "Physics/BodyStore.hpp"
+#include "Physics/Profiler.hpp"
+
+#include <algorithm>
+
+namespace Physics {
+
+	static inline const std::vector<float>& GetAxis(const Vec3Array& arr, int axis) {
+		return (axis == 0) ? arr.x : (axis == 1) ? arr.y : arr.z;
+	}
+
+	//Orders by value, with mins ahead of maxes at equal values so touching bounds count as overlapping
+	static inline bool EndpointLess(float valueA, bool maxA, float valueB, bool maxB) {
+		return valueA < valueB || (valueA == valueB && !maxA && maxB);
+	}
+
+	const uint32_t SweepAndPrune::REMOVED;
+
+	SweepAndPrune::SweepAndPrune() : m_PendingRemoves(0), m_PendingInserts(0) {
+	}
+
+	SweepAndPrune::~SweepAndPrune() {
+	}
+
+	void SweepAndPrune::Insert(const BodyStore & bodies, uint32_t index) {
+
+		//New endpoints go on the end, the next update sorts them into place. Removals since then may have left
+		//endpoints under index, so they get an index of their own
+		uint32_t endpointBody = (uint32_t)m_BodyOf.size();
+		m_BodyOf.push_back(index);
+		m_EndpointOf.push_back(endpointBody);
+
+		for(int axis = 0; axis < 3; axis++) {
+			m_Axes[axis].push_back({ GetAxis(bodies.boundsMin, axis)[index], endpointBody << 1 });
+			m_Axes[axis].push_back({ GetAxis(bodies.boundsMax, axis)[index], (endpointBody << 1) | 1 });
+		}
+
+		m_PendingInserts++;
+
+	}
+
+	void SweepAndPrune::Remove(const BodyStore & bodies, uint32_t index) {
+
+		//The store moves its last body into the freed index
+		uint32_t last = (uint32_t)bodies.Size() - 1;
+
+		m_BodyOf[m_EndpointOf[index]] = REMOVED;
+		if(index != last) {
+			m_EndpointOf[index] = m_EndpointOf[last];
+			m_BodyOf[m_EndpointOf[index]] = index;
+		}
+		m_EndpointOf.pop_back();
+
+		m_Pairs.RemoveBody(index, last);
+		m_PendingRemoves++;
+
+	}
+
+	void SweepAndPrune::Build(const BodyStore & bodies) {
+
+		PHYSICS_ZONE("SweepAndPrune::Build");
+
+		Rebuild(bodies);
+		m_PendingInserts = 0;
+		m_PendingRemoves = 0;
+
+	}
+
+	void SweepAndPrune::Update(const BodyStore & bodies, const std::vector<uint8_t>& movedMask, std::vector<BodyPair>& pairs) {
+
+		PHYSICS_ZONE("SweepAndPrune::Update");
+
+		if(m_PendingInserts * 4 > bodies.Size()) {
+			Rebuild(bodies);
+		} else {
+			for(int axis = 0; axis < 3; axis++) {
+				RefreshValues(bodies, axis);
+				SortAxis(bodies, axis);
+			}
+			if(m_PendingRemoves > 0)
+				ResetBodyMap((uint32_t)bodies.Size());
+		}
+
+		m_PendingInserts = 0;
+		m_PendingRemoves = 0;
+
+		m_Pairs.GetPairs(pairs);
+
+	}
+
+	void SweepAndPrune::RefreshValues(const BodyStore & bodies, int axis) {
+
+		const std::vector<float>& mins = GetAxis(bodies.boundsMin, axis);
+		const std::vector<float>& maxs = GetAxis(bodies.boundsMax, axis);
+
+		auto& endpoints = m_Axes[axis];
+
+		if(m_PendingRemoves == 0) {
+			for(auto& e : endpoints)
+				e.value = e.IsMax() ? maxs[e.GetBody()] : mins[e.GetBody()];
+			return;
+		}
+
+		//Order is kept, so the sort after still only has movement to deal with
+		size_t kept = 0;
+		for(size_t i = 0; i < endpoints.size(); i++) {
+			Endpoint e = endpoints[i];
+			uint32_t body = m_BodyOf[e.GetBody()];
+			if(body == REMOVED)	continue;
+
+			e.data = (body << 1) | (e.data & 1);
+			e.value = e.IsMax() ? maxs[body] : mins[body];
+			endpoints[kept++] = e;
+		}
+		endpoints.resize(kept);
+
+	}
+
+	void SweepAndPrune::SortAxis(const BodyStore & bodies, int axis) {
+
+		auto& endpoints = m_Axes[axis];
+
+		for(size_t i = 1; i < endpoints.size(); i++) {
+
+			Endpoint key = endpoints[i];
+			size_t j = i;
+
+			while(j > 0 && EndpointLess(key.value, key.IsMax(), endpoints[j - 1].value, endpoints[j - 1].IsMax())) {
+
+				const Endpoint& prev = endpoints[j - 1];
+
+				//A min moving below another body's max may start an overlap,
+				//a max moving below another body's min ends one
+				if(!key.IsMax() && prev.IsMax()) {
+					if(bodies.BoundsOverlap(key.GetBody(), prev.GetBody()))
+						m_Pairs.Insert(key.GetBody(), prev.GetBody());
+				} else if(key.IsMax() && !prev.IsMax()) {
+					m_Pairs.Erase(key.GetBody(), prev.GetBody());
+				}
+
+				endpoints[j] = prev;
+				j--;
+			}
+
+			endpoints[j] = key;
+
+		}
+
+	}
+
+	void SweepAndPrune::Rebuild(const BodyStore & bodies) {
+
+		uint32_t count = (uint32_t)bodies.Size();
+
+		for(int axis = 0; axis < 3; axis++) {
+			const std::vector<float>& mins = GetAxis(bodies.boundsMin, axis);
+			const std::vector<float>& maxs = GetAxis(bodies.boundsMax, axis);
+
+			auto& endpoints = m_Axes[axis];
+			endpoints.clear();
+			endpoints.reserve(count * 2);
+			for(uint32_t i = 0; i < count; i++) {
+				endpoints.push_back({ mins[i], i << 1 });
+				endpoints.push_back({ maxs[i], (i << 1) | 1 });
+			}
+
+			std::sort(endpoints.begin(), endpoints.end(),
+				[](const Endpoint& a, const Endpoint& b) { return EndpointLess(a.value, a.IsMax(), b.value, b.IsMax()); });
+		}
+
+		ResetBodyMap(count);
+
+		//Sweeping one axis over a packed pile checks every body in each slab against every other, so the pairs come
+		//from a grid pass instead. It finds the same overlaps, touching included, in close to linear time
+		m_Pairs.Clear();
+		m_SeedPairs.clear();
+		m_SeedGrid.Update(bodies, m_SeedMask, m_SeedPairs);
+		m_Pairs.InsertPairs(m_SeedPairs.data(), m_SeedPairs.size());
+
+	}
+
+	void SweepAndPrune::ResetBodyMap(uint32_t count) {
+
+		m_BodyOf.resize(count);
+		m_EndpointOf.resize(count);
+		for(uint32_t i = 0; i < count; i++) {
+			m_BodyOf[i] = i;
+			m_EndpointOf[i] = i;
+		}
+
+	}
+
+}
@@ -23,6 +23,15 @@ namespace Physics {
 
 	}
 
+	void GizmosRenderer::OnObjectRemoved(Object * obj) {
+		m_ObjectRenderInfo.erase(obj);
+	}
+
+	void GizmosRenderer::OnConstraintRemoved(Constraint * con) {
+		if(con->GetType() == Constraint::ConstraintType::SPRING)
+			m_SpringRenderInfo.erase((Spring*)con);
+	}
+
 	void GizmosRenderer::RenderGizmosObjects(Scene * scene) {
 
 		auto& objects = scene->GetObjects();
@@ -40,12 +49,12 @@ namespace Physics {
 			if(collider->GetType() == Collider::ColliderType::SPHERE) {
 				//Cast to Sphere Collider and draw with Gizmos
 				SphereCollider* sc = (SphereCollider*)collider;
-				aie::Gizmos::addSphere(sc->GetPosition(), sc->GetRadius(), 8, 8, color);
+				aie::Gizmos::addSphere(scene->GetInterpolatedPosition(iter), sc->GetRadius(), 8, 8, color);
 			} 
 			//Render AABB
 			else if(collider->GetType() == Collider::ColliderType::AABB) {
 				AABBCollider* ac = (AABBCollider*)collider;
-				aie::Gizmos::addAABBFilled(ac->GetCentre(), ac->GetExtents(), color);
+				aie::Gizmos::addAABBFilled(scene->GetInterpolatedPosition(iter), ac->GetExtents(), color);
 			}
 
 		}
@@ -60,7 +69,7 @@ namespace Physics {
 			iter->GetConnections(&objA, &objB);
 			switch(iter->GetType()) {
 				case Constraint::ConstraintType::SPRING:
-					aie::Gizmos::addLine(objA->GetPosition(), objB->GetPosition(), GetRenderInfo((Spring*)iter)->color);
+					aie::Gizmos::addLine(scene->GetInterpolatedPosition(objA), scene->GetInterpolatedPosition(objB), GetRenderInfo((Spring*)iter)->color);
 					break;
 				case Constraint::ConstraintType::JOINT:
 					//TODO: implement joint drawing
@@ -0,0 +1,28 @@
+#include "Rendering/ImGuiProfileSink.hpp"
+
+#include <imgui.h>
+
+namespace Physics {
+
+	ImGuiProfileSink::ImGuiProfileSink() {
+		for(auto& timing : m_Timings)
+			timing = 0.0;
+	}
+
+	ImGuiProfileSink::~ImGuiProfileSink() {
+	}
+
+	void ImGuiProfileSink::Record(ProfilePhase phase, double milliseconds) {
+		m_Timings[(int)phase] = milliseconds;
+	}
+
+	void ImGuiProfileSink::Draw() {
+
+		ImGui::Begin("Performance");
+		for(int i = 0; i < (int)ProfilePhase::COUNT; i++)
+			ImGui::Text("%s time: %fms", GetPhaseName((ProfilePhase)i), m_Timings[i]);
+		ImGui::End();
+
+	}
+
+}